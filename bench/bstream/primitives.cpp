@@ -0,0 +1,197 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Micro-benchmarks for the sink/source primitives and the small-record
+ * encode/decode loops built on them. Not part of the test suite; build the
+ * bstream_bench target in a release configuration and run it directly.
+ * An optional argument sets the number of records per run.
+ */
+
+#include <bstream/basic_ibstream.h>
+#include <bstream/basic_obstream.h>
+#include <bstream/buffer/sink.h>
+#include <bstream/buffer/source.h>
+#include <bstream/imbstream.h>
+#include <bstream/ombstream.h>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace bstream;
+
+namespace
+{
+
+using bench_clock = std::chrono::steady_clock;
+
+template<class Func>
+void
+run(std::string const& name, std::size_t ops, Func&& func)
+{
+	func();    // warm up caches and buffer growth
+
+	auto start = bench_clock::now();
+	func();
+	auto stop = bench_clock::now();
+
+	double nanos = std::chrono::duration<double, std::nano>(stop - start).count();
+	std::cout << std::left << std::setw(36) << name << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+			  << (nanos / ops) << " ns/op" << std::endl;
+}
+
+volatile std::uint64_t sink_hole = 0;
+
+}    // namespace
+
+int
+main(int argc, char* argv[])
+{
+	std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000UL;
+
+	std::string name{"record"};
+
+	buffer::sink snk{count * 16};
+	run("sink::put", count, [&]() {
+		snk.clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			snk.put(static_cast<util::byte_type>(i));
+		}
+		snk.flush();
+	});
+
+	run("sink::put_num<std::uint32_t>", count, [&]() {
+		snk.clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			snk.put_num(static_cast<std::uint32_t>(i));
+		}
+		snk.flush();
+	});
+
+	std::vector<double> doubles(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		doubles[i] = static_cast<double>(i);
+	}
+
+	buffer::sink dsnk{count * sizeof(double)};
+	run("sink::put_num<double> loop", count, [&]() {
+		dsnk.clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			dsnk.put_num(doubles[i]);
+		}
+		dsnk.flush();
+	});
+
+	run("sink::put_num_array<double>", count, [&]() {
+		dsnk.clear();
+		dsnk.put_num_array(doubles.data(), doubles.size());
+		dsnk.flush();
+	});
+
+	buffer::source<util::const_buffer> dsrc{dsnk.get_buffer()};
+	run("source::get_num_array<double>", count, [&]() {
+		dsrc.rewind();
+		dsrc.get_num_array(doubles.data(), doubles.size());
+	});
+
+	basic_obstream<buffer::sink> bos{get_default_context(), count * 16};
+	run("basic_obstream<buffer::sink>::put", count, [&]() {
+		bos.get_sink().clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			bos.put(static_cast<util::byte_type>(i));
+		}
+	});
+
+	ombstream os{count * 16};
+	run("obstream << small record", count, [&]() {
+		os.clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			os.write_array_header(3);
+			os << static_cast<std::uint32_t>(i) << name << static_cast<double>(i);
+		}
+	});
+
+	basic_obstream<buffer::sink> bos_record{get_default_context(), count * 16};
+	run("basic_obstream << small record", count, [&]() {
+		bos_record.get_sink().clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			bos_record.write_array_header(3);
+			bos_record << static_cast<std::uint32_t>(i) << name << static_cast<double>(i);
+		}
+	});
+
+	auto encoded = os.get_buffer();
+
+	buffer::source<util::const_buffer> src{encoded};
+	run("source::get", count, [&]() {
+		src.rewind();
+		std::uint64_t sum = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			sum += src.get();
+		}
+		sink_hole = sum;
+	});
+
+	imbstream is{encoded};
+	run("ibstream >> small record", count, [&]() {
+		is.rewind();
+		std::uint64_t sum = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			is.check_array_header(3);
+			sum += is.read_as<std::uint32_t>();
+			sum += is.read_as<std::string>().size();
+			sum += static_cast<std::uint64_t>(is.read_as<double>());
+		}
+		sink_hole = sum;
+	});
+
+	basic_ibstream<buffer::source<util::const_buffer>, fixed_byte_order<byte_order::big_endian>> bis{
+			get_default_context(), encoded};
+	run("basic_ibstream >> small record", count, [&]() {
+		bis.rewind();
+		std::uint64_t sum = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			bis.check_array_header(3);
+			sum += bis.read_as<std::uint32_t>();
+			sum += bis.read_as<std::string>().size();
+			sum += static_cast<std::uint64_t>(bis.read_as<double>());
+		}
+		sink_hole = sum;
+	});
+
+	return 0;
+}
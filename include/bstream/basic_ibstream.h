@@ -0,0 +1,329 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_BASIC_IBSTREAM_H
+#define BSTREAM_BASIC_IBSTREAM_H
+
+#include <bstream/ibstream.h>
+#include <bstream/source.h>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+
+namespace bstream
+{
+
+/** Binary input stream bound to a concrete source type
+ *
+ * basic_ibstream is an ibstream whose source type is known at compile time. Its primitive
+ * read operations are bound statically to Source, so their in-buffer paths inline into the
+ * caller. As with basic_obstream, all existing deserializers work unchanged through the
+ * ibstream interface; read_as, the extraction operators and the built-in deserializers
+ * reach the primitives below directly.
+ *
+ * Order selects either the source's byte order (runtime_byte_order) or a compile-time one
+ * (fixed_byte_order<O>), which get_num and load_num then apply with no runtime test.
+ */
+
+template<class Source, class Order = runtime_byte_order>
+class basic_ibstream : public ibstream
+{
+public:
+	static_assert(std::is_base_of<bstream::source, Source>::value, "Source must be derived from bstream::source");
+
+	using source_type = Source;
+	using order_type  = Order;
+
+	basic_ibstream()                      = delete;
+	basic_ibstream(basic_ibstream const&) = delete;
+	basic_ibstream(basic_ibstream&&)      = delete;
+
+	basic_ibstream(std::unique_ptr<Source> source, context_base const& context = get_default_context())
+		: ibstream{std::move(source), context}
+	{
+		if (Order::is_fixed)
+		{
+			m_source->m_reverse = Order::reverse;
+		}
+	}
+
+	template<class... Args, class = std::enable_if_t<std::is_constructible<Source, Args...>::value>>
+	basic_ibstream(context_base const& context, Args&&... args)
+		: basic_ibstream{std::make_unique<Source>(std::forward<Args>(args)...), context}
+	{}
+
+	Source&
+	get_source()
+	{
+		return static_cast<Source&>(*m_source);
+	}
+
+	Source const&
+	get_source() const
+	{
+		return static_cast<Source const&>(*m_source);
+	}
+
+	std::unique_ptr<Source>
+	release_source()
+	{
+		return std::unique_ptr<Source>{static_cast<Source*>(m_source.release())};
+	}
+
+	util::byte_type
+	get()
+	{
+		return get_source().get();
+	}
+
+	util::byte_type
+	get(std::error_code& err)
+	{
+		return get_source().get(err);
+	}
+
+	util::byte_type
+	peek()
+	{
+		return get_source().peek();
+	}
+
+	util::byte_type
+	peek(std::error_code& err)
+	{
+		return get_source().peek(err);
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && sizeof(U) == 1, U>::type
+	get_num()
+	{
+		return static_cast<U>(get());
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && sizeof(U) == 1, U>::type
+	get_num(std::error_code& err)
+	{
+		return static_cast<U>(get(err));
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) > 1), U>::type
+	get_num()
+	{
+		if (Order::is_fixed)
+		{
+			typename detail::canonical_type<sizeof(U)>::type cval;
+			get_source().getn(reinterpret_cast<util::byte_type*>(&cval), sizeof(U));
+			return detail::from_canonical<U>(Order::reverse ? bend::endian_reverse(cval) : cval);
+		}
+		else
+		{
+			return get_source().template get_num<U>();
+		}
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) > 1), U>::type
+	get_num(std::error_code& err)
+	{
+		if (Order::is_fixed)
+		{
+			typename detail::canonical_type<sizeof(U)>::type cval;
+			get_source().getn(reinterpret_cast<util::byte_type*>(&cval), sizeof(U), err);
+			return detail::from_canonical<U>(Order::reverse ? bend::endian_reverse(cval) : cval);
+		}
+		else
+		{
+			return get_source().template get_num<U>(err);
+		}
+	}
+
+	util::size_type
+	getn(util::byte_type* dst, util::size_type nbytes)
+	{
+		return get_source().getn(dst, nbytes);
+	}
+
+	util::size_type
+	getn(util::byte_type* dst, util::size_type nbytes, std::error_code& err)
+	{
+		return get_source().getn(dst, nbytes, err);
+	}
+
+	const util::byte_type*
+	ensure(util::size_type n)
+	{
+		return get_source().ensure(n);
+	}
+
+	const util::byte_type*
+	ensure(util::size_type n, std::error_code& err)
+	{
+		return get_source().ensure(n, err);
+	}
+
+	basic_ibstream&
+	advance(util::size_type k)
+	{
+		get_source().advance(k);
+		return *this;
+	}
+
+	basic_ibstream&
+	advance(util::size_type k, std::error_code& err)
+	{
+		get_source().advance(k, err);
+		return *this;
+	}
+
+	template<class U>
+	typename std::enable_if_t<std::is_arithmetic<U>::value, U>
+	load_num(const util::byte_type* src) const noexcept
+	{
+		if (Order::is_fixed && sizeof(U) > 1)
+		{
+			typename detail::canonical_type<sizeof(U)>::type cval;
+			::memcpy(&cval, src, sizeof(U));
+			return detail::from_canonical<U>(Order::reverse ? bend::endian_reverse(cval) : cval);
+		}
+		else
+		{
+			return get_source().template load_num<U>(src);
+		}
+	}
+
+	using ibstream::read_as;
+
+	template<class T>
+	typename std::enable_if_t<is_ibstream_constructible<T>::value, T>
+	read_as()
+	{
+		return T(*this);
+	}
+
+	template<class T>
+	typename std::enable_if_t<use_value_deserializer<T>::value, T>
+	read_as()
+	{
+		return value_deserializer<T>::get(*this);
+	}
+
+	template<class T>
+	typename std::enable_if_t<use_ref_deserializer<T>::value, T>
+	read_as()
+	{
+		T obj;
+		ref_deserializer<T>::get(*this, obj);
+		return obj;
+	}
+
+	template<class T>
+	typename std::enable_if_t<has_ref_deserializer<T>::value, basic_ibstream&>
+	read_as(T& obj)
+	{
+		ref_deserializer<T>::get(*this, obj);
+		return *this;
+	}
+
+	template<class T>
+	typename std::enable_if_t<
+			!has_ref_deserializer<T>::value && is_ibstream_constructible<T>::value && std::is_assignable<T&, T>::value,
+			basic_ibstream&>
+	read_as(T& obj)
+	{
+		obj = T(*this);
+		return *this;
+	}
+
+	template<class T>
+	typename std::enable_if_t<
+			!has_ref_deserializer<T>::value && !is_ibstream_constructible<T>::value && has_value_deserializer<T>::value
+					&& std::is_assignable<T&, T>::value,
+			basic_ibstream&>
+	read_as(T& obj)
+	{
+		obj = value_deserializer<T>::get(*this);
+		return *this;
+	}
+
+	using ibstream::check_array_header;
+	using ibstream::check_map_header;
+	using ibstream::read_array_header;
+	using ibstream::read_blob_header;
+	using ibstream::read_map_header;
+	using ibstream::read_string_header;
+
+	std::size_t
+	read_string_header()
+	{
+		return decode_string_header(*this);
+	}
+
+	std::size_t
+	read_array_header()
+	{
+		return decode_array_header(*this);
+	}
+
+	std::size_t
+	read_map_header()
+	{
+		return decode_map_header(*this);
+	}
+
+	std::size_t
+	read_blob_header()
+	{
+		return decode_blob_header(*this);
+	}
+
+	basic_ibstream&
+	check_array_header(std::size_t expected)
+	{
+		auto actual = read_array_header();
+		if (actual != expected)
+		{
+			throw std::system_error{make_error_code(bstream::errc::unexpected_array_size)};
+		}
+		return *this;
+	}
+
+	basic_ibstream&
+	check_map_header(std::size_t expected)
+	{
+		auto actual = read_map_header();
+		if (actual != expected)
+		{
+			throw std::system_error{make_error_code(bstream::errc::unexpected_map_size)};
+		}
+		return *this;
+	}
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_BASIC_IBSTREAM_H
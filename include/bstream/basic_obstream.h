@@ -0,0 +1,385 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_BASIC_OBSTREAM_H
+#define BSTREAM_BASIC_OBSTREAM_H
+
+#include <bstream/obstream.h>
+#include <bstream/sink.h>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+
+namespace bstream
+{
+
+/** Binary output stream bound to a concrete sink type
+ *
+ * basic_obstream is an obstream whose sink type is known at compile time. Its primitive
+ * write operations (put, putn, put_num) are resolved statically against Sink, and their
+ * in-buffer paths follow the bookkeeping rules of Policy (see checked_sink_policy and
+ * memory_sink_policy in sink.h). The default policy is selected by default_sink_policy<Sink>.
+ *
+ * Order selects how multi-byte numbers are encoded. With runtime_byte_order (the default), the
+ * sink's byte order applies. With fixed_byte_order<O>, the sink is set to O on construction,
+ * and put_num and store_num encode with a compile-time swap (or none, for native_byte_order).
+ *
+ * basic_obstream is derived from obstream, so all existing serializers work unchanged. The
+ * insertion operators and the built-in serializers are templates on the stream type; inserting
+ * into a basic_obstream reaches its reserve, commit, store_num and header writers directly,
+ * while a serializer that takes obstream& goes through the obstream interface.
+ */
+
+template<class Sink, class Policy = typename default_sink_policy<Sink>::type, class Order = runtime_byte_order>
+class basic_obstream : public obstream
+{
+public:
+	static_assert(std::is_base_of<bstream::sink, Sink>::value, "Sink must be derived from bstream::sink");
+
+	using sink_type   = Sink;
+	using policy_type = Policy;
+	using order_type  = Order;
+
+	basic_obstream()                      = delete;
+	basic_obstream(basic_obstream const&) = delete;
+	basic_obstream(basic_obstream&&)      = delete;
+
+	basic_obstream(std::unique_ptr<Sink> sink, context_base const& context = get_default_context())
+		: obstream{std::move(sink), context}
+	{
+		if (Order::is_fixed)
+		{
+			m_sink->m_reverse = Order::reverse;
+		}
+		m_sink->eager_jumps(Policy::eager_jumps);
+	}
+
+	template<class... Args, class = std::enable_if_t<std::is_constructible<Sink, Args...>::value>>
+	basic_obstream(context_base const& context, Args&&... args)
+		: basic_obstream{std::make_unique<Sink>(std::forward<Args>(args)...), context}
+	{}
+
+	Sink&
+	get_sink()
+	{
+		return static_cast<Sink&>(*m_sink);
+	}
+
+	Sink const&
+	get_sink() const
+	{
+		return static_cast<Sink const&>(*m_sink);
+	}
+
+	std::unique_ptr<Sink>
+	release_sink()
+	{
+		if (m_sink != nullptr)
+		{
+			m_sink->eager_jumps(false);
+		}
+		return std::unique_ptr<Sink>{static_cast<Sink*>(obstream::release_sink().release())};
+	}
+
+protected:
+	/** Writes to sink without owning it; sink must outlive the stream.
+	 */
+	basic_obstream(Sink& sink, context_base const& context) : obstream{sink, context}
+	{
+		if (Order::is_fixed)
+		{
+			m_sink->m_reverse = Order::reverse;
+		}
+		m_sink->eager_jumps(Policy::eager_jumps);
+	}
+
+public:
+	basic_obstream&
+	put(std::uint8_t byte)
+	{
+		bstream::sink& snk = *m_sink;
+		if (jump_pending(snk) || snk.m_next >= snk.m_end)
+		{
+			get_sink().put(byte);
+		}
+		else
+		{
+			mark_dirty(snk);
+			*snk.m_next++ = byte;
+		}
+		return *this;
+	}
+
+	basic_obstream&
+	put(std::uint8_t byte, std::error_code& err)
+	{
+		err.clear();
+		bstream::sink& snk = *m_sink;
+		if (jump_pending(snk) || snk.m_next >= snk.m_end)
+		{
+			get_sink().put(byte, err);
+		}
+		else
+		{
+			mark_dirty(snk);
+			*snk.m_next++ = byte;
+		}
+		return *this;
+	}
+
+	basic_obstream&
+	putn(const void* src, util::size_type nbytes)
+	{
+		bstream::sink& snk = *m_sink;
+		if (jump_pending(snk) || nbytes < 1 || nbytes > static_cast<util::size_type>(snk.m_end - snk.m_next))
+		{
+			get_sink().putn(reinterpret_cast<const util::byte_type*>(src), nbytes);
+		}
+		else
+		{
+			mark_dirty(snk);
+			::memcpy(snk.m_next, src, nbytes);
+			snk.m_next += nbytes;
+		}
+		return *this;
+	}
+
+	basic_obstream&
+	putn(const void* src, util::size_type nbytes, std::error_code& err)
+	{
+		err.clear();
+		bstream::sink& snk = *m_sink;
+		if (jump_pending(snk) || nbytes < 1 || nbytes > static_cast<util::size_type>(snk.m_end - snk.m_next))
+		{
+			get_sink().putn(reinterpret_cast<const util::byte_type*>(src), nbytes, err);
+		}
+		else
+		{
+			mark_dirty(snk);
+			::memcpy(snk.m_next, src, nbytes);
+			snk.m_next += nbytes;
+		}
+		return *this;
+	}
+
+	basic_obstream&
+	putn(util::buffer const& buf)
+	{
+		return putn(buf.data(), buf.size());
+	}
+
+	basic_obstream&
+	putn(util::buffer const& buf, std::error_code& err)
+	{
+		return putn(buf.data(), buf.size(), err);
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && sizeof(U) == 1, basic_obstream&>::type
+	put_num(U value)
+	{
+		return put(static_cast<std::uint8_t>(value));
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && sizeof(U) == 1, basic_obstream&>::type
+	put_num(U value, std::error_code& err)
+	{
+		return put(static_cast<std::uint8_t>(value), err);
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) > 1), basic_obstream&>::type
+	put_num(U value)
+	{
+		if (Order::is_fixed)
+		{
+			auto cval = detail::to_canonical(value);
+			cval      = Order::reverse ? bend::endian_reverse(cval) : cval;
+			putn(&cval, sizeof(U));
+		}
+		else
+		{
+			get_sink().put_num(value);
+		}
+		return *this;
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) > 1), basic_obstream&>::type
+	put_num(U value, std::error_code& err)
+	{
+		if (Order::is_fixed)
+		{
+			auto cval = detail::to_canonical(value);
+			cval      = Order::reverse ? bend::endian_reverse(cval) : cval;
+			putn(&cval, sizeof(U), err);
+		}
+		else
+		{
+			get_sink().put_num(value, err);
+		}
+		return *this;
+	}
+
+	util::byte_type*
+	reserve(util::size_type n)
+	{
+		bstream::sink& snk = *m_sink;
+		if (jump_pending(snk) || n > static_cast<util::size_type>(snk.m_end - snk.m_next))
+		{
+			return get_sink().reserve(n);
+		}
+		return snk.m_next;
+	}
+
+	util::byte_type*
+	reserve(util::size_type n, std::error_code& err)
+	{
+		err.clear();
+		bstream::sink& snk = *m_sink;
+		if (jump_pending(snk) || n > static_cast<util::size_type>(snk.m_end - snk.m_next))
+		{
+			return get_sink().reserve(n, err);
+		}
+		return snk.m_next;
+	}
+
+	basic_obstream&
+	commit(util::size_type k)
+	{
+		bstream::sink& snk = *m_sink;
+		if (snk.m_scratch_window)
+		{
+			get_sink().commit(k);
+		}
+		else if (k > 0)
+		{
+			assert(k <= static_cast<util::size_type>(snk.m_end - snk.m_next));
+			mark_dirty(snk);
+			snk.m_next += k;
+		}
+		return *this;
+	}
+
+	basic_obstream&
+	commit(util::size_type k, std::error_code& err)
+	{
+		err.clear();
+		bstream::sink& snk = *m_sink;
+		if (snk.m_scratch_window)
+		{
+			get_sink().commit(k, err);
+		}
+		else if (k > 0)
+		{
+			assert(k <= static_cast<util::size_type>(snk.m_end - snk.m_next));
+			mark_dirty(snk);
+			snk.m_next += k;
+		}
+		return *this;
+	}
+
+	template<class U>
+	typename std::enable_if_t<std::is_arithmetic<U>::value, util::byte_type*>
+	store_num(util::byte_type* dst, U value) const noexcept
+	{
+		if (Order::is_fixed && sizeof(U) > 1)
+		{
+			auto cval = detail::to_canonical(value);
+			cval      = Order::reverse ? bend::endian_reverse(cval) : cval;
+			::memcpy(dst, &cval, sizeof(U));
+			return dst + sizeof(U);
+		}
+		else
+		{
+			return m_sink->store_num(dst, value);
+		}
+	}
+
+	using obstream::write_array_header;
+	using obstream::write_blob;
+	using obstream::write_blob_header;
+	using obstream::write_map_header;
+
+	basic_obstream&
+	write_map_header(std::uint32_t size)
+	{
+		encode_map_header(*this, size);
+		return *this;
+	}
+
+	basic_obstream&
+	write_array_header(std::uint32_t size)
+	{
+		encode_array_header(*this, size);
+		return *this;
+	}
+
+	basic_obstream&
+	write_blob_header(std::uint32_t size)
+	{
+		encode_blob_header(*this, size);
+		return *this;
+	}
+
+	basic_obstream&
+	write_blob(const void* p, std::size_t size)
+	{
+		write_blob_header(size);
+		putn(p, size);
+		return *this;
+	}
+
+	basic_obstream&
+	write_blob(util::buffer const& buf)
+	{
+		write_blob_header(buf.size());
+		putn(buf.data(), buf.size());
+		return *this;
+	}
+
+private:
+	static bool
+	jump_pending(bstream::sink const& snk) noexcept
+	{
+		assert(!Policy::eager_jumps || !snk.m_did_jump);
+		return !Policy::eager_jumps && snk.m_did_jump;
+	}
+
+	static void
+	mark_dirty(bstream::sink& snk) noexcept
+	{
+		if (!snk.m_dirty)
+		{
+			snk.m_dirty_start = snk.m_next;
+			snk.m_dirty       = true;
+		}
+	}
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_BASIC_OBSTREAM_H
@@ -49,25 +49,78 @@ public:
 
 	friend class detail::sink_test_probe;
 
+	/*
+	 * A sink constructed with an allocator grows its buffer through the allocator, copying
+	 * on each step, and a sink given a buffer that isn't expandable doesn't grow at all.
+	 * Otherwise, the first step moves the output to malloc'd storage, which later steps
+	 * grow with realloc (for large blocks, typically page-table remapping rather than
+	 * copying).
+	 */
+
 	template<class _Alloc>
-	sink(util::size_type size, _Alloc&& alloc, byte_order order = byte_order::big_endian)
-		: base{order}, m_buf{size, std::forward<_Alloc>(alloc)}
+	sink(util::size_type size,
+		 _Alloc&&             alloc,
+		 byte_order           order  = byte_order::big_endian,
+		 growth_policy const& growth = growth_policy{})
+		: base{order},
+		  m_buf{size, std::forward<_Alloc>(alloc)},
+		  m_growth{growth},
+		  m_heap{nullptr},
+		  m_heap_capacity{0},
+		  m_heap_owned{false},
+		  m_heap_huge{false},
+		  m_huge_pages{false},
+		  m_use_heap{false}
 	{
 		reset_ptrs();
 	}
 
-	sink(util::size_type size, byte_order order = byte_order::big_endian) : base{order}, m_buf{size}
+	sink(util::size_type size, byte_order order = byte_order::big_endian, growth_policy const& growth = growth_policy{})
+		: base{order},
+		  m_buf{size},
+		  m_growth{growth},
+		  m_heap{nullptr},
+		  m_heap_capacity{0},
+		  m_heap_owned{false},
+		  m_heap_huge{false},
+		  m_huge_pages{false},
+		  m_use_heap{true}
 	{
 		reset_ptrs();
 	}
 
-	sink(byte_order order) : base{order}, m_buf{BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE} {}
+	sink(byte_order order, growth_policy const& growth = growth_policy{})
+		: base{order},
+		  m_buf{BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE},
+		  m_growth{growth},
+		  m_heap{nullptr},
+		  m_heap_capacity{0},
+		  m_heap_owned{false},
+		  m_heap_huge{false},
+		  m_huge_pages{false},
+		  m_use_heap{true}
+	{
+		reset_ptrs();
+	}
 
-	sink(util::mutable_buffer&& buf, byte_order order = byte_order::big_endian) : base{order}, m_buf{std::move(buf)}
+	sink(util::mutable_buffer&& buf,
+		 byte_order           order  = byte_order::big_endian,
+		 growth_policy const& growth = growth_policy{})
+		: base{order},
+		  m_buf{std::move(buf)},
+		  m_growth{growth},
+		  m_heap{nullptr},
+		  m_heap_capacity{0},
+		  m_heap_owned{false},
+		  m_heap_huge{false},
+		  m_huge_pages{false},
+		  m_use_heap{m_buf.is_expandable()}
 	{
 		reset_ptrs();
 	}
 
+	virtual ~sink();
+
 	sink(sink&&)      = delete;
 	sink(sink const&) = delete;
 	sink&
@@ -92,6 +145,22 @@ public:
 	util::mutable_buffer
 	release_mutable_buffer();
 
+	/** Backs storage allocated from here on, when growth makes it large enough, with
+	 * huge pages (see huge_pages.h).
+	 */
+	sink&
+	huge_pages(bool flag) noexcept
+	{
+		m_huge_pages = flag;
+		return *this;
+	}
+
+	bool
+	huge_pages() const noexcept
+	{
+		return m_huge_pages;
+	}
+
 protected:
 	virtual bool
 	is_valid_position(util::position_type pos) const override;
@@ -99,20 +168,62 @@ protected:
 	virtual void
 	really_overflow(util::size_type, std::error_code& err) override;
 
+	virtual bool
+	can_grow() const override
+	{
+		return m_use_heap || m_buf.is_expandable();
+	}
+
 	void
 	resize(util::size_type size, std::error_code& err);
 
+	/** Hands the heap storage, if any, over to m_buf. Once handed over, the storage
+	 * may be shared by buffers returned to the caller, so growth copies it rather
+	 * than reallocating in place.
+	 */
+	void
+	sync_buffer();
+
+	void
+	free_heap() noexcept;
+
+	util::byte_type*
+	storage() noexcept
+	{
+		return m_heap ? m_heap : m_buf.data();
+	}
+
+	util::size_type
+	capacity() const noexcept
+	{
+		return m_heap ? m_heap_capacity : m_buf.capacity();
+	}
+
 	void
 	reset_ptrs()
 	{
-		util::byte_type* base = m_buf.data();
-		set_ptrs(base, base, base + m_buf.capacity());
+		util::byte_type* base = storage();
+		set_ptrs(base, base, base + capacity());
 	}
 
 	util::mutable_buffer m_buf;
+	growth_policy        m_growth;
+	util::byte_type*     m_heap;             // output storage once grown through realloc, or null
+	util::size_type      m_heap_capacity;
+	bool                 m_heap_owned;       // m_heap not yet handed over to m_buf
+	bool                 m_heap_huge;        // m_heap is from huge_pages::allocate
+	bool                 m_huge_pages;
+	bool                 m_use_heap;         // false if growth must go through m_buf itself
 };
 
 }    // namespace buffer
+
+template<>
+struct default_sink_policy<buffer::sink>
+{
+	using type = memory_sink_policy;
+};
+
 }    // namespace bstream
 
 #endif    // BSTREAM_BUFFER_SINK_H
\ No newline at end of file
@@ -0,0 +1,188 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_BUFFER_CHAIN_H
+#define BSTREAM_BUFFER_CHAIN_H
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <util/buffer.h>
+
+namespace bstream
+{
+
+/** A sequence of shared buffers read as one contiguous byte range.
+ *
+ * Produced by source::get_slice_chain() and ibstream::read_blob_chain(), which
+ * reference every segment the range spans instead of coalescing them into a
+ * single buffer. Empty buffers are never held.
+ */
+class buffer_chain
+{
+public:
+	using segments       = std::deque<util::shared_buffer>;
+	using const_iterator = segments::const_iterator;
+
+	buffer_chain() : m_segments{}, m_size{0} {}
+
+	buffer_chain(util::shared_buffer const& buf) : m_segments{}, m_size{0}
+	{
+		append(buf);
+	}
+
+	buffer_chain(segments&& segs) : m_segments{}, m_size{0}
+	{
+		for (auto& seg : segs)
+		{
+			append(std::move(seg));
+		}
+	}
+
+	buffer_chain&
+	append(util::shared_buffer const& buf)
+	{
+		if (buf.size() > 0)
+		{
+			m_size += buf.size();
+			m_segments.emplace_back(buf);
+		}
+		return *this;
+	}
+
+	buffer_chain&
+	append(util::shared_buffer&& buf)
+	{
+		if (buf.size() > 0)
+		{
+			m_size += buf.size();
+			m_segments.emplace_back(std::move(buf));
+		}
+		return *this;
+	}
+
+	/** Total number of bytes across all segments.
+	 */
+	util::size_type
+	size() const noexcept
+	{
+		return m_size;
+	}
+
+	bool
+	empty() const noexcept
+	{
+		return m_size == 0;
+	}
+
+	util::size_type
+	segment_count() const noexcept
+	{
+		return m_segments.size();
+	}
+
+	util::shared_buffer const&
+	segment(util::size_type index) const
+	{
+		return m_segments[index];
+	}
+
+	const_iterator
+	begin() const noexcept
+	{
+		return m_segments.begin();
+	}
+
+	const_iterator
+	end() const noexcept
+	{
+		return m_segments.end();
+	}
+
+	segments const&
+	get_segments() const noexcept
+	{
+		return m_segments;
+	}
+
+	segments
+	release_segments()
+	{
+		m_size = 0;
+		return std::move(m_segments);
+	}
+
+	void
+	clear() noexcept
+	{
+		m_segments.clear();
+		m_size = 0;
+	}
+
+	/** Copies up to n bytes of the chain, starting at offset, to dst. Returns the
+	 * number of bytes copied.
+	 */
+	util::size_type
+	copy(util::byte_type* dst, util::size_type n, util::size_type offset = 0) const
+	{
+		util::size_type copied = 0;
+		for (auto it = m_segments.begin(); it != m_segments.end() && copied < n; ++it)
+		{
+			if (offset >= it->size())
+			{
+				offset -= it->size();
+				continue;
+			}
+			auto chunk = std::min(it->size() - offset, n - copied);
+			::memcpy(dst + copied, it->data() + offset, chunk);
+			copied += chunk;
+			offset = 0;
+		}
+		return copied;
+	}
+
+	/** Returns the chain as a single buffer. This is free for a chain of one
+	 * segment; longer chains are coalesced into a new buffer.
+	 */
+	util::shared_buffer
+	flatten() const
+	{
+		if (m_segments.size() == 1)
+		{
+			return m_segments.front();
+		}
+		util::mutable_buffer buf{m_size};
+		copy(buf.data(), m_size);
+		buf.size(m_size);
+		return util::shared_buffer{std::move(buf)};
+	}
+
+private:
+	segments        m_segments;
+	util::size_type m_size;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_BUFFER_CHAIN_H
@@ -25,7 +25,12 @@
 #ifndef BSTREAM_BUFSEQ_SINK_H
 #define BSTREAM_BUFSEQ_SINK_H
 
+#include <algorithm>
 #include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <bstream/segment_pool.h>
 #include <bstream/sink.h>
 #include <util/buffer.h>
 
@@ -41,7 +46,40 @@ namespace bufseq
 namespace detail
 {
 class sink_test_probe;
-}
+
+/*
+ * Creates segments of any capacity with the sink's allocator, so segments grown past
+ * the initial capacity come from the same allocator (or pool) as the first.
+ */
+class segment_factory
+{
+public:
+	virtual ~segment_factory() {}
+
+	virtual util::mutable_buffer
+	create(util::size_type capacity) = 0;
+};
+
+template<class Alloc>
+class segment_alloc_factory : public segment_factory
+{
+public:
+	segment_alloc_factory() : m_alloc{} {}
+
+	template<class A>
+	explicit segment_alloc_factory(A&& alloc) : m_alloc{std::forward<A>(alloc)}
+	{}
+
+	virtual util::mutable_buffer
+	create(util::size_type capacity) override
+	{
+		return util::mutable_buffer{capacity, m_alloc};
+	}
+
+private:
+	Alloc m_alloc;
+};
+}    // namespace detail
 
 class sink : public bstream::sink
 {
@@ -57,11 +95,13 @@ public:
 	sink(util::size_type size, _Alloc&& alloc, byte_order order = byte_order::big_endian)
 		: base{order},
 		  m_segment_capacity{size},
+		  m_max_segment_capacity{size},
 		  m_current{0},
 		  m_bufs{},
-		  m_factory{std::make_unique<util::mutable_buffer_alloc_factory<_Alloc>>(size, std::forward<_Alloc>(alloc))}
+		  m_offsets{0},
+		  m_factory{std::make_unique<detail::segment_alloc_factory<std::decay_t<_Alloc>>>(std::forward<_Alloc>(alloc))}
 	{
-		m_bufs.emplace_back(m_factory->create());
+		add_segment();
 		reset_ptrs();
 	}
 
@@ -69,33 +109,88 @@ public:
 	sink(_Alloc&& alloc, byte_order order = byte_order::big_endian)
 		: base{order},
 		  m_segment_capacity{BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE},
+		  m_max_segment_capacity{BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE},
 		  m_current{0},
 		  m_bufs{},
-		  m_factory{std::make_unique<util::mutable_buffer_alloc_factory<_Alloc>>(BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE, std::forward<_Alloc>(alloc))}
+		  m_offsets{0},
+		  m_factory{std::make_unique<detail::segment_alloc_factory<std::decay_t<_Alloc>>>(std::forward<_Alloc>(alloc))}
 	{
-		m_bufs.emplace_back(m_factory->create());
+		add_segment();
+		reset_ptrs();
+	}
+
+	/*
+	 * Segments are drawn from pool, and are returned to it when the sink (or, for
+	 * released buffers, the last reference to each buffer) lets go of them.
+	 */
+	sink(segment_pool& pool, byte_order order = byte_order::big_endian)
+		: base{order},
+		  m_segment_capacity{pool.segment_size()},
+		  m_max_segment_capacity{pool.segment_size()},
+		  m_current{0},
+		  m_bufs{},
+		  m_offsets{0},
+		  m_factory{std::make_unique<detail::segment_alloc_factory<segment_pool_allocator>>(segment_pool_allocator{pool})}
+	{
+		add_segment();
 		reset_ptrs();
 	}
 
 	sink(util::size_type size, byte_order order = byte_order::big_endian)
 		: base{order},
 		  m_segment_capacity{size},
+		  m_max_segment_capacity{size},
 		  m_current{0},
 		  m_bufs{},
-		  m_factory{std::make_unique<util::mutable_buffer_alloc_factory<default_alloc>>(size)}
+		  m_offsets{0},
+		  m_factory{std::make_unique<detail::segment_alloc_factory<default_alloc>>()}
 	{
-		m_bufs.emplace_back(m_factory->create());
+		add_segment();
+		reset_ptrs();
+	}
+
+	/*
+	 * Segments start at initial_size bytes and double in size with each new
+	 * segment, up to max_size. Small streams stay small, while large streams
+	 * need far fewer segments than they would at a fixed size.
+	 */
+	sink(util::size_type initial_size, util::size_type max_size, byte_order order = byte_order::big_endian)
+		: base{order},
+		  m_segment_capacity{initial_size},
+		  m_max_segment_capacity{std::max(initial_size, max_size)},
+		  m_current{0},
+		  m_bufs{},
+		  m_offsets{0},
+		  m_factory{std::make_unique<detail::segment_alloc_factory<default_alloc>>()}
+	{
+		add_segment();
+		reset_ptrs();
+	}
+
+	template<class _Alloc, class = typename std::enable_if_t<std::is_same<typename _Alloc::pointer, util::byte_type*>::value>>
+	sink(util::size_type initial_size, util::size_type max_size, _Alloc&& alloc, byte_order order = byte_order::big_endian)
+		: base{order},
+		  m_segment_capacity{initial_size},
+		  m_max_segment_capacity{std::max(initial_size, max_size)},
+		  m_current{0},
+		  m_bufs{},
+		  m_offsets{0},
+		  m_factory{std::make_unique<detail::segment_alloc_factory<std::decay_t<_Alloc>>>(std::forward<_Alloc>(alloc))}
+	{
+		add_segment();
 		reset_ptrs();
 	}
 
 	sink(byte_order order = byte_order::big_endian)
 		: base{order},
 		  m_segment_capacity{BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE},
+		  m_max_segment_capacity{BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE},
 		  m_current{0},
 		  m_bufs{},
-		  m_factory{std::make_unique<util::mutable_buffer_alloc_factory<default_alloc>>(BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE)}
+		  m_offsets{0},
+		  m_factory{std::make_unique<detail::segment_alloc_factory<default_alloc>>()}
 	{
-		m_bufs.emplace_back(m_factory->create());
+		add_segment();
 		reset_ptrs();
 	}
 
@@ -118,6 +213,17 @@ public:
 	buffers
 	release_buffers();
 
+	/** Writes the sink's contents to fd with writev(), gathering up to IOV_MAX
+	 * segments per call and resuming after partial writes. The contents are
+	 * left in place. Returns the number of bytes written, which falls short
+	 * of size() only on error.
+	 */
+	util::size_type
+	write_to(int fd);
+
+	util::size_type
+	write_to(int fd, std::error_code& err);
+
 protected:
 	/** Sets size of tail buffer based on current high watermark.
 	*
@@ -128,6 +234,38 @@ protected:
 	void
 	locate(util::position_type pos, std::error_code& err);
 
+	/** Returns the index of the segment holding pos; a position on a segment
+	 * boundary belongs to the end of the earlier segment.
+	 */
+	util::size_type
+	segment_index(util::position_type pos) const;
+
+	util::size_type
+	segment_capacity(util::size_type index) const
+	{
+		return static_cast<util::size_type>(m_offsets[index + 1] - m_offsets[index]);
+	}
+
+	util::size_type
+	next_segment_capacity() const
+	{
+		return m_last_capacity == 0 ? m_segment_capacity : std::min(m_last_capacity * 2, m_max_segment_capacity);
+	}
+
+	void
+	add_segment();
+
+	/** Drops all but the first segment, which is left empty, owned and at the
+	 * initial capacity.
+	 */
+	void
+	reset_segments();
+
+	/** Replaces a spliced segment with a private copy before it is written.
+	 */
+	void
+	unshare(util::size_type index);
+
 	virtual bool
 	is_valid_position(util::position_type pos) const override;
 
@@ -137,21 +275,49 @@ protected:
 	virtual void
 	really_overflow(util::size_type, std::error_code& err) override;
 
+	/** splice() appends buf as a segment of its own, without copying it. The current
+	 * segment is closed at the current position, and writing continues in a
+	 * fresh segment following buf. If the current position is not at the end
+	 * of the output (after seeking backward), buf is copied instead.
+	 *
+	 * The sink never writes into buf's storage; a later seek into a spliced
+	 * segment gives that segment a private copy first.
+	 */
+	virtual void
+	really_splice(util::shared_buffer const& buf, std::error_code& err) override;
+
+	/** Drops the segments past the one holding pos.
+	 */
+	virtual void
+	really_truncate(util::position_type pos, std::error_code& err) override;
+
 	void
 	reset_ptrs()
 	{
-		m_base_offset   = m_current * m_segment_capacity;
+		m_base_offset   = m_offsets[m_current];
 		util::byte_type* base = m_bufs[m_current].data();
-		set_ptrs(base, base, base + m_segment_capacity);
+		set_ptrs(base, base, base + segment_capacity(m_current));
 	}
 
-	util::size_type                                     m_segment_capacity;    // capacity of individual buffers
-	util::size_type                                     m_current;             // index of current buffer
+	util::size_type                                     m_segment_capacity;        // capacity of first (or every) buffer
+	util::size_type                                     m_max_segment_capacity;    // cap for geometric growth
+	util::size_type                                     m_current;                 // index of current buffer
 	buffers                                       m_bufs;
-	std::unique_ptr<util::mutable_buffer_factory> m_factory;
+	std::vector<util::position_type>              m_offsets;    // m_offsets[i], m_offsets[i + 1] bound segment i
+	std::unique_ptr<detail::segment_factory>      m_factory;
+	util::size_type                               m_last_capacity = 0;         // capacity of the last allocated segment
+	std::vector<util::size_type>                  m_spliced;                   // indices of segments referring to spliced buffers
+	bool                                          m_has_spliced = false;       // segments no longer uniform in size
 };
 
 }    // namespace bufseq
+
+template<>
+struct default_sink_policy<bufseq::sink>
+{
+	using type = memory_sink_policy;
+};
+
 }    // namespace bstream
 
 #endif    // BSTREAM_BUFSEQ_SINK_H
\ No newline at end of file
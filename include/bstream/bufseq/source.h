@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <bstream/buffer_chain.h>
 #include <bstream/error.h>
 #include <bstream/source.h>
 #include <bstream/types.h>
@@ -250,6 +251,29 @@ public:
 		refresh_offsets();
 	}
 
+	/** In consuming mode the source only moves forward: a segment is dropped
+	 * (with its offset) as soon as reading moves on to the next one, so memory
+	 * is bounded by the segments not yet read. Positions stay absolute, and
+	 * size() still counts every byte appended. Seeking backward or rewinding
+	 * fails with std::errc::invalid_seek.
+	 */
+	source&
+	consuming(bool flag)
+	{
+		m_consuming = flag;
+		if (m_consuming)
+		{
+			release_consumed();
+		}
+		return *this;
+	}
+
+	bool
+	consuming() const
+	{
+		return m_consuming;
+	}
+
 	void
 	append(std::deque<util::shared_buffer>&& bufs);
 
@@ -375,6 +399,12 @@ public:
 	virtual util::const_buffer
 	get_slice(util::size_type n) override;
 
+	virtual buffer_chain
+	get_slice_chain(util::size_type n, std::error_code& err) override;
+
+	virtual buffer_chain
+	get_slice_chain(util::size_type n) override;
+
 	std::deque<util::shared_buffer>
 	get_segmented_slice(util::size_type n);
 
@@ -391,32 +421,22 @@ public:
 	really_seek(util::position_type pos, std::error_code& err) override
 	{
 		err.clear();
-		util::size_type left{0};
-		util::size_type right{m_bufs.size()};
-		bool      found{false};
-		while (left <= right)
+		if (m_consuming && pos < gpos())
 		{
-			auto middle{(left + right) / 2};
-			if (pos < m_offsets[middle])
-			{
-				right = middle - 1;
-			}
-			else if (pos > m_offsets[middle] + m_bufs[middle].size())
-			{
-				left = middle + 1;
-			}
-			else
-			{
-				m_current = middle;
-				found     = true;
-				break;
-			}
+			err = make_error_code(std::errc::invalid_seek);
+			return util::npos;
 		}
-		assert(found);
+		// last segment starting at or before pos; segments may differ in size
+		auto it   = std::upper_bound(m_offsets.begin(), m_offsets.end(), static_cast<util::size_type>(pos));
+		m_current = (it == m_offsets.begin()) ? 0 : static_cast<util::size_type>(it - m_offsets.begin()) - 1;
 		m_base        = m_bufs[m_current].data();
 		m_end         = m_base + m_bufs[m_current].size();
 		m_base_offset = m_offsets[m_current];
 		m_next        = m_base + (pos - m_base_offset);
+		if (m_consuming)
+		{
+			release_consumed();
+		}
 		return pos;
 	}
 
@@ -439,6 +459,10 @@ public:
 			m_base_offset = m_offsets[m_current];
 			m_next        = m_base;
 			result        = m_bufs[m_current].size();
+			if (m_consuming)
+			{
+				release_consumed();
+			}
 		}
 		return result;
 	}
@@ -446,6 +470,10 @@ public:
 	virtual void
 	really_rewind() override
 	{
+		if (m_consuming && gpos() > 0)
+		{
+			throw std::system_error{make_error_code(std::errc::invalid_seek)};
+		}
 		m_current     = 0;
 		m_base        = m_bufs[m_current].data();
 		m_end         = m_base + m_bufs[m_current].size();
@@ -454,10 +482,25 @@ public:
 	}
 
 protected:
+	/** Drops the segments before the current one, keeping offsets absolute
+	 * (unlike trim(), which renumbers positions from zero).
+	 */
+	void
+	release_consumed()
+	{
+		while (m_current > 0)
+		{
+			m_bufs.pop_front();
+			m_offsets.pop_front();
+			--m_current;
+		}
+	}
+
 	std::deque<Buffer>    m_bufs;
 	util::size_type             m_size;
 	util::size_type             m_current;
 	std::deque<util::size_type> m_offsets;
+	bool                        m_consuming = false;
 };
 
 
@@ -576,7 +619,7 @@ source<util::shared_buffer>::get_shared_slice(util::size_type n, std::error_code
 	}
 
 	// If at the end of the segment and more is available, underflow
-	if (m_next == m_end && m_current < m_bufs.size() - 1)
+	if (!window_pending() && m_next == m_end && m_current < m_bufs.size() - 1)
 	{
 		std::error_code err;
 		auto            available = really_underflow(err);
@@ -587,7 +630,7 @@ source<util::shared_buffer>::get_shared_slice(util::size_type n, std::error_code
 		}
 	}
 
-	if (n <= m_end - m_next)
+	if (!m_in_window && n <= m_end - m_next)
 	{
 		result = util::shared_buffer{m_bufs[m_current], static_cast<util::position_type>(m_next - m_base), n, err};
 		if (!err)
@@ -613,7 +656,7 @@ source<util::shared_buffer>::get_shared_slice(util::size_type n)
 	if (n > 0)
 	{
 		// If at the end of the segment and more is available, underflow
-		if (m_next == m_end && n > 0 && m_current < m_bufs.size() - 1)
+		if (!window_pending() && m_next == m_end && m_current < m_bufs.size() - 1)
 		{
 			std::error_code err;
 			auto            available = really_underflow(err);
@@ -627,7 +670,7 @@ source<util::shared_buffer>::get_shared_slice(util::size_type n)
 			}
 		}
 
-		if (n <= m_end - m_next)
+		if (!m_in_window && n <= m_end - m_next)
 		{
 			result = util::shared_buffer{m_bufs[m_current], static_cast<util::position_type>(m_next - m_base), n};
 			gbump(n);
@@ -668,6 +711,20 @@ source<util::shared_buffer>::get_slice(util::size_type n)
 	return base::get_slice(n);
 }
 
+template<class Buffer>
+inline buffer_chain
+source<Buffer>::get_slice_chain(util::size_type n, std::error_code& err)
+{
+	return base::get_slice_chain(n, err);
+}
+
+template<class Buffer>
+inline buffer_chain
+source<Buffer>::get_slice_chain(util::size_type n)
+{
+	return base::get_slice_chain(n);
+}
+
 template<>
 inline std::deque<util::shared_buffer>
 source<util::shared_buffer>::get_segmented_slice(util::size_type n, std::error_code& err)
@@ -675,37 +732,46 @@ source<util::shared_buffer>::get_segmented_slice(util::size_type n, std::error_c
 	err.clear();
 	std::deque<util::shared_buffer> result;
 
-	if (n < 1)
-		goto exit;
-
 	if (n > remaining())
 	{
-		throw std::system_error{make_error_code(bstream::errc::read_past_end_of_stream)};
+		err = make_error_code(bstream::errc::read_past_end_of_stream);
+		goto exit;
 	}
 
-	if (m_next == m_end)
+	if (window_pending())
 	{
-		assert(m_current < m_bufs.size() - 1);
-		assert(remaining() > 0);
-		auto available = really_underflow(err);
+		// bytes stitched together by ensure() no longer live in a segment; copy them
+		auto pending = std::min(n, available());
+		result.emplace_back(base::get_shared_slice(pending, err));
 		if (err)
+			goto exit;
+		n -= pending;
+	}
+
+	while (n > 0)
+	{
+		if (m_next == m_end)
 		{
-			throw std::system_error{err};
+			underflow(err);    // may land on an empty segment; the loop moves past it
+			if (err)
+				goto exit;
 		}
-		if (available < 1)    //  shouldn't happen
+		auto grab = std::min(n, static_cast<util::size_type>(m_end - m_next));
+		if (grab > 0)
 		{
-			throw std::system_error{make_error_code(bstream::errc::read_past_end_of_stream)};
+			result.emplace_back(util::shared_buffer{m_bufs[m_current], static_cast<util::position_type>(m_next - m_base), grab, err});
+			if (err)
+				goto exit;
+			gbump(grab);
+			n -= grab;
 		}
 	}
-	while (n > 0)
+
+exit:
+	if (err)
 	{
-		auto grab = std::min(n, available());
-		result.emplace_back(get_shared_slice(grab, err));
-		if (err)
-			goto exit;
-		n -= grab;
+		result.clear();
 	}
-exit:
 	return result;
 }
 
@@ -760,6 +826,20 @@ source<util::mutable_buffer>::get_segmented_slice(util::size_type n, std::error_
 	return result;
 }
 
+template<>
+inline buffer_chain
+source<util::shared_buffer>::get_slice_chain(util::size_type n, std::error_code& err)
+{
+	return buffer_chain{get_segmented_slice(n, err)};
+}
+
+template<>
+inline buffer_chain
+source<util::shared_buffer>::get_slice_chain(util::size_type n)
+{
+	return buffer_chain{get_segmented_slice(n)};
+}
+
 
 template<>
 inline void
@@ -0,0 +1,48 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_BYTE_SWAP_H
+#define BSTREAM_BYTE_SWAP_H
+
+#include <cstddef>
+#include <util/types.h>
+
+namespace bstream
+{
+namespace detail
+{
+
+/*
+ * Copies count elements of width bytes (2, 4 or 8) from src to dst, reversing the byte
+ * order of each element. The ranges must not overlap, and neither needs to be aligned.
+ * On x86 targets, runs of elements are shuffled with SSSE3 or AVX2, chosen once at run time
+ * according to the capabilities of the processor.
+ */
+void
+reverse_copy(util::byte_type* dst, const util::byte_type* src, util::size_type count, std::size_t width);
+
+}    // namespace detail
+}    // namespace bstream
+
+#endif    // BSTREAM_BYTE_SWAP_H
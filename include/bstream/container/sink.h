@@ -0,0 +1,137 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_CONTAINER_SINK_H
+#define BSTREAM_CONTAINER_SINK_H
+
+#include <algorithm>
+#include <bstream/sink.h>
+#include <string>
+#include <vector>
+
+namespace bstream
+{
+namespace container
+{
+
+/** Sink that writes directly into a caller-owned contiguous container
+ *
+ * Container is a std::vector or std::basic_string of a byte-sized type, for example
+ * std::vector<std::uint8_t> or std::string. Output is appended after the container's
+ * existing contents (which become position 0 of the output sequence) and the container
+ * grows as needed. While writing, the container may hold unwritten slack at its end;
+ * flush(), get_container() and the destructor resize it to exactly the bytes written.
+ *
+ * The container must not be modified through other means while the sink is in use.
+ */
+template<class Container>
+class sink : public bstream::sink
+{
+public:
+	static_assert(sizeof(typename Container::value_type) == 1, "Container elements must be byte-sized");
+
+	using base           = bstream::sink;
+	using container_type = Container;
+
+	sink(Container& container, byte_order order = byte_order::big_endian)
+		: base{order}, m_container{container}, m_origin{container.size()}
+	{
+		reset_ptrs(0);
+	}
+
+	sink(sink&&)      = delete;
+	sink(sink const&) = delete;
+	sink&
+	operator=(sink&&)
+			= delete;
+	sink&
+	operator=(sink const&)
+			= delete;
+
+	virtual ~sink()
+	{
+		m_container.resize(m_origin + really_get_size());
+	}
+
+	Container&
+	get_container()
+	{
+		if (m_dirty)
+		{
+			flush();
+		}
+		auto pos = m_next - m_base;
+		m_container.resize(m_origin + get_high_watermark());
+		reset_ptrs(pos);
+		return m_container;
+	}
+
+protected:
+	virtual bool
+	is_valid_position(util::position_type pos) const override
+	{
+		return pos >= 0;
+	}
+
+	virtual void
+	really_flush(std::error_code& err) override
+	{
+		err.clear();
+		auto pos = m_next - m_base;
+		m_container.resize(m_origin + really_get_size());
+		reset_ptrs(pos);
+	}
+
+	virtual void
+	really_overflow(util::size_type n, std::error_code& err) override
+	{
+		err.clear();
+		auto            pos      = m_next - m_base;
+		util::size_type required = m_origin + pos + n;
+		m_container.resize(std::max<util::size_type>({required, (m_container.size() * 3) / 2, 16}));
+		reset_ptrs(pos);
+	}
+
+	void
+	reset_ptrs(util::position_type pos)
+	{
+		auto base = reinterpret_cast<util::byte_type*>(m_container.data()) + m_origin;
+		set_ptrs(base, base + pos, base + (m_container.size() - m_origin));
+	}
+
+	Container&      m_container;
+	util::size_type m_origin;
+};
+
+}    // namespace container
+
+template<class Container>
+struct default_sink_policy<container::sink<Container>>
+{
+	using type = memory_sink_policy;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_CONTAINER_SINK_H
@@ -49,7 +49,9 @@ public:
 		: m_categories{&std::system_category(), &std::generic_category(), &bstream::error_category(), &util::error_category()},
 		  m_dedup{true},
 		  m_byte_order{byte_order::big_endian},
-		  m_buf_size{65536UL}
+		  m_buf_size{65536UL},
+		  m_growth{},
+		  m_huge_pages{false}
 	{}
 
 	context_options&
@@ -74,11 +76,47 @@ public:
 		return *this;
 	}
 
+	context_options&
+	growth_factor(double factor)
+	{
+		m_growth.factor = factor;
+		return *this;
+	}
+
+	context_options&
+	growth_min_step(util::size_type step)
+	{
+		m_growth.min_step = step;
+		return *this;
+	}
+
+	context_options&
+	growth_max_step(util::size_type step)
+	{
+		m_growth.max_step = step;
+		return *this;
+	}
+
+	/*
+	 * Back large buffers of streams built from the context (ombstream, ofbstream and
+	 * ifbstream) with huge pages; see huge_pages.h. File stream buffers are rounded up
+	 * to a whole huge page; ombstream buffers switch over once growth takes them past
+	 * huge_pages::min_size.
+	 */
+	context_options&
+	huge_pages(bool flag)
+	{
+		m_huge_pages = flag;
+		return *this;
+	}
+
 private:
 	std::vector<const std::error_category*> m_categories;
 	bool                                    m_dedup;
 	enum byte_order                         m_byte_order;
 	util::size_type                               m_buf_size;
+	growth_policy                           m_growth;
+	bool                                    m_huge_pages;
 };
 
 
@@ -97,21 +135,27 @@ public:
 		: util::error_context{std::move(opts.m_categories)},
 		  m_dedup_shared_ptrs{opts.m_dedup},
 		  m_byte_order{opts.m_byte_order},
-		  m_buffer_size{opts.m_buf_size}
+		  m_buffer_size{opts.m_buf_size},
+		  m_growth{opts.m_growth},
+		  m_huge_pages{opts.m_huge_pages}
 	{}
 
 	context_base(context_options const& opts)
 		: util::error_context{opts.m_categories},
 		  m_dedup_shared_ptrs{opts.m_dedup},
 		  m_byte_order{opts.m_byte_order},
-		  m_buffer_size{opts.m_buf_size}
+		  m_buffer_size{opts.m_buf_size},
+		  m_growth{opts.m_growth},
+		  m_huge_pages{opts.m_huge_pages}
 	{}
 
 	context_base(bool dedup_shared_ptrs, byte_order order, util::size_type buffer_size = 65536)
 		: util::error_context{},
 		  m_dedup_shared_ptrs{dedup_shared_ptrs},
 		  m_byte_order{order},
-		  m_buffer_size{buffer_size}
+		  m_buffer_size{buffer_size},
+		  m_growth{},
+		  m_huge_pages{false}
 	{}
 
 	virtual ~context_base() {}
@@ -181,10 +225,24 @@ public:
 		return m_buffer_size;
 	}
 
+	growth_policy const&
+	buffer_growth() const
+	{
+		return m_growth;
+	}
+
+	bool
+	huge_pages() const
+	{
+		return m_huge_pages;
+	}
+
 private:
 	bool            m_dedup_shared_ptrs;
 	enum byte_order m_byte_order;
 	util::size_type       m_buffer_size;
+	growth_policy   m_growth;
+	bool            m_huge_pages;
 };
 
 using poly_raw_factory_func = std::function<void*(ibstream&)>;
@@ -0,0 +1,194 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_FILE_ASYNC_SINK_H
+#define BSTREAM_FILE_ASYNC_SINK_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <bstream/sink.h>
+#include <util/buffer.h>
+
+#ifndef BSTREAM_DEFAULT_FILE_BUFFER_SIZE
+#define BSTREAM_DEFAULT_FILE_BUFFER_SIZE 16384UL
+#endif
+
+#ifndef BSTREAM_DEFAULT_ASYNC_BUFFER_COUNT
+#define BSTREAM_DEFAULT_ASYNC_BUFFER_COUNT 3UL
+#endif
+
+namespace bstream
+{
+namespace file
+{
+
+/** File sink that writes behind the producer on a dedicated I/O thread
+ *
+ * The sink cycles through buffer_count buffers (at least two). When the current
+ * buffer is flushed, whether because it filled up or because the position changed,
+ * it is queued for the I/O thread, which writes it with pwrite() at the position it
+ * was filled from, and writing continues at once in a free buffer. The producer only
+ * waits when every buffer is queued.
+ *
+ * flush() and close() wait for the queued writes to complete. An error from a queued
+ * write is reported by the next flush(), close() or overflow of the internal sequence.
+ *
+ * Since every write carries its own position, open_mode::append positions the sink at
+ * the end of the file (as at_end does) rather than opening it with O_APPEND.
+ */
+class async_sink : public bstream::sink
+{
+public:
+	using base = bstream::sink;
+
+	async_sink(util::size_type buffer_size  = BSTREAM_DEFAULT_FILE_BUFFER_SIZE,
+			   util::size_type buffer_count = BSTREAM_DEFAULT_ASYNC_BUFFER_COUNT,
+			   byte_order      order        = byte_order::big_endian);
+
+	async_sink(std::string const& filename,
+			   open_mode          mode,
+			   std::error_code&   err,
+			   util::size_type    buffer_size  = BSTREAM_DEFAULT_FILE_BUFFER_SIZE,
+			   util::size_type    buffer_count = BSTREAM_DEFAULT_ASYNC_BUFFER_COUNT,
+			   byte_order         order        = byte_order::big_endian);
+
+	async_sink(std::string const& filename,
+			   open_mode          mode         = open_mode::at_begin,
+			   util::size_type    buffer_size  = BSTREAM_DEFAULT_FILE_BUFFER_SIZE,
+			   util::size_type    buffer_count = BSTREAM_DEFAULT_ASYNC_BUFFER_COUNT,
+			   byte_order         order        = byte_order::big_endian);
+
+	async_sink(async_sink&&)      = delete;
+	async_sink(async_sink const&) = delete;
+	async_sink&
+	operator=(async_sink&&)
+			= delete;
+	async_sink&
+	operator=(async_sink const&)
+			= delete;
+
+	virtual ~async_sink();
+
+	void
+	open(std::string const& filename, open_mode mode, std::error_code& err);
+
+	void
+	open(std::string const& filename, open_mode mode);
+
+	bool
+	is_open() const noexcept
+	{
+		return m_is_open;
+	}
+
+	/** Waits for the queued writes, stops the I/O thread and closes the file. The
+	 * file is closed even if a write failed; the first error is reported.
+	 */
+	void
+	close(std::error_code& err);
+
+	void
+	close();
+
+	std::string const&
+	filename() const noexcept
+	{
+		return m_filename;
+	}
+
+	util::size_type
+	buffer_count() const noexcept
+	{
+		return m_bufs.size();
+	}
+
+protected:
+	struct write_request
+	{
+		util::size_type     index;     // of the buffer in m_bufs
+		util::position_type offset;    // in the file
+		util::size_type     length;
+	};
+
+	virtual void
+	really_flush(std::error_code& err) override;
+
+	virtual void
+	really_drain(std::error_code& err) override;
+
+	virtual bool
+	is_valid_position(util::position_type pos) const override;
+
+	virtual void
+	really_jump(std::error_code& err) override;
+
+	virtual void
+	really_overflow(util::size_type n, std::error_code& err) override;
+
+	virtual void
+	really_truncate(util::position_type pos, std::error_code& err) override;
+
+	/** Body of the I/O thread
+	 */
+	void
+	run();
+
+	void
+	write_all(write_request const& req, std::error_code& err);
+
+	void
+	use_buffer(util::size_type index, util::position_type pos)
+	{
+		auto buf_base = m_bufs[index].data();
+		m_current     = index;
+		m_base_offset = pos;
+		set_ptrs(buf_base, buf_base, buf_base + m_buffer_size);
+	}
+
+	std::string                       m_filename;
+	bool                              m_is_open;
+	int                               m_fd;
+	util::size_type                   m_buffer_size;
+	std::vector<util::mutable_buffer> m_bufs;
+	util::size_type                   m_current;    // index of the buffer being filled
+
+	// shared with the I/O thread, guarded by m_mutex
+	std::mutex                   m_mutex;
+	std::condition_variable      m_work_cv;       // signals the I/O thread
+	std::condition_variable      m_done_cv;       // signals the producer
+	std::deque<write_request>    m_pending;       // queued or being written
+	std::vector<util::size_type> m_free;          // indices of idle buffers
+	std::error_code              m_deferred;      // first error from a queued write
+	bool                         m_stop;
+	std::thread                  m_thread;
+};
+
+}    // namespace file
+}    // namespace bstream
+
+#endif    // BSTREAM_FILE_ASYNC_SINK_H
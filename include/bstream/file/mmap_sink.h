@@ -0,0 +1,156 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_FILE_MMAP_SINK_H
+#define BSTREAM_FILE_MMAP_SINK_H
+
+#include <bstream/sink.h>
+#include <string>
+
+#ifndef BSTREAM_DEFAULT_MMAP_GROWTH_STEP
+#define BSTREAM_DEFAULT_MMAP_GROWTH_STEP (4UL * 1024UL * 1024UL)
+#endif
+
+namespace bstream
+{
+namespace file
+{
+
+/** How flush() synchronizes the mapping with the file
+ *
+ * none leaves write-back to the kernel; async schedules it (msync with MS_ASYNC);
+ * sync waits for it (msync with MS_SYNC). Only the pages written since the last
+ * flush are synchronized.
+ */
+enum class map_sync
+{
+	none,
+	async,
+	sync
+};
+
+/** File sink that writes through a shared, writable mapping of the file
+ *
+ * The mapping is the sink's internal sequence, so writes go straight to the page
+ * cache, and changing position is a pointer move rather than a flush and an lseek().
+ * When output reaches the end of the mapping, the file is extended with ftruncate()
+ * and the mapping with mremap(), by at least growth_step bytes (or by half the
+ * current size, if larger). close() trims the file to the size of the output.
+ *
+ * Opening in open_mode::append positions the sink at the end of the file, as at_end
+ * does; seeking backward is still possible.
+ */
+class mmap_sink : public bstream::sink
+{
+public:
+	using base = bstream::sink;
+
+	mmap_sink(map_sync        sync        = map_sync::async,
+			  util::size_type growth_step = BSTREAM_DEFAULT_MMAP_GROWTH_STEP,
+			  byte_order      order       = byte_order::big_endian);
+
+	mmap_sink(std::string const& filename,
+			  open_mode          mode,
+			  std::error_code&   err,
+			  map_sync           sync        = map_sync::async,
+			  util::size_type    growth_step = BSTREAM_DEFAULT_MMAP_GROWTH_STEP,
+			  byte_order         order       = byte_order::big_endian);
+
+	mmap_sink(std::string const& filename,
+			  open_mode          mode        = open_mode::at_begin,
+			  map_sync           sync        = map_sync::async,
+			  util::size_type    growth_step = BSTREAM_DEFAULT_MMAP_GROWTH_STEP,
+			  byte_order         order       = byte_order::big_endian);
+
+	mmap_sink(mmap_sink&&)      = delete;
+	mmap_sink(mmap_sink const&) = delete;
+	mmap_sink&
+	operator=(mmap_sink&&)
+			= delete;
+	mmap_sink&
+	operator=(mmap_sink const&)
+			= delete;
+
+	virtual ~mmap_sink();
+
+	void
+	open(std::string const& filename, open_mode mode, std::error_code& err);
+
+	void
+	open(std::string const& filename, open_mode mode);
+
+	bool
+	is_open() const noexcept
+	{
+		return m_is_open;
+	}
+
+	void
+	close(std::error_code& err);
+
+	void
+	close();
+
+	std::string const&
+	filename() const noexcept
+	{
+		return m_filename;
+	}
+
+	/** Size of the current mapping (and of the file, until close())
+	 */
+	util::size_type
+	capacity() const noexcept
+	{
+		return m_capacity;
+	}
+
+protected:
+	virtual void
+	really_flush(std::error_code& err) override;
+
+	virtual bool
+	is_valid_position(util::position_type pos) const override;
+
+	virtual void
+	really_overflow(util::size_type n, std::error_code& err) override;
+
+	void
+	grow(util::size_type required, std::error_code& err);
+
+	void
+	unmap() noexcept;
+
+	std::string     m_filename;
+	bool            m_is_open;
+	int             m_fd;
+	map_sync        m_sync;
+	util::size_type m_growth_step;
+	util::size_type m_capacity;
+};
+
+}    // namespace file
+}    // namespace bstream
+
+#endif    // BSTREAM_FILE_MMAP_SINK_H
@@ -0,0 +1,119 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_FILE_MMAP_SOURCE_H
+#define BSTREAM_FILE_MMAP_SOURCE_H
+
+#include <bstream/file/source.h>
+#include <util/buffer.h>
+
+namespace bstream
+{
+namespace file
+{
+
+/** Expected access pattern for a mapped file, passed on to madvise()
+ */
+enum class map_advice
+{
+	normal,
+	sequential,
+	random
+};
+
+/** File source that reads from a memory mapping of the whole file
+ *
+ * The file is mapped read-only when it is opened, and the descriptor is closed
+ * immediately. The mapping is the stream's internal sequence, so get() and getn()
+ * read straight from it, seeking only moves a pointer, and nothing is read with
+ * read(). get_slice() and get_shared_slice() return views into the mapping instead
+ * of copies; the mapping stays alive while any view refers to it, even after the
+ * source is closed or destroyed.
+ *
+ * With populate set, the mapping is prefaulted (MAP_POPULATE) where available.
+ *
+ * mmap_source is a file::source, so ifbstream can read through it:
+ *
+ *     ifbstream is{std::make_unique<file::mmap_source>(filename)};
+ *
+ * The file must not be truncated while it is mapped.
+ */
+class mmap_source : public file::source
+{
+public:
+	using base = file::source;
+
+	mmap_source(map_advice advice = map_advice::sequential, bool populate = false, byte_order order = byte_order::big_endian);
+
+	mmap_source(std::string const& filename,
+				std::error_code&   err,
+				map_advice         advice   = map_advice::sequential,
+				bool               populate = false,
+				byte_order         order    = byte_order::big_endian);
+
+	mmap_source(std::string const& filename,
+				map_advice         advice   = map_advice::sequential,
+				bool               populate = false,
+				byte_order         order    = byte_order::big_endian);
+
+	virtual util::shared_buffer
+	get_shared_slice(util::size_type n, std::error_code& err) override;
+
+	virtual util::shared_buffer
+	get_shared_slice(util::size_type n) override;
+
+	virtual util::const_buffer
+	get_slice(util::size_type n, std::error_code& err) override;
+
+	virtual util::const_buffer
+	get_slice(util::size_type n) override;
+
+protected:
+	virtual util::size_type
+	really_underflow(std::error_code& err) override;
+
+	virtual util::size_type
+	really_get_size() const override;
+
+	virtual util::position_type
+	really_seek(util::position_type pos, std::error_code& err) override;
+
+	virtual util::position_type
+	really_get_position() const override;
+
+	virtual void
+	init_open(std::error_code& err) override;
+
+	virtual void
+	really_close(std::error_code& err) override;
+
+	util::shared_buffer m_map;
+	map_advice          m_advice;
+	bool                m_populate;
+};
+
+}    // namespace file
+}    // namespace bstream
+
+#endif    // BSTREAM_FILE_MMAP_SOURCE_H
@@ -0,0 +1,152 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_FILE_PREFETCH_SOURCE_H
+#define BSTREAM_FILE_PREFETCH_SOURCE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <bstream/file/source.h>
+#include <util/buffer.h>
+
+#ifndef BSTREAM_DEFAULT_PREFETCH_BUFFER_COUNT
+#define BSTREAM_DEFAULT_PREFETCH_BUFFER_COUNT 4UL
+#endif
+
+namespace bstream
+{
+namespace file
+{
+
+/** File source that reads ahead on a helper thread
+ *
+ * The source owns buffer_count buffers (at least two). While the stream consumes one
+ * of them, a helper thread fills the others with pread(), in order, from the position
+ * following it, so underflow normally finds the next chunk already read and only
+ * blocks when it has caught up with the helper.
+ *
+ * Seeking within the current chunk moves a pointer. Any other seek discards the chunks
+ * read ahead (a read in progress is discarded when it completes) and redirects the
+ * helper to the new position.
+ *
+ * A read error ends the read-ahead; it is reported when the stream reaches the chunk
+ * that failed.
+ *
+ * prefetch_source is a file::source, so ifbstream can read through it:
+ *
+ *     ifbstream is{std::make_unique<file::prefetch_source>(filename)};
+ */
+class prefetch_source : public file::source
+{
+public:
+	using base = file::source;
+
+	prefetch_source(util::size_type buffer_size  = BSTREAM_DEFAULT_FILE_BUFFER_SIZE,
+					util::size_type buffer_count = BSTREAM_DEFAULT_PREFETCH_BUFFER_COUNT,
+					byte_order      order        = byte_order::big_endian);
+
+	prefetch_source(std::string const& filename,
+					std::error_code&   err,
+					util::size_type    buffer_size  = BSTREAM_DEFAULT_FILE_BUFFER_SIZE,
+					util::size_type    buffer_count = BSTREAM_DEFAULT_PREFETCH_BUFFER_COUNT,
+					byte_order         order        = byte_order::big_endian);
+
+	prefetch_source(std::string const& filename,
+					util::size_type    buffer_size  = BSTREAM_DEFAULT_FILE_BUFFER_SIZE,
+					util::size_type    buffer_count = BSTREAM_DEFAULT_PREFETCH_BUFFER_COUNT,
+					byte_order         order        = byte_order::big_endian);
+
+	virtual ~prefetch_source();
+
+	util::size_type
+	buffer_count() const noexcept
+	{
+		return m_bufs.size();
+	}
+
+protected:
+	static constexpr util::size_type no_buffer = static_cast<util::size_type>(-1);
+
+	struct chunk
+	{
+		util::size_type     index;     // of the buffer in m_bufs
+		util::position_type offset;    // in the file
+		util::size_type     length;
+		std::error_code     err;
+	};
+
+	virtual util::size_type
+	really_underflow(std::error_code& err) override;
+
+	virtual util::position_type
+	really_seek(util::position_type pos, std::error_code& err) override;
+
+	virtual void
+	really_rewind() override;
+
+	virtual void
+	init_open(std::error_code& err) override;
+
+	virtual void
+	really_close(std::error_code& err) override;
+
+	/** Body of the helper thread
+	 */
+	void
+	run();
+
+	util::size_type
+	read_chunk(util::size_type index, util::position_type offset, std::error_code& err);
+
+	/** Discards the chunks read ahead and restarts reading at pos. Expects m_mutex
+	 * to be held.
+	 */
+	void
+	redirect(util::position_type pos);
+
+	util::size_type                   m_buffer_size;
+	std::vector<util::mutable_buffer> m_bufs;
+	util::size_type                   m_current;    // index of the buffer being consumed, or no_buffer
+
+	// shared with the helper thread, guarded by m_mutex
+	std::mutex                   m_mutex;
+	std::condition_variable      m_work_cv;       // signals the helper
+	std::condition_variable      m_ready_cv;      // signals the consumer
+	std::deque<chunk>            m_ready;         // read ahead, in file order
+	std::vector<util::size_type> m_free;          // indices of idle buffers
+	util::position_type          m_read_pos;      // where the helper reads next
+	std::uint64_t                m_generation;    // bumped by redirect()
+	bool                         m_done;          // reached end of file, or failed
+	bool                         m_stop;
+	std::thread                  m_thread;
+};
+
+}    // namespace file
+}    // namespace bstream
+
+#endif    // BSTREAM_FILE_PREFETCH_SOURCE_H
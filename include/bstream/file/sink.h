@@ -143,12 +143,21 @@ public:
 		return m_filename;
 	}
 
+	using base::truncate;
+
 	util::position_type
 	truncate(std::error_code& err);
 
 	util::position_type
 	truncate();
 
+	/** Replaces the I/O buffer with one backed by huge pages if flag is set (see
+	 * huge_pages.h), rounding its size up to a whole number of huge pages. Pending
+	 * output is flushed first.
+	 */
+	void
+	huge_pages(bool flag);
+
 protected:
 	virtual void
 	really_flush(std::error_code& err) override;
@@ -162,6 +171,15 @@ protected:
 	virtual void
 	really_overflow(util::size_type, std::error_code& err) override;
 
+	virtual void
+	really_truncate(util::position_type pos, std::error_code& err) override;
+
+	/** Writes at least a buffer's worth directly from src, together with any
+	 * buffered output, in one writev().
+	 */
+	virtual util::size_type
+	really_write_direct(const util::byte_type* src, util::size_type n, std::error_code& err) override;
+
 private:
 	static bool
 	is_truncate(int flags);
@@ -68,6 +68,17 @@ public:
 	void
 	open(std::string const& filename, int flag_overrides = 0);
 
+	/*
+	 * Reads from an already open descriptor, positioned at the beginning. The source
+	 * takes ownership of fd and closes it in close().
+	 */
+
+	void
+	attach(int fd, std::error_code& err);
+
+	void
+	attach(int fd);
+
 	bool
 	is_open() const noexcept
 	{
@@ -80,6 +91,13 @@ public:
 	void
 	close();
 
+	/** Replaces the I/O buffer with one backed by huge pages if flag is set (see
+	 * huge_pages.h), rounding its size up to a whole number of huge pages. Buffered
+	 * input is carried over.
+	 */
+	void
+	huge_pages(bool flag);
+
 protected:
 	virtual util::size_type
 	really_underflow(std::error_code& err) override;
@@ -93,6 +111,11 @@ protected:
 	virtual util::position_type
 	really_get_position() const override;
 
+	/** Reads at least a buffer's worth with read() straight into dst.
+	 */
+	virtual util::size_type
+	really_read_direct(util::byte_type* dst, util::size_type n, std::error_code& err) override;
+
 protected:
 	util::size_type
 	load_buffer(std::error_code& err);
@@ -107,6 +130,14 @@ protected:
 	void
 	really_open(std::error_code& err);
 
+	/** Takes over the newly opened m_fd: sets m_size and the stream pointers.
+	 */
+	virtual void
+	init_open(std::error_code& err);
+
+	virtual void
+	really_close(std::error_code& err);
+
 	util::mutable_buffer m_buf;
 	std::string          m_filename;
 	bool                 m_is_open;
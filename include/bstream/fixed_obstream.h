@@ -0,0 +1,98 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_FIXED_OBSTREAM_H
+#define BSTREAM_FIXED_OBSTREAM_H
+
+#include <bstream/basic_obstream.h>
+#include <bstream/inline_sink.h>
+#include <memory>
+
+
+namespace bstream
+{
+
+namespace detail
+{
+/*
+ * Holds the sink ahead of the stream base in fixed_obstream, so the sink is
+ * constructed before, and destroyed after, the stream that writes to it. The stream
+ * refers to the sink without owning it.
+ */
+template<std::size_t N>
+struct inline_sink_holder
+{
+	inline_sink_holder(byte_order order) : m_inline_sink{order} {}
+
+	inline_sink<N> m_inline_sink;
+};
+}    // namespace detail
+
+/** Binary output stream over an inline_sink<N>, for small messages
+ *
+ * The sink is stored in the stream object, so encoding a message performs no heap
+ * allocation (provided nothing is written through a shared_ptr with pointer
+ * deduplication enabled). Writes beyond N bytes fail as described for inline_sink.
+ */
+template<std::size_t N>
+class fixed_obstream : private detail::inline_sink_holder<N>, public basic_obstream<inline_sink<N>>
+{
+	using holder = detail::inline_sink_holder<N>;
+
+public:
+	using base = basic_obstream<inline_sink<N>>;
+
+	fixed_obstream(fixed_obstream const&) = delete;
+	fixed_obstream(fixed_obstream&&)      = delete;
+
+	fixed_obstream(context_base const& context = get_default_context())
+		: holder{context.byte_order()}, base{this->m_inline_sink, context}
+	{}
+
+	static constexpr util::size_type
+	capacity() noexcept
+	{
+		return N;
+	}
+
+	const util::byte_type*
+	data() const noexcept
+	{
+		return this->m_inline_sink.data();
+	}
+
+	fixed_obstream&
+	clear() noexcept
+	{
+		this->m_inline_sink.clear();
+		return *this;
+	}
+
+private:
+	using base::release_sink;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_FIXED_OBSTREAM_H
@@ -0,0 +1,142 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_HUGE_PAGES_H
+#define BSTREAM_HUGE_PAGES_H
+
+#include <bstream/types.h>
+#include <cstddef>
+#include <new>
+
+#ifndef BSTREAM_HUGE_PAGE_SIZE
+#define BSTREAM_HUGE_PAGE_SIZE (2UL * 1024UL * 1024UL)
+#endif
+
+namespace bstream
+{
+
+/** Memory backed by transparent huge pages
+ *
+ * allocate() maps anonymous memory aligned to a huge page, rounded up to a whole number
+ * of huge pages, and advises the kernel (MADV_HUGEPAGE) to back it with huge pages. Large
+ * buffers then take one TLB entry per 2 MB instead of one per 4 KB page. Where transparent
+ * huge pages aren't available the advice is ignored, and the memory is ordinary mapped
+ * memory.
+ *
+ * Requests smaller than min_size would waste most of a huge page; huge_page_allocator sends
+ * them to operator new, and buffer::sink to malloc.
+ */
+namespace huge_pages
+{
+
+static constexpr util::size_type page_size = BSTREAM_HUGE_PAGE_SIZE;
+static constexpr util::size_type min_size  = page_size / 2;
+
+constexpr util::size_type
+round_up(util::size_type n)
+{
+	return (n + page_size - 1) & ~(page_size - 1);
+}
+
+/*
+ * Returns null on failure.
+ */
+util::byte_type*
+allocate(util::size_type n) noexcept;
+
+void
+deallocate(util::byte_type* p, util::size_type n) noexcept;
+
+/*
+ * Grows or shrinks a block from allocate(), moving it to another huge page boundary if
+ * necessary (with mremap where available, so contents aren't copied). Returns null on
+ * failure, leaving p intact.
+ */
+util::byte_type*
+reallocate(util::byte_type* p, util::size_type old_size, util::size_type new_size) noexcept;
+
+}    // namespace huge_pages
+
+/** Allocator backing requests of at least huge_pages::min_size with huge pages
+ *
+ * Usable wherever the buffer layer takes an allocator, e.g. bufseq::sink segments:
+ * bufseq::sink{size, huge_page_allocator{}}.
+ */
+class huge_page_allocator
+{
+public:
+	using value_type      = util::byte_type;
+	using pointer         = util::byte_type*;
+	using const_pointer   = const util::byte_type*;
+	using size_type       = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	pointer
+	allocate(size_type n)
+	{
+		pointer result = nullptr;
+		if (n < huge_pages::min_size)
+		{
+			result = static_cast<pointer>(::operator new(n));
+		}
+		else
+		{
+			result = huge_pages::allocate(n);
+			if (result == nullptr)
+			{
+				throw std::bad_alloc{};
+			}
+		}
+		return result;
+	}
+
+	void
+	deallocate(pointer p, size_type n) noexcept
+	{
+		if (n < huge_pages::min_size)
+		{
+			::operator delete(p);
+		}
+		else
+		{
+			huge_pages::deallocate(p, n);
+		}
+	}
+
+	bool
+	operator==(huge_page_allocator const&) const noexcept
+	{
+		return true;
+	}
+
+	bool
+	operator!=(huge_page_allocator const&) const noexcept
+	{
+		return false;
+	}
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_HUGE_PAGES_H
@@ -87,9 +87,7 @@ public:
 	ibstream(ibstream&&)      = delete;
 
 	ibstream(std::unique_ptr<bstream::source> source, context_base const& context = get_default_context())
-		: m_context{context},
-		  m_ptr_deduper{m_context.dedup_shared_ptrs() ? std::make_unique<ptr_deduper>() : nullptr},
-		  m_source{std::move(source)}
+		: m_context{context}, m_ptr_deduper{}, m_source{std::move(source)}
 	//   m_reverse_order{context->byte_order() != bend::order::native}
 	{}
 
@@ -210,6 +208,53 @@ public:
 		return m_source->get_num<U>(err);
 	}
 
+	const util::byte_type*
+	ensure(util::size_type n)
+	{
+		return m_source->ensure(n);
+	}
+
+	const util::byte_type*
+	ensure(util::size_type n, std::error_code& err)
+	{
+		return m_source->ensure(n, err);
+	}
+
+	ibstream&
+	advance(util::size_type k)
+	{
+		m_source->advance(k);
+		return *this;
+	}
+
+	ibstream&
+	advance(util::size_type k, std::error_code& err)
+	{
+		m_source->advance(k, err);
+		return *this;
+	}
+
+	template<class U>
+	typename std::enable_if_t<std::is_arithmetic<U>::value, U>
+	load_num(const util::byte_type* src) const noexcept
+	{
+		return m_source->template load_num<U>(src);
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value>::type
+	get_num_array(U* dst, util::size_type n)
+	{
+		m_source->get_num_array(dst, n);
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value>::type
+	get_num_array(U* dst, util::size_type n, std::error_code& err)
+	{
+		m_source->get_num_array(dst, n, err);
+	}
+
 	util::shared_buffer
 	get_shared_slice(util::size_type nbytes)
 	{
@@ -234,6 +279,18 @@ public:
 		return m_source->get_slice(nbytes, err);
 	}
 
+	buffer_chain
+	get_slice_chain(util::size_type nbytes)
+	{
+		return m_source->get_slice_chain(nbytes);
+	}
+
+	buffer_chain
+	get_slice_chain(util::size_type nbytes, std::error_code& err)
+	{
+		return m_source->get_slice_chain(nbytes, err);
+	}
+
 	util::size_type
 	getn(util::byte_type* dst, util::size_type nbytes)
 	{
@@ -485,6 +542,18 @@ public:
 	util::const_buffer
 	read_blob(std::error_code& err);
 
+	/** Reads a blob without coalescing it; see source::get_slice_chain().
+	 */
+	buffer_chain
+	read_blob_chain()
+	{
+		auto nbytes = read_blob_header();
+		return get_slice_chain(nbytes);
+	}
+
+	buffer_chain
+	read_blob_chain(std::error_code& err);
+
 	std::size_t
 	read_ext_header(std::uint8_t& ext_type);
 
@@ -632,9 +701,9 @@ protected:
 
 		result = m_context.create_shared<T>(tag, *this);
 
-		if (m_ptr_deduper)
+		if (m_context.dedup_shared_ptrs())
 		{
-			m_ptr_deduper->save_ptr(result);
+			get_ptr_deduper().save_ptr(result);
 		}
 
 		return result;
@@ -655,9 +724,9 @@ protected:
 			result = m_context.create_shared<T>(tag, *this);
 		}
 
-		if (m_ptr_deduper)
+		if (m_context.dedup_shared_ptrs())
 		{
-			m_ptr_deduper->save_ptr(result);
+			get_ptr_deduper().save_ptr(result);
 		}
 
 		return result;
@@ -695,9 +764,40 @@ protected:
 	std::shared_ptr<T>
 	get_saved_ptr(int type_tag);
 
+	ptr_deduper&
+	get_ptr_deduper()
+	{
+		if (!m_ptr_deduper)    // created on first use, so streams that never read shared pointers don't allocate it
+		{
+			m_ptr_deduper = std::make_unique<ptr_deduper>();
+		}
+		return *m_ptr_deduper;
+	}
+
 	std::error_code
 	read_error_code();
 
+	/*
+	 * Header decoders shared by ibstream and basic_ibstream. Stream provides get() and
+	 * get_num(), resolved against its own type.
+	 */
+
+	template<class Stream>
+	static std::size_t
+	decode_string_header(Stream& is);
+
+	template<class Stream>
+	static std::size_t
+	decode_array_header(Stream& is);
+
+	template<class Stream>
+	static std::size_t
+	decode_map_header(Stream& is);
+
+	template<class Stream>
+	static std::size_t
+	decode_blob_header(Stream& is);
+
 	void
 	ingest(util::bufwriter& os);
 
@@ -707,34 +807,158 @@ protected:
 	std::unique_ptr<bstream::source> m_source;
 };
 
-template<class T>
-inline typename std::enable_if_t<has_ref_deserializer<T>::value, ibstream&>
-operator>>(ibstream& is, T& obj)
+/*
+ * As with insertion, the extraction operators keep the stream's own type, so the built-in
+ * deserializers read through a basic_ibstream's statically bound primitives.
+ */
+
+template<class Stream, class T>
+inline typename std::enable_if_t<std::conjunction<std::is_base_of<ibstream, Stream>, has_ref_deserializer<T>>::value, Stream&>
+operator>>(Stream& is, T& obj)
 {
-	return ref_deserializer<T>::get(is, obj);
+	ref_deserializer<T>::get(is, obj);
+	return is;
 }
 
-template<class T>
+template<class Stream, class T>
 inline typename std::enable_if_t<
-		!has_ref_deserializer<T>::value && is_ibstream_constructible<T>::value && std::is_assignable<T&, T>::value,
-		ibstream&>
-operator>>(ibstream& is, T& obj)
+		std::conjunction<
+				std::is_base_of<ibstream, Stream>,
+				std::negation<has_ref_deserializer<T>>,
+				is_ibstream_constructible<T>,
+				std::is_assignable<T&, T>>::value,
+		Stream&>
+operator>>(Stream& is, T& obj)
 {
 	obj = T(is);
 	return is;
 }
 
-template<class T>
+template<class Stream, class T>
 inline typename std::enable_if_t<
-		!has_ref_deserializer<T>::value && !is_ibstream_constructible<T>::value && has_value_deserializer<T>::value
-				&& std::is_assignable<T&, T>::value,
-		ibstream&>
-operator>>(ibstream& is, T& obj)
+		std::conjunction<
+				std::is_base_of<ibstream, Stream>,
+				std::negation<has_ref_deserializer<T>>,
+				std::negation<is_ibstream_constructible<T>>,
+				has_value_deserializer<T>,
+				std::is_assignable<T&, T>>::value,
+		Stream&>
+operator>>(Stream& is, T& obj)
 {
 	obj = value_deserializer<T>::get(is);
 	return is;
 }
 
+template<class Stream>
+inline std::size_t
+ibstream::decode_string_header(Stream& is)
+{
+	std::size_t length = 0ul;
+	auto        tcode  = is.get();
+	if (tcode >= typecode::fixstr_min && tcode <= typecode::fixstr_max)
+	{
+		std::uint8_t mask = 0x1f;
+		length            = tcode & mask;
+	}
+	else
+	{
+		switch (tcode)
+		{
+			case typecode::str_8:
+				length = is.template get_num<std::uint8_t>();
+				break;
+			case typecode::str_16:
+				length = is.template get_num<std::uint16_t>();
+				break;
+			case typecode::str_32:
+				length = is.template get_num<std::uint32_t>();
+				break;
+			default:
+				throw std::system_error{make_error_code(bstream::errc::expected_string)};
+		}
+	}
+	return length;
+}
+
+template<class Stream>
+inline std::size_t
+ibstream::decode_array_header(Stream& is)
+{
+	std::size_t length = 0;
+	auto        tcode  = is.get();
+	if (tcode >= typecode::fixarray_min && tcode <= typecode::fixarray_max)
+	{
+		std::uint8_t mask = 0x0f;
+		length            = tcode & mask;
+	}
+	else
+	{
+		switch (tcode)
+		{
+			case typecode::array_16:
+				length = is.template get_num<std::uint16_t>();
+				break;
+			case typecode::array_32:
+				length = is.template get_num<std::uint32_t>();
+				break;
+			default:
+				throw std::system_error{make_error_code(bstream::errc::expected_array)};
+		}
+	}
+	return length;
+}
+
+template<class Stream>
+inline std::size_t
+ibstream::decode_map_header(Stream& is)
+{
+	std::size_t length = 0;
+	auto        tcode  = is.get();
+	if (tcode >= typecode::fixmap_min && tcode <= typecode::fixarray_max)
+	{
+		std::uint8_t mask = 0x0f;
+		length            = tcode & mask;
+	}
+	else
+	{
+		switch (tcode)
+		{
+			case typecode::map_16:
+				length = is.template get_num<std::uint16_t>();
+				break;
+			case typecode::map_32:
+				length = is.template get_num<std::uint32_t>();
+				break;
+			default:
+				throw std::system_error{make_error_code(bstream::errc::expected_map)};
+		}
+	}
+	return length;
+}
+
+template<class Stream>
+inline std::size_t
+ibstream::decode_blob_header(Stream& is)
+{
+	std::size_t length = 0;
+	auto        tcode  = is.get();
+	switch (tcode)
+	{
+		case typecode::bin_8:
+			length = is.template get_num<std::uint8_t>();
+			break;
+		case typecode::bin_16:
+			length = is.template get_num<std::uint16_t>();
+			break;
+		case typecode::bin_32:
+			length = is.template get_num<std::uint32_t>();
+			break;
+		default:
+			throw std::system_error{make_error_code(bstream::errc::expected_blob)};
+	}
+	return length;
+}
+
 
 #if 1
 template<class T>
@@ -748,8 +972,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -788,8 +1013,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -824,8 +1050,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -845,14 +1072,14 @@ struct value_deserializer<
 				case typecode::bool_false:
 					return static_cast<T>(0);
 				case typecode::int_8:
-					return static_cast<T>(is.get_num<int8_t>());
+					return static_cast<T>(is.template get_num<int8_t>());
 				case typecode::uint_8:
-					return static_cast<T>(is.get_num<uint8_t>());
+					return static_cast<T>(is.template get_num<uint8_t>());
 				case typecode::int_16:
-					return static_cast<T>(is.get_num<int16_t>());
+					return static_cast<T>(is.template get_num<int16_t>());
 				case typecode::uint_16:
 				{
-					std::uint16_t n = is.get_num<uint16_t>();
+					std::uint16_t n = is.template get_num<uint16_t>();
 					if (n <= std::numeric_limits<T>::max())
 					{
 						return static_cast<T>(n);
@@ -880,8 +1107,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -897,9 +1125,9 @@ struct value_deserializer<
 				case typecode::bool_false:
 					return static_cast<T>(0);
 				case typecode::uint_8:
-					return static_cast<T>(is.get_num<uint8_t>());
+					return static_cast<T>(is.template get_num<uint8_t>());
 				case typecode::uint_16:
-					return static_cast<T>(is.get_num<uint16_t>());
+					return static_cast<T>(is.template get_num<uint16_t>());
 				default:
 					throw std::system_error{make_error_code(bstream::errc::num_deser_type_error_uint16)};
 			}
@@ -918,8 +1146,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -939,18 +1168,18 @@ struct value_deserializer<
 				case typecode::bool_false:
 					return static_cast<T>(0);
 				case typecode::int_8:
-					return static_cast<T>(is.get_num<int8_t>());
+					return static_cast<T>(is.template get_num<int8_t>());
 				case typecode::uint_8:
-					return static_cast<T>(is.get_num<uint8_t>());
+					return static_cast<T>(is.template get_num<uint8_t>());
 				case typecode::int_16:
-					return static_cast<T>(is.get_num<int16_t>());
+					return static_cast<T>(is.template get_num<int16_t>());
 				case typecode::uint_16:
-					return static_cast<T>(is.get_num<uint16_t>());
+					return static_cast<T>(is.template get_num<uint16_t>());
 				case typecode::int_32:
-					return static_cast<T>(is.get_num<int32_t>());
+					return static_cast<T>(is.template get_num<int32_t>());
 				case typecode::uint_32:
 				{
-					std::uint32_t n = is.get_num<uint32_t>();
+					std::uint32_t n = is.template get_num<uint32_t>();
 					if (n <= std::numeric_limits<T>::max())
 					{
 						return static_cast<T>(n);
@@ -978,8 +1207,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -995,11 +1225,11 @@ struct value_deserializer<
 				case typecode::bool_false:
 					return static_cast<T>(0);
 				case typecode::uint_8:
-					return static_cast<T>(is.get_num<uint8_t>());
+					return static_cast<T>(is.template get_num<uint8_t>());
 				case typecode::uint_16:
-					return static_cast<T>(is.get_num<uint16_t>());
+					return static_cast<T>(is.template get_num<uint16_t>());
 				case typecode::uint_32:
-					return static_cast<T>(is.get_num<uint32_t>());
+					return static_cast<T>(is.template get_num<uint32_t>());
 				default:
 					throw std::system_error{make_error_code(bstream::errc::num_deser_type_error_uint32)};
 			}
@@ -1018,8 +1248,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -1039,22 +1270,22 @@ struct value_deserializer<
 				case typecode::bool_false:
 					return static_cast<T>(0);
 				case typecode::int_8:
-					return static_cast<T>(is.get_num<int8_t>());
+					return static_cast<T>(is.template get_num<int8_t>());
 				case typecode::uint_8:
-					return static_cast<T>(is.get_num<uint8_t>());
+					return static_cast<T>(is.template get_num<uint8_t>());
 				case typecode::int_16:
-					return static_cast<T>(is.get_num<int16_t>());
+					return static_cast<T>(is.template get_num<int16_t>());
 				case typecode::uint_16:
-					return static_cast<T>(is.get_num<uint16_t>());
+					return static_cast<T>(is.template get_num<uint16_t>());
 				case typecode::int_32:
-					return static_cast<T>(is.get_num<int32_t>());
+					return static_cast<T>(is.template get_num<int32_t>());
 				case typecode::uint_32:
-					return static_cast<T>(is.get_num<uint32_t>());
+					return static_cast<T>(is.template get_num<uint32_t>());
 				case typecode::int_64:
-					return static_cast<T>(is.get_num<int64_t>());
+					return static_cast<T>(is.template get_num<int64_t>());
 				case typecode::uint_64:
 				{
-					std::uint64_t n = is.get_num<uint64_t>();
+					std::uint64_t n = is.template get_num<uint64_t>();
 					if (n <= std::numeric_limits<T>::max())
 					{
 						return static_cast<T>(n);
@@ -1082,8 +1313,9 @@ struct value_deserializer<
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode <= typecode::positive_fixint_max)
@@ -1099,13 +1331,13 @@ struct value_deserializer<
 				case typecode::bool_false:
 					return static_cast<T>(0);
 				case typecode::uint_8:
-					return static_cast<T>(is.get_num<uint8_t>());
+					return static_cast<T>(is.template get_num<uint8_t>());
 				case typecode::uint_16:
-					return static_cast<T>(is.get_num<uint16_t>());
+					return static_cast<T>(is.template get_num<uint16_t>());
 				case typecode::uint_32:
-					return static_cast<T>(is.get_num<uint32_t>());
+					return static_cast<T>(is.template get_num<uint32_t>());
 				case typecode::uint_64:
-					return static_cast<T>(is.get_num<uint64_t>());
+					return static_cast<T>(is.template get_num<uint64_t>());
 				default:
 					throw std::system_error{make_error_code(bstream::errc::num_deser_type_error_uint64)};
 			}
@@ -1122,36 +1354,41 @@ struct value_deserializer<std::string>
 		return get(is);
 	}
 
+	template<class Stream>
 	static std::string
-	get(ibstream& is)
+	get(Stream& is)
 	{
-		auto        tcode  = is.get();
-		std::size_t length = 0;
+		auto tcode = is.peek();
 		if (tcode >= typecode::fixstr_min && tcode <= typecode::fixstr_max)
 		{
-			std::uint8_t mask = 0x1f;
-			length            = tcode & mask;
+			// header and characters are read from one window
+			std::uint8_t           mask   = 0x1f;
+			std::size_t            length = tcode & mask;
+			const util::byte_type* p      = is.ensure(length + 1);
+			std::string            result{reinterpret_cast<const char*>(p + 1), length};
+			is.advance(length + 1);
+			return result;
 		}
-		else
+
+		is.get();
+		std::size_t length = 0;
+		switch (tcode)
 		{
-			switch (tcode)
-			{
-				case typecode::str_8:
-					length = is.get_num<std::uint8_t>();
-					break;
-				case typecode::str_16:
-					length = is.get_num<std::uint16_t>();
-					break;
-				case typecode::str_32:
-					length = is.get_num<std::uint32_t>();
-					break;
-				default:
-					throw std::system_error{make_error_code(bstream::errc::val_deser_type_error_string)};
-			}
+			case typecode::str_8:
+				length = is.template get_num<std::uint8_t>();
+				break;
+			case typecode::str_16:
+				length = is.template get_num<std::uint16_t>();
+				break;
+			case typecode::str_32:
+				length = is.template get_num<std::uint32_t>();
+				break;
+			default:
+				throw std::system_error{make_error_code(bstream::errc::val_deser_type_error_string)};
 		}
-		util::byte_type strchars[length];
-		is.getn(strchars, length);
-		return std::string{reinterpret_cast<char*>(&strchars), length};
+		std::string result(length, '\0');
+		is.getn(reinterpret_cast<util::byte_type*>(&result[0]), length);
+		return result;
 	}
 };
 
@@ -1164,14 +1401,16 @@ struct value_deserializer<util::string_alias>
 		return get(is);
 	}
 
+	template<class Stream>
 	static util::string_alias
-	get(ibstream& is, std::size_t length)
+	get(Stream& is, std::size_t length)
 	{
 		return util::string_alias{is.get_shared_slice(length)};
 	}
 
+	template<class Stream>
 	static util::string_alias
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		if (tcode >= typecode::fixstr_min && tcode <= typecode::fixstr_max)
@@ -1186,17 +1425,17 @@ struct value_deserializer<util::string_alias>
 			{
 				case typecode::str_8:
 				{
-					std::size_t length = is.get_num<std::uint8_t>();
+					std::size_t length = is.template get_num<std::uint8_t>();
 					return get(is, length);
 				}
 				case typecode::str_16:
 				{
-					std::size_t length = is.get_num<std::uint16_t>();
+					std::size_t length = is.template get_num<std::uint16_t>();
 					return get(is, length);
 				}
 				case typecode::str_32:
 				{
-					std::size_t length = is.get_num<std::uint32_t>();
+					std::size_t length = is.template get_num<std::uint32_t>();
 					return get(is, length);
 				}
 				default:
@@ -1217,10 +1456,11 @@ struct value_deserializer<T, std::enable_if_t<std::is_enum<T>::value>>
 		return get(is);
 	}
 
+	template<class Stream>
 	static T
-	get(ibstream& is)
+	get(Stream& is)
 	{
-		auto ut = is.read_as<typename std::underlying_type<T>::type>();
+		auto ut = is.template read_as<typename std::underlying_type<T>::type>();
 		return static_cast<T>(ut);
 	}
 };
@@ -1267,8 +1507,9 @@ struct value_deserializer<bool>
 		return get(is);
 	}
 
+	template<class Stream>
 	static bool
-	get(ibstream& is)
+	get(Stream& is)
 	{
 		auto tcode = is.get();
 		switch (tcode)
@@ -1292,17 +1533,20 @@ struct value_deserializer<float>
 		return get(is);
 	}
 
+	template<class Stream>
 	static float
-	get(ibstream& is)
+	get(Stream& is)
 	{
-		auto tcode = is.get();
-		if (tcode == typecode::float_32)
+		if (is.peek() == typecode::float_32)
 		{
-			std::uint32_t unpacked = is.get_num<std::uint32_t>();
-			return reinterpret_cast<float&>(unpacked);
+			const util::byte_type* p      = is.ensure(5);
+			float                  result = is.template load_num<float>(p + 1);
+			is.advance(5);
+			return result;
 		}
 		else
 		{
+			is.get();
 			throw std::system_error{make_error_code(bstream::errc::expected_float)};
 		}
 	}
@@ -1317,22 +1561,28 @@ struct value_deserializer<double>
 		return get(is);
 	}
 
+	template<class Stream>
 	static double
-	get(ibstream& is)
+	get(Stream& is)
 	{
-		auto tcode = is.get();
-		if (tcode == typecode::float_32)
+		auto tcode = is.peek();
+		if (tcode == typecode::float_64)
 		{
-			std::uint32_t unpacked = is.get_num<std::uint32_t>();
-			return static_cast<double>(reinterpret_cast<float&>(unpacked));
+			const util::byte_type* p      = is.ensure(9);
+			double                 result = is.template load_num<double>(p + 1);
+			is.advance(9);
+			return result;
 		}
-		else if (tcode == typecode::float_64)
+		else if (tcode == typecode::float_32)
 		{
-			std::uint64_t unpacked = is.get_num<std::uint64_t>();
-			return reinterpret_cast<double&>(unpacked);
+			const util::byte_type* p      = is.ensure(5);
+			float                  result = is.template load_num<float>(p + 1);
+			is.advance(5);
+			return static_cast<double>(result);
 		}
 		else
 		{
+			is.get();
 			throw std::system_error{make_error_code(bstream::errc::expected_double)};
 		}
 	}
@@ -1721,10 +1971,10 @@ ibstream::get_saved_ptr(int type_tag)
 {
 	std::shared_ptr<T> result{nullptr};
 
-	if (m_ptr_deduper)
+	if (m_context.dedup_shared_ptrs())
 	{
 		auto index = read_as<std::size_t>();
-		auto info  = m_ptr_deduper->get_saved_ptr(index);
+		auto info  = get_ptr_deduper().get_saved_ptr(index);
 		if (type_tag > -1)
 		{
 			auto saved_tag = m_context.get_type_tag(info.first);
@@ -38,7 +38,10 @@ namespace bstream
 class ifbstream : public ibstream
 {
 public:
-	ifbstream(context_base const& context = get_default_context()) : ibstream{std::make_unique<file::source>(), context} {}
+	ifbstream(context_base const& context = get_default_context()) : ibstream{std::make_unique<file::source>(), context}
+	{
+		apply_huge_pages(context);
+	}
 
 	ifbstream(ifbstream const&) = delete;
 	ifbstream(ifbstream&&)      = delete;
@@ -53,11 +56,15 @@ public:
 
 	ifbstream(std::string const& filename, context_base const& context = get_default_context())
 		: ibstream{std::make_unique<file::source>(filename), context}
-	{}
+	{
+		apply_huge_pages(context);
+	}
 
 	ifbstream(std::string const& filename, std::error_code& err, context_base const& context = get_default_context())
 		: ibstream{std::make_unique<file::source>(filename, err), context}
-	{}
+	{
+		apply_huge_pages(context);
+	}
 
 	void
 	open(std::string const& filename)
@@ -106,6 +113,16 @@ public:
 	{
 		return bstream::static_unique_ptr_cast<file::source>(release_source());
 	}
+
+private:
+	void
+	apply_huge_pages(context_base const& context)
+	{
+		if (context.huge_pages())
+		{
+			get_filebuf().huge_pages(true);
+		}
+	}
 };
 
 }    // namespace bstream
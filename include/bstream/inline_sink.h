@@ -0,0 +1,101 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_INLINE_SINK_H
+#define BSTREAM_INLINE_SINK_H
+
+#include <bstream/sink.h>
+#include <cstddef>
+
+namespace bstream
+{
+
+/** Sink with a fixed capacity of N bytes, stored in the sink object itself
+ *
+ * inline_sink never allocates. A write that doesn't fit in the remaining capacity
+ * fails with std::errc::no_buffer_space (thrown as std::system_error by the throwing
+ * overloads), and positioning beyond N fails with std::errc::invalid_argument. After a
+ * failed write, the content of the sink is unspecified; clear() makes it usable again.
+ */
+template<std::size_t N>
+class inline_sink : public bstream::sink
+{
+public:
+	using base = bstream::sink;
+
+	static_assert(N > 0, "inline_sink capacity must be non-zero");
+
+	inline_sink(byte_order order = byte_order::big_endian) : base{m_data, N, order} {}
+
+	inline_sink(inline_sink&&)      = delete;
+	inline_sink(inline_sink const&) = delete;
+	inline_sink&
+	operator=(inline_sink&&)
+			= delete;
+	inline_sink&
+	operator=(inline_sink const&)
+			= delete;
+
+	static constexpr util::size_type
+	capacity() noexcept
+	{
+		return N;
+	}
+
+	const util::byte_type*
+	data() const noexcept
+	{
+		return m_data;
+	}
+
+	inline_sink&
+	clear() noexcept
+	{
+		set_ptrs(m_data, m_data, m_data + N);
+		reset_high_water_mark();
+		m_did_jump = false;
+		m_dirty    = false;
+		return *this;
+	}
+
+protected:
+	virtual bool
+	can_grow() const override
+	{
+		return false;
+	}
+
+private:
+	util::byte_type m_data[N];
+};
+
+template<std::size_t N>
+struct default_sink_policy<inline_sink<N>>
+{
+	using type = memory_sink_policy;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_INLINE_SINK_H
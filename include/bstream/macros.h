@@ -190,14 +190,16 @@ private
 	BSTRM_FRIEND_BASE(name)                                                                                            \
 	BSTRM_CTOR_(name, base_array, member_array)                                                                        \
 	BSTRM_ITEM_COUNT_(base_array, member_array)                                                                        \
-	BSTRM_SERIALIZE_(name, base_array, member_array)
+	BSTRM_SERIALIZE_(name, base_array, member_array)                                                                   \
+	BSTRM_STREAMED_SHAPE_(name, base_array, member_array)
 /**/
 
 #define BSTRM_POLY_CLASS_(name, base_array, member_array)                                                              \
 	BSTRM_FRIEND_BASE(name)                                                                                            \
 	BSTRM_CTOR_(name, base_array, member_array)                                                                        \
 	BSTRM_ITEM_COUNT_(base_array, member_array)                                                                        \
-	BSTRM_POLY_SERIALIZE_(name, base_array, member_array)
+	BSTRM_POLY_SERIALIZE_(name, base_array, member_array)                                                              \
+	BSTRM_STREAMED_SHAPE_(name, base_array, member_array)
 /**/
 
 #define BSTRM_BASE_TYPE_(class_name) bstream::streaming_base<class_name>
@@ -264,6 +266,41 @@ private
 	}
 /**/
 
+#define BSTRM_STREAMED_SHAPE_(name, base_array, member_array)                                                          \
+	template<class _Self = name>                                                                                       \
+	static auto _streamed_shape()                                                                                      \
+			-> bstream::detail::streamed_shape<                                                                        \
+					_Self,                                                                                             \
+					bstream::detail::type_list<BSTRM_STREAMED_BASE_TYPES_(base_array)>,                                \
+					bstream::detail::type_list<BSTRM_STREAMED_MEMBER_TYPES_(member_array)>>;
+/**/
+
+#define BSTRM_STREAMED_BASE_TYPES_(base_array)                                                                         \
+	BOOST_PP_IF(BOOST_PP_ARRAY_SIZE(base_array), BSTRM_DO_STREAMED_BASE_TYPES_, BSTRM_NO_STREAMED_TYPES_)(base_array)
+/**/
+
+#define BSTRM_STREAMED_MEMBER_TYPES_(member_array)                                                                     \
+	BOOST_PP_IF(BOOST_PP_ARRAY_SIZE(member_array), BSTRM_DO_STREAMED_MEMBER_TYPES_, BSTRM_NO_STREAMED_TYPES_)(member_array)
+/**/
+
+#define BSTRM_NO_STREAMED_TYPES_(array)
+/**/
+
+#define BSTRM_DO_STREAMED_BASE_TYPES_(base_array)                                                                      \
+	BOOST_PP_SEQ_FOR_EACH_I(BSTRM_STREAMED_EACH_BASE_TYPE_, _, BOOST_PP_ARRAY_TO_SEQ(base_array))
+/**/
+
+#define BSTRM_DO_STREAMED_MEMBER_TYPES_(member_array)                                                                  \
+	BOOST_PP_SEQ_FOR_EACH_I(BSTRM_STREAMED_EACH_MEMBER_TYPE_, _, BOOST_PP_ARRAY_TO_SEQ(member_array))
+/**/
+
+#define BSTRM_STREAMED_EACH_BASE_TYPE_(r, data, i, elem) BOOST_PP_COMMA_IF(i) elem
+/**/
+
+#define BSTRM_STREAMED_EACH_MEMBER_TYPE_(r, data, i, elem)                                                             \
+	BOOST_PP_COMMA_IF(i) decltype(std::declval<_Self const&>().elem)
+/**/
+
 #define BSTRM_ITEM_COUNT_EVAL_(base_array, member_array)                                                               \
 	BOOST_PP_ADD(BOOST_PP_ARRAY_SIZE(base_array), BOOST_PP_ARRAY_SIZE(member_array))
 /**/
@@ -0,0 +1,97 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_NULL_SINK_H
+#define BSTREAM_NULL_SINK_H
+
+#include <bstream/sink.h>
+
+#ifndef BSTREAM_NULL_SINK_BUFFER_SIZE
+#define BSTREAM_NULL_SINK_BUFFER_SIZE 1024UL
+#endif
+
+namespace bstream
+{
+namespace null
+{
+
+/** Sink that counts bytes without storing them
+ *
+ * Small writes land in an internal scratch area, which is recycled whenever it fills;
+ * a write that doesn't fit in what is left of it is only counted. Positioning works as for an expandable memory sink (a jump past the end extends
+ * the output sequence), so size() reports exactly the number of bytes any other
+ * sink would hold after the same sequence of operations.
+ */
+class sink : public bstream::sink
+{
+public:
+	using base = bstream::sink;
+
+	sink(byte_order order = byte_order::big_endian) : base{order}
+	{
+		set_ptrs(m_scratch, m_scratch, m_scratch + sizeof(m_scratch));
+	}
+
+	sink(sink&&)      = delete;
+	sink(sink const&) = delete;
+	sink&
+	operator=(sink&&)
+			= delete;
+	sink&
+	operator=(sink const&)
+			= delete;
+
+	sink&
+	clear() noexcept;
+
+protected:
+	virtual void
+	really_jump(std::error_code& err) override;
+
+	virtual bool
+	is_valid_position(util::position_type pos) const override;
+
+	virtual void
+	really_overflow(util::size_type, std::error_code& err) override;
+
+	virtual util::size_type
+	really_write_direct(const util::byte_type* src, util::size_type n, std::error_code& err) override;
+
+	virtual void
+	really_truncate(util::position_type pos, std::error_code& err) override;
+
+	util::byte_type m_scratch[BSTREAM_NULL_SINK_BUFFER_SIZE];
+};
+
+}    // namespace null
+
+template<>
+struct default_sink_policy<null::sink>
+{
+	using type = memory_sink_policy;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_NULL_SINK_H
@@ -30,6 +30,7 @@
 #include <bstream/obstream_traits.h>
 #include <bstream/sink.h>
 #include <bstream/typecode.h>
+#include <cstring>
 #include <util/buffer.h>
 #include <unordered_map>
 #include <vector>
@@ -39,6 +40,40 @@
 namespace bstream
 {
 
+namespace detail
+{
+/*
+ * Exact encoded sizes of the variable-width encodings, so the serializers reserve no more
+ * than they write. A larger window could fail on a sink that can't grow, or force a
+ * scratch window at a segment boundary the value itself would fit in front of.
+ */
+
+constexpr util::size_type
+uint_encoded_size(std::uint64_t value)
+{
+	return (value <= 0xff) ? 2 : ((value <= 0xffff) ? 3 : ((value <= 0xffffffff) ? 5 : 9));
+}
+
+constexpr util::size_type
+negative_int_encoded_size(std::int64_t value)
+{
+	return (value >= -0x80) ? 2 : ((value >= -0x8000) ? 3 : ((value >= -0x80000000LL) ? 5 : 9));
+}
+
+// str_16/str_32, array_16/array_32 and map_16/map_32 headers
+constexpr util::size_type
+length_header_size(std::uint64_t size)
+{
+	return (size <= 0xffff) ? 3 : 5;
+}
+
+constexpr util::size_type
+blob_header_size(std::uint64_t size)
+{
+	return (size <= 0xff) ? 2 : ((size <= 0xffff) ? 3 : 5);
+}
+}    // namespace detail
+
 class obstream    //: public onumstream
 {
 protected:
@@ -72,6 +107,7 @@ public:
 		save_ptr(std::shared_ptr<void> ptr, poly_tag_type tag)
 		{
 			m_saved_ptrs.emplace(ptr, std::make_pair(tag, m_next_serial_num));
+			m_saved_order.push_back(ptr.get());
 			++m_next_serial_num;
 		}
 
@@ -79,37 +115,75 @@ public:
 		clear()
 		{
 			m_saved_ptrs.clear();
+			m_saved_order.clear();
 			m_next_serial_num = 0;
 		}
 
+		std::size_t
+		size() const noexcept
+		{
+			return m_next_serial_num;
+		}
+
+		/** Forgets the pointers saved after the first count. Only those pointers are
+		 * visited, so the cost doesn't depend on how many were saved before.
+		 */
+		void
+		rollback(std::size_t count)
+		{
+			while (m_saved_order.size() > count)
+			{
+				// shared_ptr keys hash and compare by address; a non-owning alias finds the entry
+				m_saved_ptrs.erase(std::shared_ptr<void>{std::shared_ptr<void>{}, m_saved_order.back()});
+				m_saved_order.pop_back();
+			}
+			m_next_serial_num = std::min(m_next_serial_num, count);
+		}
+
 	private:
 		std::size_t                                               m_next_serial_num = 0;
 		std::unordered_map<std::shared_ptr<void>, saved_ptr_info> m_saved_ptrs;
+		std::vector<void*>                                        m_saved_order;    // saved pointers by serial number
+	};
+
+	/** State saved by checkpoint() and restored by rollback()
+	 */
+	struct checkpoint_token
+	{
+		util::position_type position;
+		util::size_type     size;
+		std::size_t         saved_ptrs;
 	};
 
 	obstream(std::unique_ptr<bstream::sink> sink, context_base const& context = get_default_context())
-		: m_context{context},
-		  m_ptr_deduper{m_context.dedup_shared_ptrs() ? std::make_unique<ptr_deduper>() : nullptr},
-		  m_sink{std::move(sink)}
+		: m_context{context}, m_ptr_deduper{}, m_owned_sink{std::move(sink)}, m_sink{m_owned_sink.get()}
 	{}
 
+	/** Writes to every sink in targets through a tee::sink, so each value is
+	 * encoded once however many targets there are. The targets are not owned.
+	 */
+	obstream(std::vector<bstream::sink*> const& targets, context_base const& context = get_default_context());
+
 	bstream::sink&
 	get_sink()
 	{
-		return *m_sink.get();
+		return *m_sink;
 	}
 
 	bstream::sink const&
 	get_sink() const
 	{
-		return *m_sink.get();
+		return *m_sink;
 	}
 
+	/** Detaches the sink from the stream. If the stream doesn't own its sink (see the
+	 * protected constructor taking a sink reference), the result is empty.
+	 */
 	std::unique_ptr<bstream::sink>
 	release_sink()
 	{
-		return std::move(m_sink);
 		m_sink = nullptr;
+		return std::move(m_owned_sink);
 	}
 
 	obstream&
@@ -188,6 +262,55 @@ public:
 		return *this;
 	}
 
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value, obstream&>::type
+	put_num_array(const U* src, util::size_type n)
+	{
+		m_sink->put_num_array(src, n);
+		return *this;
+	}
+
+	template<class U>
+	typename std::enable_if<std::is_arithmetic<U>::value, obstream&>::type
+	put_num_array(const U* src, util::size_type n, std::error_code& err)
+	{
+		m_sink->put_num_array(src, n, err);
+		return *this;
+	}
+
+	util::byte_type*
+	reserve(util::size_type n)
+	{
+		return m_sink->reserve(n);
+	}
+
+	util::byte_type*
+	reserve(util::size_type n, std::error_code& err)
+	{
+		return m_sink->reserve(n, err);
+	}
+
+	obstream&
+	commit(util::size_type k)
+	{
+		m_sink->commit(k);
+		return *this;
+	}
+
+	obstream&
+	commit(util::size_type k, std::error_code& err)
+	{
+		m_sink->commit(k, err);
+		return *this;
+	}
+
+	template<class U>
+	typename std::enable_if_t<std::is_arithmetic<U>::value, util::byte_type*>
+	store_num(util::byte_type* dst, U value) const noexcept
+	{
+		return m_sink->store_num(dst, value);
+	}
+
 	util::size_type
 	size()
 	{
@@ -230,6 +353,25 @@ public:
 		putn(reinterpret_cast<const util::byte_type*>(src), len);
 	}
 
+	/*
+	 * checkpoint() records the stream's state, and rollback() returns to it: the sink is
+	 * truncated to its size at the checkpoint, repositioned, and shared pointers saved
+	 * since are forgotten (so a later write serializes them in full again). Output written
+	 * before the checkpoint that was overwritten after it is not restored.
+	 */
+
+	checkpoint_token
+	checkpoint() const
+	{
+		return checkpoint_token{m_sink->position(), m_sink->size(), m_ptr_deduper ? m_ptr_deduper->size() : 0};
+	}
+
+	void
+	rollback(checkpoint_token const& token, std::error_code& err);
+
+	void
+	rollback(checkpoint_token const& token);
+
 
 	obstream&
 	write_map_header(std::uint32_t size);
@@ -319,6 +461,31 @@ public:
 		return *this;
 	}
 
+	/** Writes buf as a blob, referring to its storage instead of copying it when
+	 * the sink supports splicing (bufseq::sink). buf must not be modified while
+	 * the sink's output is in use.
+	 */
+	obstream&
+	write_blob_ref(util::shared_buffer const& buf)
+	{
+		write_blob_header(buf.size());
+		m_sink->splice(buf);
+		return *this;
+	}
+
+	obstream&
+	write_blob_ref(util::shared_buffer const& buf, std::error_code& err)
+	{
+		write_blob_header(buf.size(), err);
+		if (err)
+			goto exit;
+
+		m_sink->splice(buf, err);
+
+	exit:
+		return *this;
+	}
+
 	obstream&
 	write_object_header(std::uint32_t size)
 	{
@@ -404,17 +571,24 @@ public:
 	}
 
 protected:
+	/** Writes to sink without owning it; sink must outlive the stream.
+	 */
+	obstream(bstream::sink& sink, context_base const& context)
+		: m_context{context}, m_ptr_deduper{}, m_owned_sink{}, m_sink{&sink}
+	{}
+
 	void
 	use(std::unique_ptr<bstream::sink> sink)
 	{
-		m_sink = std::move(sink);
+		m_owned_sink = std::move(sink);
+		m_sink       = m_owned_sink.get();
 	}
 
 	template<class T, class... Args>
 	typename std::enable_if_t<std::is_base_of<bstream::sink, T>::value>
 	use(Args&&... args)
 	{
-		m_sink = std::make_unique<T>(std::forward<Args>(args)...);
+		use(std::make_unique<T>(std::forward<Args>(args)...));
 	}
 
 	template<class T>
@@ -463,6 +637,23 @@ protected:
 	obstream&
 	write_error_code(std::error_code const& ecode, std::error_code& err);
 
+	/*
+	 * Header encoders shared by obstream and basic_obstream. Stream provides put(),
+	 * reserve(), store_num() and commit(), resolved against its own type.
+	 */
+
+	template<class Stream>
+	static void
+	encode_map_header(Stream& os, std::uint32_t size);
+
+	template<class Stream>
+	static void
+	encode_array_header(Stream& os, std::uint32_t size);
+
+	template<class Stream>
+	static void
+	encode_blob_header(Stream& os, std::uint32_t size);
+
 	// private:
 
 	static std::size_t
@@ -476,53 +667,149 @@ protected:
 
 	context_base const&            m_context;
 	std::unique_ptr<ptr_deduper>   m_ptr_deduper;
-	std::unique_ptr<bstream::sink> m_sink;
+	std::unique_ptr<bstream::sink> m_owned_sink;
+	bstream::sink*                 m_sink;
 };
 
-template<class T>
-inline typename std::enable_if_t<has_serialize_method<T>::value, obstream&>
-operator<<(obstream& os, const T& value)
+template<class Stream>
+inline void
+obstream::encode_map_header(Stream& os, std::uint32_t size)
 {
-	return value.serialize(os);
+	if (size <= 15)
+	{
+		std::uint8_t code = 0x80 | static_cast<std::uint8_t>(size);
+		os.put(code);
+	}
+	else
+	{
+		util::byte_type* window = os.reserve(detail::length_header_size(size));
+		util::byte_type* p      = window;
+		if (size <= std::numeric_limits<std::uint16_t>::max())
+		{
+			*p++ = typecode::map_16;
+			p    = os.store_num(p, static_cast<std::uint16_t>(size));
+		}
+		else
+		{
+			*p++ = typecode::map_32;
+			p    = os.store_num(p, static_cast<std::uint32_t>(size));
+		}
+		os.commit(p - window);
+	}
 }
 
-template<class T>
-inline typename std::enable_if_t<!has_serialize_method<T>::value && has_serializer<T>::value, obstream&>
-operator<<(obstream& os, const T& value)
+template<class Stream>
+inline void
+obstream::encode_array_header(Stream& os, std::uint32_t size)
+{
+	if (size <= 15)
+	{
+		std::uint8_t code = 0x90 | static_cast<std::uint8_t>(size);
+		os.put(code);
+	}
+	else
+	{
+		util::byte_type* window = os.reserve(detail::length_header_size(size));
+		util::byte_type* p      = window;
+		if (size <= std::numeric_limits<std::uint16_t>::max())
+		{
+			*p++ = typecode::array_16;
+			p    = os.store_num(p, static_cast<std::uint16_t>(size));
+		}
+		else
+		{
+			*p++ = typecode::array_32;
+			p    = os.store_num(p, static_cast<std::uint32_t>(size));
+		}
+		os.commit(p - window);
+	}
+}
+
+template<class Stream>
+inline void
+obstream::encode_blob_header(Stream& os, std::uint32_t size)
+{
+	util::byte_type* window = os.reserve(detail::blob_header_size(size));
+	util::byte_type* p      = window;
+	if (size <= std::numeric_limits<std::uint8_t>::max())
+	{
+		*p++ = typecode::bin_8;
+		*p++ = static_cast<std::uint8_t>(size);
+	}
+	else if (size <= std::numeric_limits<std::uint16_t>::max())
+	{
+		*p++ = typecode::bin_16;
+		p    = os.store_num(p, static_cast<std::uint16_t>(size));
+	}
+	else
+	{
+		*p++ = typecode::bin_32;
+		p    = os.store_num(p, static_cast<std::uint32_t>(size));
+	}
+	os.commit(p - window);
+}
+
+/*
+ * The insertion operators keep the stream's own type, so a chain of insertions into a
+ * basic_obstream, and the built-in serializers it reaches, resolve the stream's primitives
+ * against its sink type at compile time. Serializers that take obstream& work unchanged.
+ */
+
+template<class Stream, class T>
+inline typename std::enable_if_t<std::conjunction<std::is_base_of<obstream, Stream>, has_serialize_method<T>>::value, Stream&>
+operator<<(Stream& os, const T& value)
+{
+	value.serialize(os);
+	return os;
+}
+
+template<class Stream, class T>
+inline typename std::enable_if_t<
+		std::conjunction<std::is_base_of<obstream, Stream>, std::negation<has_serialize_method<T>>, has_serializer<T>>::value,
+		Stream&>
+operator<<(Stream& os, const T& value)
 {
-	return serializer<T>::put(os, value);
+	serializer<T>::put(os, value);
+	return os;
 }
 
 template<class T>
 struct serializer<T, typename std::enable_if_t<std::is_integral<T>::value && !std::numeric_limits<T>::is_signed>>
 {
-	static obstream&
-	put(obstream& os, T value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, T value)
 	{
 		if (value <= typecode::positive_fixint_max)
 		{
 			std::uint8_t val = static_cast<std::uint8_t>(value);
 			os.put(val);
 		}
-		else if (value <= std::numeric_limits<std::uint8_t>::max())
-		{
-			os.put(typecode::uint_8);
-			os.put(static_cast<std::uint8_t>(value));
-		}
-		else if (value <= std::numeric_limits<std::uint16_t>::max())
-		{
-			os.put(typecode::uint_16);
-			os.put_num(static_cast<std::uint16_t>(value));
-		}
-		else if (value <= std::numeric_limits<std::uint32_t>::max())
-		{
-			os.put(typecode::uint_32);
-			os.put_num(static_cast<std::uint32_t>(value));
-		}
 		else
 		{
-			os.put(typecode::uint_64);
-			os.put_num(static_cast<std::uint64_t>(value));
+			util::byte_type* window = os.reserve(detail::uint_encoded_size(value));
+			util::byte_type* p      = window;
+			if (value <= std::numeric_limits<std::uint8_t>::max())
+			{
+				*p++ = typecode::uint_8;
+				*p++ = static_cast<std::uint8_t>(value);
+			}
+			else if (value <= std::numeric_limits<std::uint16_t>::max())
+			{
+				*p++ = typecode::uint_16;
+				p    = os.store_num(p, static_cast<std::uint16_t>(value));
+			}
+			else if (value <= std::numeric_limits<std::uint32_t>::max())
+			{
+				*p++ = typecode::uint_32;
+				p    = os.store_num(p, static_cast<std::uint32_t>(value));
+			}
+			else
+			{
+				*p++ = typecode::uint_64;
+				p    = os.store_num(p, static_cast<std::uint64_t>(value));
+			}
+			os.commit(p - window);
 		}
 		return os;
 	}
@@ -531,65 +818,73 @@ struct serializer<T, typename std::enable_if_t<std::is_integral<T>::value && !st
 template<class T>
 struct serializer<T, typename std::enable_if_t<std::is_integral<T>::value && std::numeric_limits<T>::is_signed>>
 {
-	static obstream&
-	put(obstream& os, T value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, T value)
 	{
-		if (value >= 0)
+		if (value >= 0 && static_cast<std::uint64_t>(value) <= typecode::positive_fixint_max)
 		{
-			std::uint64_t uvalue = static_cast<std::uint64_t>(value);
-
-			if (uvalue <= typecode::positive_fixint_max)
-			{
-				std::uint8_t val = static_cast<std::uint8_t>(uvalue);
-				os.put(val);
-			}
-			else if (uvalue <= std::numeric_limits<std::uint8_t>::max())
-			{
-				os.put(typecode::uint_8);
-				os.put(static_cast<std::uint8_t>(uvalue));
-			}
-			else if (uvalue <= std::numeric_limits<std::uint16_t>::max())
-			{
-				os.put(typecode::uint_16);
-				os.put_num(static_cast<std::uint16_t>(uvalue));
-			}
-			else if (uvalue <= std::numeric_limits<std::uint32_t>::max())
-			{
-				os.put(typecode::uint_32);
-				os.put_num(static_cast<std::uint32_t>(uvalue));
-			}
-			else
-			{
-				os.put(typecode::uint_64);
-				os.put_num(uvalue);
-			}
+			os.put(static_cast<std::uint8_t>(value));
+		}
+		else if (value < 0 && value >= -32)
+		{
+			os.put(static_cast<std::uint8_t>(value));
 		}
 		else
 		{
-			if (value >= -32)
-			{
-				os.put(static_cast<std::uint8_t>(value));
-			}
-			else if (value >= std::numeric_limits<std::int8_t>::min())
+			util::byte_type* window = os.reserve(
+					(value >= 0) ? detail::uint_encoded_size(static_cast<std::uint64_t>(value))
+								 : detail::negative_int_encoded_size(value));
+			util::byte_type* p      = window;
+			if (value >= 0)
 			{
-				os.put(typecode::int_8);
-				os.put_num(static_cast<std::int8_t>(value));
-			}
-			else if (value >= std::numeric_limits<std::int16_t>::min())
-			{
-				os.put(typecode::int_16);
-				os.put_num(static_cast<std::int16_t>(value));
-			}
-			else if (value >= std::numeric_limits<std::int32_t>::min())
-			{
-				os.put(typecode::int_32);
-				os.put_num(static_cast<std::int32_t>(value));
+				std::uint64_t uvalue = static_cast<std::uint64_t>(value);
+
+				if (uvalue <= std::numeric_limits<std::uint8_t>::max())
+				{
+					*p++ = typecode::uint_8;
+					*p++ = static_cast<std::uint8_t>(uvalue);
+				}
+				else if (uvalue <= std::numeric_limits<std::uint16_t>::max())
+				{
+					*p++ = typecode::uint_16;
+					p    = os.store_num(p, static_cast<std::uint16_t>(uvalue));
+				}
+				else if (uvalue <= std::numeric_limits<std::uint32_t>::max())
+				{
+					*p++ = typecode::uint_32;
+					p    = os.store_num(p, static_cast<std::uint32_t>(uvalue));
+				}
+				else
+				{
+					*p++ = typecode::uint_64;
+					p    = os.store_num(p, uvalue);
+				}
 			}
 			else
 			{
-				os.put(typecode::int_64);
-				os.put_num(static_cast<std::int64_t>(value));
+				if (value >= std::numeric_limits<std::int8_t>::min())
+				{
+					*p++ = typecode::int_8;
+					p    = os.store_num(p, static_cast<std::int8_t>(value));
+				}
+				else if (value >= std::numeric_limits<std::int16_t>::min())
+				{
+					*p++ = typecode::int_16;
+					p    = os.store_num(p, static_cast<std::int16_t>(value));
+				}
+				else if (value >= std::numeric_limits<std::int32_t>::min())
+				{
+					*p++ = typecode::int_32;
+					p    = os.store_num(p, static_cast<std::int32_t>(value));
+				}
+				else
+				{
+					*p++ = typecode::int_64;
+					p    = os.store_num(p, static_cast<std::int64_t>(value));
+				}
 			}
+			os.commit(p - window);
 		}
 		return os;
 	}
@@ -598,11 +893,14 @@ struct serializer<T, typename std::enable_if_t<std::is_integral<T>::value && std
 template<>
 struct serializer<float>
 {
-	static obstream&
-	put(obstream& os, float value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, float value)
 	{
-		os.put(typecode::float_32);
-		os.put_num(value);
+		util::byte_type* window = os.reserve(5);
+		*window                 = typecode::float_32;
+		os.store_num(window + 1, value);
+		os.commit(5);
 		return os;
 	}
 };
@@ -610,11 +908,14 @@ struct serializer<float>
 template<>
 struct serializer<double>
 {
-	static obstream&
-	put(obstream& os, double value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, double value)
 	{
-		os.put(typecode::float_64);
-		os.put_num(value);
+		util::byte_type* window = os.reserve(9);
+		*window                 = typecode::float_64;
+		os.store_num(window + 1, value);
+		os.commit(9);
 		return os;
 	}
 };
@@ -622,8 +923,9 @@ struct serializer<double>
 template<>
 struct serializer<bool>
 {
-	static obstream&
-	put(obstream& os, bool value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, bool value)
 	{
 		if (value)
 		{
@@ -640,31 +942,45 @@ struct serializer<bool>
 template<>
 struct serializer<std::string_view>
 {
-	static obstream&
-	put(obstream& os, std::string_view const& value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, std::string_view const& value)
 	{
-		if (value.size() <= 31)
+		if (value.size() <= std::numeric_limits<std::uint8_t>::max())
 		{
-			std::uint8_t code = 0xa0 | static_cast<std::uint8_t>(value.size());
-			os.put(code);
-			os.putn(value.data(), value.size());
-		}
-		else if (value.size() <= std::numeric_limits<std::uint8_t>::max())
-		{
-			os.put(typecode::str_8);
-			os.put_num(static_cast<std::uint8_t>(value.size()));
-			os.putn(value.data(), value.size());
-		}
-		else if (value.size() <= std::numeric_limits<std::uint16_t>::max())
-		{
-			os.put(typecode::str_16);
-			os.put_num(static_cast<std::uint16_t>(value.size()));
-			os.putn(value.data(), value.size());
+			// short strings: header and payload go through one window
+			util::byte_type* window = os.reserve(((value.size() <= 31) ? 1 : 2) + value.size());
+			util::byte_type* p      = window;
+			if (value.size() <= 31)
+			{
+				*p++ = 0xa0 | static_cast<std::uint8_t>(value.size());
+			}
+			else
+			{
+				*p++ = typecode::str_8;
+				*p++ = static_cast<std::uint8_t>(value.size());
+			}
+			if (!value.empty())
+			{
+				::memcpy(p, value.data(), value.size());
+			}
+			os.commit((p - window) + value.size());
 		}
 		else if (value.size() <= std::numeric_limits<std::uint32_t>::max())
 		{
-			os.put(typecode::str_32);
-			os.put_num(static_cast<std::uint32_t>(value.size()));
+			util::byte_type* window = os.reserve(detail::length_header_size(value.size()));
+			util::byte_type* p      = window;
+			if (value.size() <= std::numeric_limits<std::uint16_t>::max())
+			{
+				*p++ = typecode::str_16;
+				p    = os.store_num(p, static_cast<std::uint16_t>(value.size()));
+			}
+			else
+			{
+				*p++ = typecode::str_32;
+				p    = os.store_num(p, static_cast<std::uint32_t>(value.size()));
+			}
+			os.commit(p - window);
 			os.putn(value.data(), value.size());
 		}
 		else
@@ -678,8 +994,9 @@ struct serializer<std::string_view>
 template<>
 struct serializer<util::string_alias>
 {
-	static obstream&
-	put(obstream& os, util::string_alias const& value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, util::string_alias const& value)
 	{
 		return serializer<std::string_view>::put(os, value.view());
 	}
@@ -688,38 +1005,11 @@ struct serializer<util::string_alias>
 template<>
 struct serializer<std::string>
 {
-	static obstream&
-	put(obstream& os, std::string const& value)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, std::string const& value)
 	{
-		if (value.size() <= 31)
-		{
-			std::uint8_t code = 0xa0 | static_cast<std::uint8_t>(value.size());
-			os.put(code);
-			os.putn(value.data(), value.size());
-		}
-		else if (value.size() <= std::numeric_limits<std::uint8_t>::max())
-		{
-			os.put(typecode::str_8);
-			os.put_num(static_cast<std::uint8_t>(value.size()));
-			os.putn(value.data(), value.size());
-		}
-		else if (value.size() <= std::numeric_limits<std::uint16_t>::max())
-		{
-			os.put(typecode::str_16);
-			os.put_num(static_cast<std::uint16_t>(value.size()));
-			os.putn(value.data(), value.size());
-		}
-		else if (value.size() <= std::numeric_limits<std::uint32_t>::max())
-		{
-			os.put(typecode::str_32);
-			os.put_num(static_cast<std::uint32_t>(value.size()));
-			os.putn(value.data(), value.size());
-		}
-		else
-		{
-			throw std::system_error{make_error_code(bstream::errc::string_length_exceeds_limit)};
-		}
-		return os;
+		return serializer<std::string_view>::put(os, value);
 	}
 };
 
@@ -748,19 +1038,55 @@ struct serializer<std::unique_ptr<T>>
 template<class T>
 struct serializer<T, typename std::enable_if_t<std::is_enum<T>::value>>
 {
-	static obstream&
-	put(obstream& os, T val)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, T val)
 	{
 		os << static_cast<typename std::underlying_type<T>::type>(val);
 		return os;
 	}
 };
 
+/*
+ * Encoded size bounds for the fixed-shape primitives above. Integers take a type code
+ * followed by at most sizeof(T) bytes; floating point values are always written in full.
+ */
+
+template<>
+struct max_serialized_size_traits<bool>
+{
+	static constexpr std::size_t value = 1;
+};
+
+template<class T>
+struct max_serialized_size_traits<T, typename std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>>
+{
+	static constexpr std::size_t value = 1 + sizeof(T);
+};
+
+template<>
+struct max_serialized_size_traits<float>
+{
+	static constexpr std::size_t value = 5;
+};
+
+template<>
+struct max_serialized_size_traits<double>
+{
+	static constexpr std::size_t value = 9;
+};
+
+template<class T>
+struct max_serialized_size_traits<T, typename std::enable_if_t<std::is_enum<T>::value>>
+		: public max_serialized_size_traits<typename std::underlying_type<T>::type>
+{};
+
 template<>
 struct serializer<util::buffer>
 {
-	static obstream&
-	put(obstream& os, util::buffer const& val)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, util::buffer const& val)
 	{
 		os.write_blob(val);
 		return os;
@@ -826,8 +1152,13 @@ obstream::write_shared_ptr(std::shared_ptr<T> ptr)
 	}
 	else
 	{
-		if (m_ptr_deduper)
+		if (m_context.dedup_shared_ptrs())
 		{
+			if (!m_ptr_deduper)    // created on first use, so streams that never write shared pointers don't allocate it
+			{
+				m_ptr_deduper = std::make_unique<ptr_deduper>();
+			}
+
 			saved_ptr_info info;
 			if (m_ptr_deduper->is_saved(ptr, info))
 			{
@@ -855,6 +1186,48 @@ obstream::write_shared_ptr(std::shared_ptr<T> ptr)
 	return *this;
 }
 
+namespace detail
+{
+template<class Shape, class Enable = void>
+struct is_bounded_shape : public std::false_type
+{};
+
+template<class Class, class... Bases, class... Members>
+struct is_bounded_shape<
+		streamed_shape<Class, type_list<Bases...>, type_list<Members...>>,
+		typename std::enable_if_t<
+				(has_max_serialized_size<Bases>::value && ...)
+				&& (has_max_serialized_size<std::decay_t<Members>>::value && ...)>> : public std::true_type
+{
+	static constexpr std::size_t size = array_header_size(sizeof...(Bases) + sizeof...(Members))
+			+ (std::size_t{0} + ... + max_serialized_size<Bases>())
+			+ (std::size_t{0} + ... + max_serialized_size<std::decay_t<Members>>());
+};
+
+template<class T, class Shape>
+struct is_bounded_shape_of : public std::false_type
+{};
+
+template<class T, class Bases, class Members>
+struct is_bounded_shape_of<T, streamed_shape<T, Bases, Members>>
+		: public is_bounded_shape<streamed_shape<T, Bases, Members>>
+{};
+}    // namespace detail
+
+/*
+ * A class defined with BSTRM_CLASS is fixed-shape when all of its streamed bases and
+ * members are. The shape must name T itself, so that a class merely derived from a
+ * streamed class doesn't pick up its base's bound.
+ */
+template<class T>
+struct max_serialized_size_traits<
+		T,
+		typename std::enable_if_t<detail::is_bounded_shape_of<T, decltype(T::template _streamed_shape<>())>::value>>
+{
+	static constexpr std::size_t value
+			= detail::is_bounded_shape_of<T, decltype(T::template _streamed_shape<>())>::size;
+};
+
 template<class T>
 inline obstream&
 obstream::write_as_unique_pointer(T* ptr)
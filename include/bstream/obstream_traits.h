@@ -27,6 +27,7 @@
 
 #include <bstream/fwd_decls.h>
 #include <util/traits.h>
+#include <cstddef>
 #include <type_traits>
 
 
@@ -100,6 +101,58 @@ template<class T>
 struct is_serializable<T, std::enable_if_t<has_serializer<T>::value>> : public std::true_type
 {};
 
+/** Upper bound on the encoded size of a fixed-shape type
+ *
+ * A specialization provides a static constexpr member value, the largest number of bytes
+ * that serializing any value of T can produce. Types whose encoding is unbounded (strings,
+ * containers, pointers) have no specialization.
+ */
+template<class T, class Enable = void>
+struct max_serialized_size_traits
+{};
+
+namespace detail
+{
+template<class T>
+static auto
+test_max_serialized_size(int) -> util::traits::sfinae_true_if<decltype(max_serialized_size_traits<T>::value)>;
+template<class>
+static auto
+test_max_serialized_size(long) -> std::false_type;
+}    // namespace detail
+
+template<class T>
+struct has_max_serialized_size : decltype(detail::test_max_serialized_size<T>(0))
+{};
+
+template<class T>
+constexpr std::size_t
+max_serialized_size()
+{
+	return max_serialized_size_traits<std::remove_cv_t<T>>::value;
+}
+
+namespace detail
+{
+constexpr std::size_t
+array_header_size(std::size_t count)
+{
+	return (count < 16) ? 1 : ((count <= 0xffff) ? 3 : 5);
+}
+
+template<class... Types>
+struct type_list
+{};
+
+/*
+ * The streamed shape of a class defined with BSTRM_CLASS: the class itself,
+ * its streamed bases, and the declared types of its streamed members.
+ */
+template<class Class, class Bases, class Members>
+struct streamed_shape
+{};
+}    // namespace detail
+
 }    // namespace bstream
 
 #endif    // BSTREAM_OBSTREAM_TRAITS_H
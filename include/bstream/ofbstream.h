@@ -41,7 +41,9 @@ class ofbstream : public obstream
 public:
 	ofbstream(open_mode mode = file::sink::default_mode, context_base const& context = get_default_context())
 		: obstream{std::make_unique<file::sink>(mode, context.buffer_size(), context.byte_order()), context}
-	{}
+	{
+		apply_huge_pages(context);
+	}
 
 	ofbstream(ofbstream const&) = delete;
 	ofbstream(ofbstream&&)      = delete;
@@ -57,7 +59,9 @@ public:
 						   get_default_context().buffer_size(),
 						   get_default_context().byte_order()),
 				   get_default_context()}
-	{}
+	{
+		apply_huge_pages(get_default_context());
+	}
 
 	ofbstream(std::string const& filename, std::error_code& err)
 		: obstream{std::make_unique<file::sink>(
@@ -67,7 +71,9 @@ public:
 						   get_default_context().byte_order(),
 						   err),
 				   get_default_context()}
-	{}
+	{
+		apply_huge_pages(get_default_context());
+	}
 
 	ofbstream(std::string const& filename, open_mode mode)
 		: obstream{std::make_unique<file::sink>(
@@ -76,7 +82,9 @@ public:
 						   get_default_context().buffer_size(),
 						   get_default_context().byte_order()),
 				   get_default_context()}
-	{}
+	{
+		apply_huge_pages(get_default_context());
+	}
 
 	ofbstream(std::string const& filename, open_mode mode, std::error_code& err)
 		: obstream{std::make_unique<file::sink>(
@@ -86,15 +94,21 @@ public:
 						   get_default_context().byte_order(),
 						   err),
 				   get_default_context()}
-	{}
+	{
+		apply_huge_pages(get_default_context());
+	}
 
 	ofbstream(std::string const& filename, open_mode mode, context_base const& context)
 		: obstream{std::make_unique<file::sink>(filename, mode, context.buffer_size(), context.byte_order()), context}
-	{}
+	{
+		apply_huge_pages(context);
+	}
 
 	ofbstream(std::string const& filename, open_mode mode, context_base const& context, std::error_code& err)
 		: obstream{std::make_unique<file::sink>(filename, mode, context.buffer_size(), context.byte_order(), err), context}
-	{}
+	{
+		apply_huge_pages(context);
+	}
 
 	void
 	open(std::string const& filename, open_mode mode)
@@ -169,6 +183,14 @@ public:
 	}
 
 protected:
+	void
+	apply_huge_pages(context_base const& context)
+	{
+		if (context.huge_pages())
+		{
+			get_filebuf().huge_pages(true);
+		}
+	}
 };
 
 }    // namespace bstream
@@ -44,21 +44,28 @@ public:
 	{}
 
 	ombstream(util::mutable_buffer&& buf, context_base const& context = get_default_context())
-		: obstream{std::make_unique<buffer::sink>(std::move(buf), context.byte_order()), context}
-	{}
+		: obstream{std::make_unique<buffer::sink>(std::move(buf), context.byte_order(), context.buffer_growth()), context}
+	{
+		get_sink().huge_pages(context.huge_pages());
+	}
 
 	ombstream(util::size_type size, context_base const& context = get_default_context())
-		: ombstream(std::make_unique<buffer::sink>(size, context.byte_order()), context)
-	{}
+		: ombstream(std::make_unique<buffer::sink>(size, context.byte_order(), context.buffer_growth()), context)
+	{
+		get_sink().huge_pages(context.huge_pages());
+	}
 
 	ombstream(context_base const& context = get_default_context())
 		: ombstream{std::make_unique<buffer::sink>(
 							util::mutable_buffer{
 									context.buffer_size(),
 							},
-							context.byte_order()),
+							context.byte_order(),
+							context.buffer_growth()),
 					context}
-	{}
+	{
+		get_sink().huge_pages(context.huge_pages());
+	}
 
 	util::const_buffer
 	get_buffer()
@@ -0,0 +1,180 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_SEGMENT_POOL_H
+#define BSTREAM_SEGMENT_POOL_H
+
+#include <bstream/types.h>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#ifndef BSTREAM_SEGMENT_POOL_LOCAL_CACHE_SIZE
+#define BSTREAM_SEGMENT_POOL_LOCAL_CACHE_SIZE 16UL
+#endif
+
+#ifndef BSTREAM_SEGMENT_POOL_DEFAULT_LIMIT
+#define BSTREAM_SEGMENT_POOL_DEFAULT_LIMIT 1024UL
+#endif
+
+namespace bstream
+{
+
+/** Recycling pool of fixed-size memory segments
+ *
+ * There is one pool per segment size, obtained with instance(); pools live for the
+ * duration of the program. Each thread keeps a small cache of free segments per pool,
+ * so allocation and deallocation normally take no lock. When a thread's cache fills,
+ * half of it moves to the pool's global free list; when it empties, it refills from
+ * there. The global list holds at most limit() segments, and segments beyond that are
+ * returned to the system. A segment may be deallocated by a different thread than the
+ * one that allocated it.
+ *
+ * The pool is normally used through segment_pool_allocator, which lets util::mutable_buffer
+ * (and so bufseq::sink) draw segments from it.
+ * A buffer's segment returns to the pool when the last reference to the buffer drops.
+ */
+class segment_pool
+{
+public:
+	segment_pool(segment_pool const&) = delete;
+	segment_pool&
+	operator=(segment_pool const&)
+			= delete;
+
+	static segment_pool&
+	instance(util::size_type segment_size);
+
+	util::size_type
+	segment_size() const noexcept
+	{
+		return m_segment_size;
+	}
+
+	util::byte_type*
+	allocate();
+
+	void
+	deallocate(util::byte_type* segment) noexcept;
+
+	std::size_t
+	limit() const;
+
+	void
+	limit(std::size_t max_segments);
+
+	/*
+	 * Number of free segments on the global list; segments in thread caches aren't counted.
+	 */
+	std::size_t
+	global_count() const;
+
+	/*
+	 * Returns all segments on the global list to the system.
+	 */
+	void
+	trim();
+
+private:
+	class thread_cache;
+
+	segment_pool(util::size_type segment_size, std::size_t index);
+
+	static thread_cache*
+	local_cache();
+
+	void
+	put_global(util::byte_type** segments, std::size_t n) noexcept;
+
+	std::size_t
+	get_global(util::byte_type** segments, std::size_t n);
+
+	util::size_type               m_segment_size;
+	std::size_t                   m_index;
+	mutable std::mutex            m_mutex;
+	std::vector<util::byte_type*> m_free;
+	std::size_t                   m_limit;
+};
+
+/** Allocator drawing segments of its pool's size from a segment_pool
+ *
+ * Requests of any other size go to operator new.
+ */
+class segment_pool_allocator
+{
+public:
+	using value_type      = util::byte_type;
+	using pointer         = util::byte_type*;
+	using const_pointer   = const util::byte_type*;
+	using size_type       = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	explicit segment_pool_allocator(segment_pool& pool) noexcept : m_pool{&pool} {}
+
+	explicit segment_pool_allocator(util::size_type segment_size) : m_pool{&segment_pool::instance(segment_size)} {}
+
+	pointer
+	allocate(size_type n)
+	{
+		return (n == m_pool->segment_size()) ? m_pool->allocate() : static_cast<pointer>(::operator new(n));
+	}
+
+	void
+	deallocate(pointer p, size_type n) noexcept
+	{
+		if (n == m_pool->segment_size())
+		{
+			m_pool->deallocate(p);
+		}
+		else
+		{
+			::operator delete(p);
+		}
+	}
+
+	segment_pool&
+	pool() const noexcept
+	{
+		return *m_pool;
+	}
+
+	bool
+	operator==(segment_pool_allocator const& rhs) const noexcept
+	{
+		return m_pool == rhs.m_pool;
+	}
+
+	bool
+	operator!=(segment_pool_allocator const& rhs) const noexcept
+	{
+		return m_pool != rhs.m_pool;
+	}
+
+private:
+	segment_pool* m_pool;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_SEGMENT_POOL_H
@@ -0,0 +1,56 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_SERIALIZED_SIZE_H
+#define BSTREAM_SERIALIZED_SIZE_H
+
+#include <bstream/basic_obstream.h>
+#include <bstream/null/sink.h>
+#include <bstream/obstream.h>
+#include <memory>
+
+
+namespace bstream
+{
+
+/** Exact number of bytes that serializing obj produces
+ *
+ * The object is run through its serializer into a null sink, which counts bytes without
+ * storing them. The result can be used to presize the buffer of an ombstream or a
+ * buffer::sink. For fixed-shape types, max_serialized_size<T>() (see obstream_traits.h)
+ * gives a compile-time upper bound instead.
+ */
+
+template<class T>
+inline util::size_type
+serialized_size(T const& obj, context_base const& context = get_default_context())
+{
+	basic_obstream<null::sink> os{std::make_unique<null::sink>(context.byte_order()), context};
+	os << obj;
+	return os.size();
+}
+
+}    // namespace bstream
+
+#endif    // BSTREAM_SERIALIZED_SIZE_H
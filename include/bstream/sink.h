@@ -26,9 +26,12 @@
 #define BSTREAM_SINK_H
 
 #include <boost/endian/conversion.hpp>
+#include <cassert>
+#include <cstring>
 #include <bstream/types.h>
 #include <util/buffer.h>
 #include <system_error>
+#include <vector>
 
 namespace bend = boost::endian;
 
@@ -40,6 +43,9 @@ namespace detail
 class sink_test_probe;
 }
 
+template<class Sink, class Policy, class Order>
+class basic_obstream;
+
 /** Base buffer class for binary output streams
  * 
  * This class is designed to be the base class for all binary output stream buffer classes.
@@ -93,7 +99,10 @@ class sink_test_probe;
  * dirty
  * dirty is a boolean value associated with the stream buffer. dirty is true if the buffer's internal
  * sequence contains values that have not been synchronized (flushed) with the output sequence.
- * After a flush operation, dirty is always false.
+ * After a flush operation, dirty is always false. A sink that writes its output
+ * sequence asynchronously (file::async_sink) may also override really_drain(), which
+ * flush() invokes afterward to wait for the writes to complete. The implicit flushes
+ * made when the internal sequence overflows or the position changes don't wait.
  * 
  * dirty_start
  * if dirty is true, dirty_start is a pointer indicating the first byte in the internal sequence
@@ -141,6 +150,9 @@ class sink
 public:
 	friend class detail::sink_test_probe;
 
+	template<class Sink, class Policy, class Order>
+	friend class bstream::basic_obstream;
+
 	sink(util::byte_type* data, util::size_type size, byte_order order = byte_order::big_endian);
 
 	sink(sink const&) = delete;
@@ -166,16 +178,80 @@ public:
 	flush();
 
 	void
-	put(util::byte_type byte, std::error_code& err);
+	put(util::byte_type byte, std::error_code& err)
+	{
+		err.clear();
+		if (m_did_jump || m_next >= m_end)
+		{
+			put_slow(byte, err);
+		}
+		else
+		{
+			if (!m_dirty)
+			{
+				m_dirty_start = m_next;
+				m_dirty       = true;
+			}
+			*m_next++ = byte;
+		}
+	}
 
 	void
-	put(util::byte_type byte);
+	put(util::byte_type byte)
+	{
+		if (m_did_jump || m_next >= m_end)
+		{
+			put_slow(byte);
+		}
+		else
+		{
+			if (!m_dirty)
+			{
+				m_dirty_start = m_next;
+				m_dirty       = true;
+			}
+			*m_next++ = byte;
+		}
+	}
 
 	void
-	putn(const util::byte_type* src, util::size_type n, std::error_code& err);
+	putn(const util::byte_type* src, util::size_type n, std::error_code& err)
+	{
+		err.clear();
+		if (m_did_jump || n < 1 || n > static_cast<util::size_type>(m_end - m_next))
+		{
+			putn_slow(src, n, err);
+		}
+		else
+		{
+			if (!m_dirty)
+			{
+				m_dirty_start = m_next;
+				m_dirty       = true;
+			}
+			::memcpy(m_next, src, n);
+			m_next += n;
+		}
+	}
 
 	void
-	putn(const util::byte_type* src, util::size_type n);
+	putn(const util::byte_type* src, util::size_type n)
+	{
+		if (m_did_jump || n < 1 || n > static_cast<util::size_type>(m_end - m_next))
+		{
+			putn_slow(src, n);
+		}
+		else
+		{
+			if (!m_dirty)
+			{
+				m_dirty_start = m_next;
+				m_dirty       = true;
+			}
+			::memcpy(m_next, src, n);
+			m_next += n;
+		}
+	}
 
 	void
 	putn(util::buffer const& buf)
@@ -189,6 +265,15 @@ public:
 		putn(buf.data(), buf.size(), err);
 	}
 
+	/** Appends the contents of buf to the output sequence. Sinks that can hold a
+	 * reference to buf (bufseq::sink) do so without copying it; all others copy.
+	 */
+	void
+	splice(util::shared_buffer const& buf, std::error_code& err);
+
+	void
+	splice(util::shared_buffer const& buf);
+
 	template<class U>
 	typename std::enable_if<std::is_arithmetic<U>::value && sizeof(U) == 1>::type
 	put_num(U value)
@@ -204,306 +289,180 @@ public:
 	}
 
 	template<class U>
-	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) == 2)>
+	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) > 1)>
 	put_num(U value)
 	{
 		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
 
-		using byte_vec = util::byte_type[usize];
+		auto cval = detail::to_canonical(value);
+		cval      = m_reverse ? bend::endian_reverse(cval) : cval;
 
-		if (m_did_jump)
+		if (m_did_jump || (m_end - m_next) < static_cast<std::ptrdiff_t>(usize))
 		{
-			std::error_code err;
-			really_jump(err);
-			if (err)
-				throw std::system_error{err};
+			putn_slow(reinterpret_cast<util::byte_type*>(&cval), usize);
 		}
-
-		if ((m_end - m_next) >= usize)
+		else
 		{
 			if (!m_dirty)
 			{
 				m_dirty_start = m_next;
 				m_dirty       = true;
 			}
-
-			if (m_reverse)
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-			}
-			else
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-			}
-		}
-		else
-		{
-			ctype cval = m_reverse ? bend::endian_reverse(reinterpret_cast<ctype&>(value))
-								   : reinterpret_cast<ctype&>(value);
-			putn(reinterpret_cast<util::byte_type*>(&cval), usize);
+			::memcpy(m_next, &cval, usize);
+			m_next += usize;
 		}
 	}
 
 	template<class U>
-	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) == 2)>
+	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) > 1)>
 	put_num(U value, std::error_code& err)
 	{
 		err.clear();
 		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
 
-		using byte_vec = util::byte_type[usize];
+		auto cval = detail::to_canonical(value);
+		cval      = m_reverse ? bend::endian_reverse(cval) : cval;
 
-		if (m_did_jump)
+		if (m_did_jump || (m_end - m_next) < static_cast<std::ptrdiff_t>(usize))
 		{
-			really_jump(err);
-			if (err)
-				goto exit;
+			putn_slow(reinterpret_cast<util::byte_type*>(&cval), usize, err);
 		}
-
-		if ((m_end - m_next) >= usize)
+		else
 		{
 			if (!m_dirty)
 			{
 				m_dirty_start = m_next;
 				m_dirty       = true;
 			}
+			::memcpy(m_next, &cval, usize);
+			m_next += usize;
+		}
+	}
 
-			if (m_reverse)
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-			}
-			else
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-			}
+	/*
+	 * Writes n numbers from src in the sink's byte order. If no swap is needed, this is
+	 * equivalent to putn(); otherwise, runs of values are byte-swapped directly into the
+	 * internal sequence.
+	 */
+
+	template<class U>
+	typename std::enable_if_t<std::is_arithmetic<U>::value>
+	put_num_array(const U* src, util::size_type n)
+	{
+		if (sizeof(U) == 1 || !m_reverse)
+		{
+			putn(reinterpret_cast<const util::byte_type*>(src), n * sizeof(U));
 		}
 		else
 		{
-			ctype cval = m_reverse ? bend::endian_reverse(reinterpret_cast<ctype&>(value))
-								   : reinterpret_cast<ctype&>(value);
-			putn(reinterpret_cast<util::byte_type*>(&cval), usize, err);
+			put_reversed(reinterpret_cast<const util::byte_type*>(src), n, sizeof(U));
 		}
-
-	exit:
-		return;
 	}
 
 	template<class U>
-	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) == 4)>
-	put_num(U value)
+	typename std::enable_if_t<std::is_arithmetic<U>::value>
+	put_num_array(const U* src, util::size_type n, std::error_code& err)
 	{
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
-
-		using byte_vec = util::byte_type[usize];
-
-		if (m_did_jump)
+		if (sizeof(U) == 1 || !m_reverse)
 		{
-			std::error_code err;
-			really_jump(err);
-			if (err)
-				throw std::system_error{err};
-		}
-
-		if ((m_end - m_next) >= usize)
-		{
-			if (!m_dirty)
-			{
-				m_dirty_start = m_next;
-				m_dirty       = true;
-			}
-
-			if (m_reverse)
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-			}
-			else
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-			}
+			putn(reinterpret_cast<const util::byte_type*>(src), n * sizeof(U), err);
 		}
 		else
 		{
-			ctype cval = m_reverse ? bend::endian_reverse(reinterpret_cast<ctype&>(value))
-								   : reinterpret_cast<ctype&>(value);
-			putn(reinterpret_cast<util::byte_type*>(&cval), usize);
+			put_reversed(reinterpret_cast<const util::byte_type*>(src), n, sizeof(U), err);
 		}
 	}
 
-	template<class U>
-	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) == 4)>
-	put_num(U value, std::error_code& err)
+	/*
+	 * reserve() returns a window of at least n writable bytes at the current position, and
+	 * commit() publishes the first k bytes written to it. Every reserve() must be followed by
+	 * exactly one commit() before any other operation on the sink.
+	 *
+	 * The window is normally in the internal sequence. If n contiguous bytes can't be made
+	 * available there (for instance, when the window would straddle a segment boundary in a
+	 * bufseq::sink), the window is a scratch area, and commit() copies it into the sink.
+	 */
+
+	util::byte_type*
+	reserve(util::size_type n, std::error_code& err)
 	{
 		err.clear();
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
-
-		using byte_vec = util::byte_type[usize];
-
-		if (m_did_jump)
+		if (m_did_jump || n > static_cast<util::size_type>(m_end - m_next))
 		{
-			really_jump(err);
-			if (err)
-				goto exit;
+			return reserve_slow(n, err);
 		}
+		return m_next;
+	}
 
-		if ((m_end - m_next) >= usize)
-		{
-			if (!m_dirty)
-			{
-				m_dirty_start = m_next;
-				m_dirty       = true;
-			}
-
-			if (m_reverse)
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-			}
-			else
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-			}
-		}
-		else
+	util::byte_type*
+	reserve(util::size_type n)
+	{
+		if (m_did_jump || n > static_cast<util::size_type>(m_end - m_next))
 		{
-			ctype cval = m_reverse ? bend::endian_reverse(reinterpret_cast<ctype&>(value))
-								   : reinterpret_cast<ctype&>(value);
-			putn(reinterpret_cast<util::byte_type*>(&cval), usize, err);
+			return reserve_slow(n);
 		}
-	exit:
-		return;
+		return m_next;
 	}
 
-	template<class U>
-	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) == 8)>
-	put_num(U value)
+	void
+	commit(util::size_type k, std::error_code& err)
 	{
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
-
-		using byte_vec = util::byte_type[usize];
-
-		if (m_did_jump)
+		err.clear();
+		if (m_scratch_window)
 		{
-			std::error_code err;
-			really_jump(err);
-			if (err)
-				throw std::system_error{err};
+			commit_slow(k, err);
 		}
-
-		if ((m_end - m_next) >= usize)
+		else if (k > 0)
 		{
+			assert(k <= static_cast<util::size_type>(m_end - m_next));
 			if (!m_dirty)
 			{
 				m_dirty_start = m_next;
 				m_dirty       = true;
 			}
-
-			if (m_reverse)
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[7];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[6];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[5];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[4];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-			}
-			else
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[4];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[5];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[6];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[7];
-			}
-		}
-		else
-		{
-			ctype cval = m_reverse ? bend::endian_reverse(reinterpret_cast<ctype&>(value))
-								   : reinterpret_cast<ctype&>(value);
-			putn(reinterpret_cast<util::byte_type*>(&cval), usize);
+			m_next += k;
 		}
 	}
 
-	template<class U>
-	typename std::enable_if_t<std::is_arithmetic<U>::value && (sizeof(U) == 8)>
-	put_num(U value, std::error_code& err)
+	void
+	commit(util::size_type k)
 	{
-		err.clear();
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
-
-		using byte_vec = util::byte_type[usize];
-
-		if (m_did_jump)
+		if (m_scratch_window)
 		{
-			really_jump(err);
-			if (err)
-				goto exit;
+			commit_slow(k);
 		}
-
-		if ((m_end - m_next) >= usize)
+		else if (k > 0)
 		{
+			assert(k <= static_cast<util::size_type>(m_end - m_next));
 			if (!m_dirty)
 			{
 				m_dirty_start = m_next;
 				m_dirty       = true;
 			}
+			m_next += k;
+		}
+	}
 
-			if (m_reverse)
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[7];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[6];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[5];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[4];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-			}
-			else
-			{
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[0];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[1];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[2];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[3];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[4];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[5];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[6];
-				*m_next++ = reinterpret_cast<byte_vec&>(value)[7];
-			}
+	/*
+	 * Stores value at dst in the sink's byte order, and returns the address following it.
+	 * Intended for filling a window obtained from reserve().
+	 */
+
+	template<class U>
+	typename std::enable_if_t<std::is_arithmetic<U>::value, util::byte_type*>
+	store_num(util::byte_type* dst, U value) const noexcept
+	{
+		if (sizeof(U) == 1)
+		{
+			*dst = static_cast<util::byte_type>(value);
 		}
 		else
 		{
-			ctype cval = m_reverse ? bend::endian_reverse(reinterpret_cast<ctype&>(value))
-								   : reinterpret_cast<ctype&>(value);
-			putn(reinterpret_cast<util::byte_type*>(&cval), usize, err);
+			auto cval = detail::to_canonical(value);
+			cval      = m_reverse ? bend::endian_reverse(cval) : cval;
+			::memcpy(dst, &cval, sizeof(U));
 		}
-	exit:
-		return;
+		return dst + sizeof(U);
 	}
 
 	void
@@ -539,7 +498,85 @@ public:
 		return really_get_size();
 	}
 
+	/*
+	 * Discards the output at and beyond pos, which must not be past the end. Afterwards,
+	 * both the size and the current position are pos.
+	 */
+
+	void
+	truncate(util::position_type pos, std::error_code& err);
+
+	void
+	truncate(util::position_type pos);
+
+	/*
+	 * When eager jumps are enabled, position() resolves a change of position immediately
+	 * (including zero-filling up to a position past the high watermark), rather than deferring
+	 * it to the next write. A jump is never pending afterwards, which lets basic_obstream
+	 * drop the pending-jump check from its write paths.
+	 *
+	 * The output is the same either way: the zero-filled gap past the high watermark is
+	 * not part of the output, and size() doesn't include it, until something is written
+	 * past it. A later jump back leaves it out, as it would a deferred jump.
+	 */
+
+	bool
+	eager_jumps() const noexcept
+	{
+		return m_eager_jumps;
+	}
+
+	void
+	eager_jumps(bool flag)
+	{
+		m_eager_jumps = flag;
+		if (m_eager_jumps && m_did_jump)
+		{
+			std::error_code err;
+			jump_eagerly(err);
+			if (err)
+			{
+				throw std::system_error{err};
+			}
+		}
+	}
+
 protected:
+	/*
+	 * Out-of-line paths for put() and putn(), taken when a pending jump must be
+	 * resolved or the internal sequence can't hold the request.
+	 */
+
+	void
+	put_slow(util::byte_type byte, std::error_code& err);
+
+	void
+	put_slow(util::byte_type byte);
+
+	void
+	putn_slow(const util::byte_type* src, util::size_type n, std::error_code& err);
+
+	void
+	putn_slow(const util::byte_type* src, util::size_type n);
+
+	void
+	put_reversed(const util::byte_type* src, util::size_type n, std::size_t width, std::error_code& err);
+
+	void
+	put_reversed(const util::byte_type* src, util::size_type n, std::size_t width);
+
+	util::byte_type*
+	reserve_slow(util::size_type n, std::error_code& err);
+
+	util::byte_type*
+	reserve_slow(util::size_type n);
+
+	void
+	commit_slow(util::size_type k, std::error_code& err);
+
+	void
+	commit_slow(util::size_type k);
+
 	void
 	set_ptrs(util::byte_type* base, util::byte_type* next, util::byte_type* end)
 	{
@@ -548,6 +585,17 @@ protected:
 		m_end  = end;
 	}
 
+	/*
+	 * Synchronizes the internal sequence with the output sequence, as flush() does,
+	 * without waiting for really_drain().
+	 */
+
+	void
+	flush_buffer(std::error_code& err);
+
+	void
+	flush_buffer();
+
 	void
 	overflow(util::size_type requested, std::error_code& err);
 
@@ -591,6 +639,12 @@ protected:
 	void
 	really_fill(util::byte_type fill_byte, util::size_type n);
 
+	/*
+	 * Resolves a pending jump for eager jumps; see eager_jumps().
+	 */
+	void
+	jump_eagerly(std::error_code& err);
+
 	util::position_type
 	new_position(util::offset_type offset, seek_anchor where) const;
 
@@ -604,12 +658,38 @@ protected:    // to be overridden by derived classes
 	virtual void
 	really_overflow(util::size_type, std::error_code& err);
 
+	/*
+	 * Returns false if really_overflow() can never make room past the end of the current
+	 * internal sequence. reserve() then fails a window that doesn't fit instead of building
+	 * a scratch window for it. The default assumes the sink can grow.
+	 */
+	virtual bool
+	can_grow() const;
+
 	virtual void
 	really_flush(std::error_code& err);
 
+	virtual void
+	really_drain(std::error_code& err);
+
+	/*
+	 * Offered a write of n bytes that doesn't fit in the internal sequence, a derived
+	 * class may write some or all of them to the output sequence itself, bypassing the
+	 * internal sequence, and return how many it wrote. The rest are copied through the
+	 * internal sequence. The default writes none.
+	 */
+	virtual util::size_type
+	really_write_direct(const util::byte_type* src, util::size_type n, std::error_code& err);
+
 	virtual util::size_type
 	really_get_size() const;
 
+	virtual void
+	really_splice(util::shared_buffer const& buf, std::error_code& err);
+
+	virtual void
+	really_truncate(util::position_type pos, std::error_code& err);
+
 protected:
 	util::position_type m_base_offset;
 	util::position_type m_high_watermark;
@@ -621,6 +701,38 @@ protected:
 	bool          m_dirty;
 	bool          m_did_jump;
 	bool          m_reverse;
+	bool          m_eager_jumps;
+	bool          m_scratch_window;
+
+	std::vector<util::byte_type> m_window;
+};
+
+/** Compile-time write policies for basic_obstream
+ *
+ * checked_sink_policy keeps the full jump and dirty bookkeeping on every write, and is
+ * correct for any sink.
+ *
+ * memory_sink_policy is for sinks whose output sequence is the internal sequence itself
+ * (buffer::sink, bufseq::sink). Jumps are resolved eagerly, so writes never test for a
+ * pending jump.
+ *
+ * Both policies keep dirty_start, so the sink's flush invariants hold whichever one is used.
+ */
+
+struct checked_sink_policy
+{
+	static constexpr bool eager_jumps = false;
+};
+
+struct memory_sink_policy
+{
+	static constexpr bool eager_jumps = true;
+};
+
+template<class Sink>
+struct default_sink_policy
+{
+	using type = checked_sink_policy;
 };
 
 }    // namespace bstream
@@ -26,8 +26,13 @@
 #define BSTREAM_SOURCE_H
 
 #include <boost/endian/conversion.hpp>
+#include <cassert>
+#include <cstring>
+#include <bstream/buffer_chain.h>
+#include <bstream/error.h>
 #include <bstream/types.h>
 #include <util/buffer.h>
+#include <vector>
 
 namespace bend = boost::endian;
 
@@ -40,14 +45,28 @@ namespace detail
 class source_test_probe;
 }
 
+template<class Source, class Order>
+class basic_ibstream;
+
 class source
 {
 
 public:
 	friend class detail::source_test_probe;
 
+	template<class Source, class Order>
+	friend class bstream::basic_ibstream;
+
 	source(const util::byte_type* buf, util::size_type size, byte_order order = byte_order::big_endian)
-		: m_base_offset{0}, m_base{buf}, m_next{buf}, m_end{buf + size}, m_reverse{is_reverse(order)}
+		: m_base_offset{0},
+		  m_base{buf},
+		  m_next{buf},
+		  m_end{buf + size},
+		  m_reverse{is_reverse(order)},
+		  m_in_window{false},
+		  m_saved_base{nullptr},
+		  m_saved_next{nullptr},
+		  m_saved_end{nullptr}
 	{}
 
 	source(source const&) = delete;
@@ -67,8 +86,14 @@ protected:
 		  m_base{rhs.m_base},
 		  m_next{rhs.m_next},
 		  m_end{rhs.m_end},
-		  m_reverse{rhs.m_reverse}
+		  m_reverse{rhs.m_reverse},
+		  m_in_window{false},
+		  m_saved_base{nullptr},
+		  m_saved_next{nullptr},
+		  m_saved_end{nullptr},
+		  m_window{std::move(rhs.m_window)}
 	{
+		assert(!rhs.m_in_window);
 		rhs.m_base_offset = 0;
 		rhs.m_base        = nullptr;
 		rhs.m_next        = nullptr;
@@ -79,16 +104,30 @@ public:
 	virtual ~source() {}
 
 	util::byte_type
-	get(std::error_code& err);
+	get(std::error_code& err)
+	{
+		err.clear();
+		return (m_next < m_end) ? *m_next++ : get_slow(err);
+	}
 
 	util::byte_type
-	get();
+	get()
+	{
+		return (m_next < m_end) ? *m_next++ : get_slow();
+	}
 
 	util::byte_type
-	peek(std::error_code& err);
+	peek(std::error_code& err)
+	{
+		err.clear();
+		return (m_next < m_end) ? *m_next : peek_slow(err);
+	}
 
 	util::byte_type
-	peek();
+	peek()
+	{
+		return (m_next < m_end) ? *m_next : peek_slow();
+	}
 
 	virtual util::shared_buffer
 	get_shared_slice(util::size_type n, std::error_code& err);
@@ -102,11 +141,40 @@ public:
 	virtual util::const_buffer
 	get_slice(util::size_type n);
 
+	/** Reads n bytes as a chain of shared buffers. Sources that hold their data
+	 * in shared segments (bufseq::source<util::shared_buffer>) reference each
+	 * spanned segment; others return a single copied segment.
+	 */
+	virtual buffer_chain
+	get_slice_chain(util::size_type n, std::error_code& err);
+
+	virtual buffer_chain
+	get_slice_chain(util::size_type n);
+
 	util::size_type
-	getn(util::byte_type* dst, util::size_type n, std::error_code& err);
+	getn(util::byte_type* dst, util::size_type n, std::error_code& err)
+	{
+		err.clear();
+		if (n > 0 && n <= static_cast<util::size_type>(m_end - m_next))
+		{
+			::memcpy(dst, m_next, n);
+			m_next += n;
+			return n;
+		}
+		return getn_slow(dst, n, err);
+	}
 
 	util::size_type
-	getn(util::byte_type* dst, util::size_type n);
+	getn(util::byte_type* dst, util::size_type n)
+	{
+		if (n > 0 && n <= static_cast<util::size_type>(m_end - m_next))
+		{
+			::memcpy(dst, m_next, n);
+			m_next += n;
+			return n;
+		}
+		return getn_slow(dst, n);
+	}
 
 	template<class U>
 	typename std::enable_if<std::is_arithmetic<U>::value && sizeof(U) == 1, U>::type
@@ -123,218 +191,156 @@ public:
 	}
 
 	template<class U>
-	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) == 2), U>::type
+	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) > 1), U>::type
 	get_num()
 	{
 		constexpr std::size_t usize = sizeof(U);
 		using ctype                 = typename detail::canonical_type<usize>::type;
 
-		using byte_vec = util::byte_type[usize];
 		ctype cval;
-		if (m_end - m_next >= usize)
+		if ((m_end - m_next) >= static_cast<std::ptrdiff_t>(usize))
 		{
-			if (m_reverse)
-			{
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-			}
-			else
-			{
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-			}
+			::memcpy(&cval, m_next, usize);
+			m_next += usize;
 		}
 		else
 		{
-			getn(reinterpret_cast<util::byte_type*>(&cval), usize);
-			cval = m_reverse ? bend::endian_reverse(cval) : cval;
+			getn_slow(reinterpret_cast<util::byte_type*>(&cval), usize);
 		}
-		return reinterpret_cast<U&>(cval);
+		cval = m_reverse ? bend::endian_reverse(cval) : cval;
+		return detail::from_canonical<U>(cval);
 	}
 
 	template<class U>
-	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) == 2), U>::type
+	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) > 1), U>::type
 	get_num(std::error_code& err)
 	{
 		err.clear();
 		constexpr std::size_t usize = sizeof(U);
 		using ctype                 = typename detail::canonical_type<usize>::type;
 
-		using byte_vec = util::byte_type[usize];
 		ctype cval;
-		if (m_end - m_next >= usize)
+		if ((m_end - m_next) >= static_cast<std::ptrdiff_t>(usize))
 		{
-			if (m_reverse)
-			{
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-			}
-			else
-			{
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-			}
+			::memcpy(&cval, m_next, usize);
+			m_next += usize;
 		}
 		else
 		{
-			getn(reinterpret_cast<util::byte_type*>(&cval), usize, err);
-			cval = m_reverse ? bend::endian_reverse(cval) : cval;
+			getn_slow(reinterpret_cast<util::byte_type*>(&cval), usize, err);
 		}
-		return reinterpret_cast<U&>(cval);
+		cval = m_reverse ? bend::endian_reverse(cval) : cval;
+		return detail::from_canonical<U>(cval);
 	}
 
-	template<class U>
-	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) == 4), U>::type
-	get_num()
-	{
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
+	/*
+	 * ensure() returns a pointer to at least n contiguous readable bytes at the current
+	 * position, without consuming them; advance() then consumes the first k of them. Every
+	 * ensure() must be followed by exactly one advance() before any other operation on the
+	 * source.
+	 *
+	 * The window is normally in the internal sequence. If the n bytes straddle the end of
+	 * the internal sequence (a bufseq segment boundary, or a file buffer refill), they are
+	 * stitched together in a scratch area, which then stands in as the internal sequence
+	 * until its bytes have been read. Bytes advance() leaves unconsumed are read from there,
+	 * so the source never has to seek back, and a failed ensure() leaves the position as it
+	 * was.
+	 */
 
-		using byte_vec = util::byte_type[usize];
-		ctype cval;
-		if (m_end - m_next >= usize)
+	const util::byte_type*
+	ensure(util::size_type n, std::error_code& err)
+	{
+		err.clear();
+		if (n > static_cast<util::size_type>(m_end - m_next))
 		{
-			if (m_reverse)
-			{
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-			}
-			else
-			{
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-			}
+			return ensure_slow(n, err);
 		}
-		else
+		return m_next;
+	}
+
+	const util::byte_type*
+	ensure(util::size_type n)
+	{
+		if (n > static_cast<util::size_type>(m_end - m_next))
 		{
-			getn(reinterpret_cast<util::byte_type*>(&cval), usize);
-			cval = m_reverse ? bend::endian_reverse(cval) : cval;
+			return ensure_slow(n);
 		}
-		return reinterpret_cast<U&>(cval);
+		return m_next;
 	}
 
-	template<class U>
-	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) == 4), U>::type
-	get_num(std::error_code& err)
+	void
+	advance(util::size_type k, std::error_code& err)
 	{
 		err.clear();
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
+		assert(k <= static_cast<util::size_type>(m_end - m_next));
+		m_next += k;
+	}
 
-		using byte_vec = util::byte_type[usize];
-		ctype cval;
-		if (m_end - m_next >= usize)
+	void
+	advance(util::size_type k)
+	{
+		assert(k <= static_cast<util::size_type>(m_end - m_next));
+		m_next += k;
+	}
+
+	/*
+	 * Loads a number stored at src in the source's byte order. Intended for reading from a
+	 * window obtained from ensure().
+	 */
+
+	template<class U>
+	typename std::enable_if_t<std::is_arithmetic<U>::value, U>
+	load_num(const util::byte_type* src) const noexcept
+	{
+		if (sizeof(U) == 1)
 		{
-			if (m_reverse)
-			{
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-			}
-			else
-			{
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-			}
+			return static_cast<U>(*src);
 		}
 		else
 		{
-			getn(reinterpret_cast<util::byte_type*>(&cval), usize, err);
+			typename detail::canonical_type<sizeof(U)>::type cval;
+			::memcpy(&cval, src, sizeof(U));
 			cval = m_reverse ? bend::endian_reverse(cval) : cval;
+			return detail::from_canonical<U>(cval);
 		}
-		return reinterpret_cast<U&>(cval);
 	}
 
+	/*
+	 * Reads n numbers into dst, converting from the source's byte order. If no swap is needed,
+	 * this is equivalent to getn(); otherwise, runs of values are byte-swapped directly out of
+	 * the internal sequence.
+	 */
+
 	template<class U>
-	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) == 8), U>::type
-	get_num()
+	typename std::enable_if_t<std::is_arithmetic<U>::value>
+	get_num_array(U* dst, util::size_type n)
 	{
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
-
-		using byte_vec = util::byte_type[usize];
-		ctype cval;
-		if (m_end - m_next >= usize)
+		if (sizeof(U) == 1 || !m_reverse)
 		{
-			if (m_reverse)
-			{
-				reinterpret_cast<byte_vec&>(cval)[7] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[6] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[5] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[4] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-			}
-			else
-			{
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[4] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[5] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[6] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[7] = *m_next++;
-			}
+			getn(reinterpret_cast<util::byte_type*>(dst), n * sizeof(U));
 		}
 		else
 		{
-			getn(reinterpret_cast<util::byte_type*>(&cval), usize);
-			cval = m_reverse ? bend::endian_reverse(cval) : cval;
+			get_reversed(reinterpret_cast<util::byte_type*>(dst), n, sizeof(U));
 		}
-		return reinterpret_cast<U&>(cval);
 	}
 
 	template<class U>
-	typename std::enable_if<std::is_arithmetic<U>::value && (sizeof(U) == 8), U>::type
-	get_num(std::error_code& err)
+	typename std::enable_if_t<std::is_arithmetic<U>::value>
+	get_num_array(U* dst, util::size_type n, std::error_code& err)
 	{
-		err.clear();
-		constexpr std::size_t usize = sizeof(U);
-		using ctype                 = typename detail::canonical_type<usize>::type;
-
-		using byte_vec = util::byte_type[usize];
-		ctype cval;
-		if (m_end - m_next >= usize)
+		if (sizeof(U) == 1 || !m_reverse)
 		{
-			if (m_reverse)
+			auto nbytes = n * sizeof(U);
+			if (getn(reinterpret_cast<util::byte_type*>(dst), nbytes, err) < nbytes && !err)
 			{
-				reinterpret_cast<byte_vec&>(cval)[7] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[6] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[5] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[4] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-			}
-			else
-			{
-				reinterpret_cast<byte_vec&>(cval)[0] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[1] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[2] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[3] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[4] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[5] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[6] = *m_next++;
-				reinterpret_cast<byte_vec&>(cval)[7] = *m_next++;
+				err = make_error_code(bstream::errc::read_past_end_of_stream);
 			}
 		}
 		else
 		{
-			getn(reinterpret_cast<util::byte_type*>(&cval), usize, err);
-			cval = m_reverse ? bend::endian_reverse(cval) : cval;
+			get_reversed(reinterpret_cast<util::byte_type*>(dst), n, sizeof(U), err);
 		}
-		return reinterpret_cast<U&>(cval);
 	}
 
 	util::size_type
@@ -352,6 +358,10 @@ public:
 	void
 	rewind()
 	{
+		if (m_in_window)
+		{
+			leave_window();
+		}
 		really_rewind();
 	}
 
@@ -382,6 +392,69 @@ public:
 	position() const;
 
 protected:
+	/*
+	 * Out-of-line paths for get(), peek() and getn(), taken when the
+	 * internal sequence is exhausted and must be refilled by underflow().
+	 */
+
+	util::byte_type
+	get_slow(std::error_code& err);
+
+	util::byte_type
+	get_slow();
+
+	util::byte_type
+	peek_slow(std::error_code& err);
+
+	util::byte_type
+	peek_slow();
+
+	util::size_type
+	getn_slow(util::byte_type* dst, util::size_type n, std::error_code& err);
+
+	util::size_type
+	getn_slow(util::byte_type* dst, util::size_type n);
+
+	void
+	get_reversed(util::byte_type* dst, util::size_type n, std::size_t width, std::error_code& err);
+
+	void
+	get_reversed(util::byte_type* dst, util::size_type n, std::size_t width);
+
+	const util::byte_type*
+	ensure_slow(util::size_type n, std::error_code& err);
+
+	const util::byte_type*
+	ensure_slow(util::size_type n);
+
+	/*
+	 * Makes the first n bytes of m_window the internal sequence, saving the one it
+	 * stands in front of.
+	 */
+	void
+	enter_window(util::size_type n);
+
+	/*
+	 * Returns to the saved internal sequence, dropping any bytes left in the window.
+	 */
+	void
+	leave_window();
+
+	/*
+	 * Returns true while bytes stitched together by ensure() are still unread in the
+	 * scratch window. A window that has been read through is left first. Derived classes
+	 * that work on the internal sequence of their own buffers check this first.
+	 */
+	bool
+	window_pending()
+	{
+		if (m_in_window && m_next == m_end)
+		{
+			leave_window();
+		}
+		return m_in_window;
+	}
+
 	const util::byte_type*
 	gbump(util::offset_type offset)
 	{
@@ -392,14 +465,12 @@ protected:
 	util::position_type
 	gpos() const
 	{
-		return m_base_offset + (m_next - m_base);
+		return m_in_window ? m_base_offset + (m_saved_next - m_saved_base) - (m_end - m_next)
+						   : m_base_offset + (m_next - m_base);
 	}
 
 	util::size_type
-	underflow(std::error_code& err)
-	{
-		return really_underflow(err);
-	}
+	underflow(std::error_code& err);
 
 	util::size_type
 	underflow();
@@ -407,9 +478,10 @@ protected:
 	void
 	set_ptrs(const util::byte_type* base, const util::byte_type* next, const util::byte_type* end)
 	{
-		m_base = base;
-		m_next = next;
-		m_end  = end;
+		m_in_window = false;    // a new internal sequence replaces a scratch window
+		m_base      = base;
+		m_next      = next;
+		m_end       = end;
 	}
 
 	virtual util::size_type
@@ -433,11 +505,26 @@ protected:
 	virtual void
 	really_rewind();
 
+	/*
+	 * Offered a read of n bytes with the internal sequence exhausted, a derived class
+	 * may read some or all of them from the input sequence straight into dst, bypassing
+	 * the internal sequence, and return how many it read. The rest are read through
+	 * underflow(). The default reads none.
+	 */
+	virtual util::size_type
+	really_read_direct(util::byte_type* dst, util::size_type n, std::error_code& err);
+
 	util::position_type    m_base_offset;
 	const util::byte_type* m_base;
 	const util::byte_type* m_next;
 	const util::byte_type* m_end;
 	bool             m_reverse;
+	bool                   m_in_window;     // the internal sequence is in m_window
+	const util::byte_type* m_saved_base;    // the internal sequence m_window stands in front of
+	const util::byte_type* m_saved_next;
+	const util::byte_type* m_saved_end;
+
+	std::vector<util::byte_type> m_window;
 };
 
 }    // namespace bstream
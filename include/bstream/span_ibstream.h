@@ -0,0 +1,96 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_SPAN_IBSTREAM_H
+#define BSTREAM_SPAN_IBSTREAM_H
+
+#include <bstream/basic_ibstream.h>
+#include <bstream/span_source.h>
+#include <memory>
+
+
+namespace bstream
+{
+
+namespace detail
+{
+/*
+ * Holds the source ahead of the stream base in span_ibstream, so the source is
+ * constructed before, and destroyed after, the stream that reads from it.
+ */
+struct span_source_holder
+{
+	span_source_holder(const util::byte_type* data, util::size_type size, byte_order order)
+		: m_span_source{data, size, order}
+	{}
+
+	span_source m_span_source;
+};
+}    // namespace detail
+
+/** Binary input stream over a caller-owned byte range
+ *
+ * The source is stored in the stream object, and reads from the caller's bytes in
+ * place, so decoding a message performs no heap allocation of its own. The bytes must
+ * outlive the stream.
+ */
+class span_ibstream : private detail::span_source_holder, public basic_ibstream<span_source>
+{
+	using holder = detail::span_source_holder;
+
+public:
+	using base = basic_ibstream<span_source>;
+
+	span_ibstream(span_ibstream const&) = delete;
+	span_ibstream(span_ibstream&&)      = delete;
+
+	span_ibstream(
+			const util::byte_type* data,
+			util::size_type        size,
+			context_base const&    context = get_default_context())
+		: holder{data, size, context.byte_order()},
+		  base{std::unique_ptr<span_source>{&m_span_source}, context}
+	{}
+
+	span_ibstream(std::string_view bytes, context_base const& context = get_default_context())
+		: span_ibstream{reinterpret_cast<const util::byte_type*>(bytes.data()), bytes.size(), context}
+	{}
+
+	span_ibstream(std::vector<std::uint8_t> const& bytes, context_base const& context = get_default_context())
+		: span_ibstream{bytes.data(), bytes.size(), context}
+	{}
+
+	~span_ibstream()
+	{
+		// m_source points at the holder's span_source, which is destroyed with the holder
+		m_source.release();
+	}
+
+private:
+	using base::release_source;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_SPAN_IBSTREAM_H
@@ -0,0 +1,70 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_SPAN_SOURCE_H
+#define BSTREAM_SPAN_SOURCE_H
+
+#include <bstream/source.h>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace bstream
+{
+
+/** Source that reads directly from a caller-owned byte range
+ *
+ * The bytes are neither copied nor owned, and must outlive the source. Reading,
+ * positioning and ensure() windows all work in place, without allocating.
+ */
+class span_source : public bstream::source
+{
+public:
+	using base = bstream::source;
+
+	span_source(const util::byte_type* data, util::size_type size, byte_order order = byte_order::big_endian)
+		: base{data, size, order}
+	{}
+
+	span_source(std::string_view bytes, byte_order order = byte_order::big_endian)
+		: base{reinterpret_cast<const util::byte_type*>(bytes.data()), bytes.size(), order}
+	{}
+
+	span_source(std::vector<std::uint8_t> const& bytes, byte_order order = byte_order::big_endian)
+		: base{bytes.data(), bytes.size(), order}
+	{}
+
+	span_source(span_source&&)      = delete;
+	span_source(span_source const&) = delete;
+	span_source&
+	operator=(span_source&&)
+			= delete;
+	span_source&
+	operator=(span_source const&)
+			= delete;
+};
+
+}    // namespace bstream
+
+#endif    // BSTREAM_SPAN_SOURCE_H
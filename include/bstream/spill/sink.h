@@ -0,0 +1,146 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_SPILL_SINK_H
+#define BSTREAM_SPILL_SINK_H
+
+#include <bstream/bufseq/sink.h>
+#include <bstream/source.h>
+#include <memory>
+#include <string>
+
+#ifndef BSTREAM_DEFAULT_SPILL_THRESHOLD
+#define BSTREAM_DEFAULT_SPILL_THRESHOLD (64UL * 1024UL * 1024UL)
+#endif
+
+namespace bstream
+{
+namespace spill
+{
+
+/** Memory segment sink that spills to an unlinked temporary file past a threshold
+ *
+ * Output accumulates in fixed-size segments, exactly as in bufseq::sink, until holding
+ * it would take more than threshold bytes of segments. At that point the sink creates
+ * an unlinked temporary file in directory (TMPDIR or /tmp if empty), writes the segments
+ * to it and releases all but one, which is kept as the write buffer for the file. From
+ * then on, memory use stays at one segment. Positioning, including positions beyond the
+ * end, works the same before and after spilling.
+ *
+ * get_buffers() and release_buffers() are only available before spilling; get_source()
+ * reads the output back in either state.
+ */
+class sink : public bufseq::sink
+{
+public:
+	using base = bufseq::sink;
+
+	sink(util::size_type    threshold    = BSTREAM_DEFAULT_SPILL_THRESHOLD,
+		 util::size_type    segment_size = BSTREAM_MEMORY_DEFAULT_BUFFER_SIZE,
+		 std::string const& directory    = std::string{},
+		 byte_order         order        = byte_order::big_endian);
+
+	sink(sink&&)      = delete;
+	sink(sink const&) = delete;
+	sink&
+	operator=(sink&&)
+			= delete;
+	sink&
+	operator=(sink const&)
+			= delete;
+
+	virtual ~sink();
+
+	bool
+	is_spilled() const noexcept
+	{
+		return m_fd >= 0;
+	}
+
+	util::size_type
+	threshold() const noexcept
+	{
+		return m_threshold;
+	}
+
+	/*
+	 * Discards all output. If the sink has spilled, the temporary file is closed
+	 * (and so deleted) and writing starts over in memory.
+	 */
+	sink&
+	clear() noexcept;
+
+	buffers&
+	get_buffers();
+
+	buffers
+	release_buffers();
+
+	/*
+	 * A source over everything written so far. Before spilling, it reads copies of the
+	 * segments; afterwards, it reads the temporary file through a duplicated descriptor,
+	 * which shares its file offset with any other source obtained from this sink.
+	 */
+
+	std::unique_ptr<bstream::source>
+	get_source(std::error_code& err);
+
+	std::unique_ptr<bstream::source>
+	get_source();
+
+protected:
+	virtual void
+	really_jump(std::error_code& err) override;
+
+	virtual void
+	really_overflow(util::size_type, std::error_code& err) override;
+
+	virtual void
+	really_flush(std::error_code& err) override;
+
+	virtual void
+	really_splice(util::shared_buffer const& buf, std::error_code& err) override;
+
+	virtual void
+	really_truncate(util::position_type pos, std::error_code& err) override;
+
+	void
+	spill(std::error_code& err);
+
+	void
+	open_temp_file(std::error_code& err);
+
+	void
+	write_at(const util::byte_type* src, util::size_type n, util::position_type pos, std::error_code& err);
+
+	util::size_type m_threshold;
+	std::string     m_directory;
+	byte_order      m_order;
+	int             m_fd;
+};
+
+}    // namespace spill
+}    // namespace bstream
+
+#endif    // BSTREAM_SPILL_SINK_H
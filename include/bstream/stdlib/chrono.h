@@ -75,8 +75,9 @@ template<class Rep, class Ratio>
 struct serializer<std::chrono::duration<Rep, Ratio>>
 {
 	using duration_type = std::chrono::duration<Rep, Ratio>;
-	static obstream&
-	put(obstream& os, duration_type val)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, duration_type val)
 	{
 		os << val.count();
 		return os;
@@ -87,8 +88,9 @@ template<class Clock, class Duration>
 struct serializer<std::chrono::time_point<Clock, Duration>>
 {
 	using time_point_type = std::chrono::time_point<Clock, Duration>;
-	static obstream&
-	put(obstream& os, time_point_type val)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, time_point_type val)
 	{
 		os << val.time_since_epoch().count();
 		return os;
@@ -57,8 +57,9 @@ struct value_deserializer<std::deque<T, Alloc>, typename std::enable_if_t<is_ibs
 template<class T, class Alloc>
 struct serializer<std::deque<T, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::deque<T, Alloc>& deq)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::deque<T, Alloc>& deq)
 	{
 		os.write_array_header(deq.size());
 		for (auto it = deq.begin(); it != deq.end(); ++it)
@@ -59,8 +59,9 @@ struct value_deserializer<std::forward_list<T, Alloc>, typename std::enable_if_t
 template<class T, class Alloc>
 struct serializer<std::forward_list<T, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::forward_list<T, Alloc>& flist)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::forward_list<T, Alloc>& flist)
 	{
 		auto length = std::distance(flist.begin(), flist.end());
 		os.write_array_header(length);
@@ -58,8 +58,9 @@ struct value_deserializer<std::list<T, Alloc>, typename std::enable_if_t<is_ibst
 template<class T, class Alloc>
 struct serializer<std::list<T, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::list<T, Alloc>& lst)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::list<T, Alloc>& lst)
 	{
 		os.write_array_header(lst.size());
 		for (auto it = lst.begin(); it != lst.end(); ++it)
@@ -88,8 +88,9 @@ struct value_deserializer<
 template<class K, class V, class Compare, class Alloc>
 struct serializer<std::map<K, V, Compare, Alloc>>
 {
-	static obstream&
-	put(obstream& os, std::map<K, V, Compare, Alloc> const& mp)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, std::map<K, V, Compare, Alloc> const& mp)
 	{
 		os.write_array_header(mp.size());
 		for (auto it = mp.begin(); it != mp.end(); ++it)
@@ -105,8 +106,9 @@ struct serializer<std::map<K, V, Compare, Alloc>>
 template<class K, class V, class Compare, class Alloc>
 struct serializer<std::multimap<K, V, Compare, Alloc>>
 {
-	static obstream&
-	put(obstream& os, std::multimap<K, V, Compare, Alloc> const& mp)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, std::multimap<K, V, Compare, Alloc> const& mp)
 	{
 		os.write_array_header(mp.size());
 		for (auto it = mp.begin(); it != mp.end(); ++it)
@@ -126,8 +126,9 @@ struct value_deserializer<
 template<class T1, class T2>
 struct serializer<std::pair<T1, T2>>
 {
-	static obstream&
-	put(obstream& os, std::pair<T1, T2> const& p)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, std::pair<T1, T2> const& p)
 	{
 		os.write_array_header(2);
 		os << p.first;
@@ -136,6 +137,14 @@ struct serializer<std::pair<T1, T2>>
 	}
 };
 
+template<class T1, class T2>
+struct max_serialized_size_traits<
+		std::pair<T1, T2>,
+		typename std::enable_if_t<has_max_serialized_size<T1>::value && has_max_serialized_size<T2>::value>>
+{
+	static constexpr std::size_t value = 1 + max_serialized_size<T1>() + max_serialized_size<T2>();
+};
+
 }    // namespace bstream
 
 #endif    // BSTREAM_STDLIB_PAIR_H
\ No newline at end of file
@@ -80,8 +80,9 @@ struct value_deserializer<std::multiset<T, Compare, Alloc>, typename std::enable
 template<class T, class Compare, class Alloc>
 struct serializer<std::set<T, Compare, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::set<T, Compare, Alloc>& s)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::set<T, Compare, Alloc>& s)
 	{
 		os.write_array_header(s.size());
 		for (auto it = s.begin(); it != s.end(); ++it)
@@ -95,8 +96,9 @@ struct serializer<std::set<T, Compare, Alloc>>
 template<class T, class Compare, class Alloc>
 struct serializer<std::multiset<T, Compare, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::multiset<T, Compare, Alloc>& s)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::multiset<T, Compare, Alloc>& s)
 	{
 		os.write_array_header(s.size());
 		for (auto it = s.begin(); it != s.end(); ++it)
@@ -75,30 +75,40 @@ template<class... Args>
 struct serializer<std::tuple<Args...>>
 {
 	using tuple_type = std::tuple<Args...>;
-	static obstream&
-	put(obstream& os, tuple_type const& tup)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, tuple_type const& tup)
 	{
 		os.write_array_header(std::tuple_size<tuple_type>::value);
-		put_members<0, Args...>(os, tup);
+		put_members<Stream, 0, Args...>(os, tup);
 		return os;
 	}
 
-	template<unsigned int N, class First, class... Rest>
+	template<class Stream, unsigned int N, class First, class... Rest>
 	static typename std::enable_if<(sizeof...(Rest) > 0)>::type
-	put_members(obstream& os, tuple_type const& tup)
+	put_members(Stream& os, tuple_type const& tup)
 	{
 		os << std::get<N>(tup);
-		put_members<N + 1, Rest...>(os, tup);
+		put_members<Stream, N + 1, Rest...>(os, tup);
 	}
 
-	template<unsigned int N, class T>
+	template<class Stream, unsigned int N, class T>
 	static void
-	put_members(obstream& os, tuple_type const& tup)
+	put_members(Stream& os, tuple_type const& tup)
 	{
 		os << std::get<N>(tup);
 	}
 };
 
+template<class... Args>
+struct max_serialized_size_traits<
+		std::tuple<Args...>,
+		typename std::enable_if_t<(has_max_serialized_size<Args>::value && ...)>>
+{
+	static constexpr std::size_t value
+			= detail::array_header_size(sizeof...(Args)) + (std::size_t{0} + ... + max_serialized_size<Args>());
+};
+
 }    // namespace bstream
 
 #endif    // BSTREAM_STDLIB_TUPLE_H
\ No newline at end of file
@@ -93,8 +93,9 @@ struct value_deserializer<
 template<class K, class V, class Hash, class Equal, class Alloc>
 struct serializer<std::unordered_map<K, V, Hash, Equal, Alloc>>
 {
-	static obstream&
-	put(obstream& os, std::unordered_map<K, V, Hash, Equal, Alloc> const& map)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, std::unordered_map<K, V, Hash, Equal, Alloc> const& map)
 	{
 		os.write_array_header(map.size());
 		for (auto it = map.begin(); it != map.end(); ++it)
@@ -108,8 +109,9 @@ struct serializer<std::unordered_map<K, V, Hash, Equal, Alloc>>
 template<class K, class V, class Hash, class Equal, class Alloc>
 struct serializer<std::unordered_multimap<K, V, Hash, Equal, Alloc>>
 {
-	static obstream&
-	put(obstream& os, std::unordered_multimap<K, V, Hash, Equal, Alloc> const& map)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, std::unordered_multimap<K, V, Hash, Equal, Alloc> const& map)
 	{
 		os.write_array_header(map.size());
 		for (auto it = map.begin(); it != map.end(); ++it)
@@ -84,8 +84,9 @@ struct value_deserializer<
 template<class T, class Hash, class Equal, class Alloc>
 struct serializer<std::unordered_set<T, Hash, Equal, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::unordered_set<T, Hash, Equal, Alloc>& s)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::unordered_set<T, Hash, Equal, Alloc>& s)
 	{
 		os.write_array_header(s.size());
 		for (auto it = s.begin(); it != s.end(); ++it)
@@ -99,8 +100,9 @@ struct serializer<std::unordered_set<T, Hash, Equal, Alloc>>
 template<class T, class Hash, class Equal, class Alloc>
 struct serializer<std::unordered_multiset<T, Hash, Equal, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::unordered_multiset<T, Hash, Equal, Alloc>& s)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::unordered_multiset<T, Hash, Equal, Alloc>& s)
 	{
 		os.write_array_header(s.size());
 		for (auto it = s.begin(); it != s.end(); ++it)
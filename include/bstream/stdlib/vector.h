@@ -59,8 +59,9 @@ struct value_deserializer<std::vector<T, Alloc>, typename std::enable_if_t<is_ib
 template<class T, class Alloc>
 struct serializer<std::vector<T, Alloc>>
 {
-	static obstream&
-	put(obstream& os, const std::vector<T, Alloc>& vec)
+	template<class Stream>
+	static Stream&
+	put(Stream& os, const std::vector<T, Alloc>& vec)
 	{
 		os.write_array_header(vec.size());
 		for (auto it = vec.begin(); it != vec.end(); ++it)
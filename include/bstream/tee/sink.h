@@ -0,0 +1,144 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BSTREAM_TEE_SINK_H
+#define BSTREAM_TEE_SINK_H
+
+#include <bstream/sink.h>
+#include <util/buffer.h>
+#include <vector>
+
+#ifndef BSTREAM_DEFAULT_TEE_BUFFER_SIZE
+#define BSTREAM_DEFAULT_TEE_BUFFER_SIZE 16384UL
+#endif
+
+namespace bstream
+{
+namespace tee
+{
+
+/** Sink that copies its output to several downstream sinks
+ *
+ * Values are encoded once, into the tee's own buffer. Each flush (including the
+ * implicit flush when the buffer fills) writes the flushed region to every target
+ * and then flushes the target, so after flush() all targets hold the same output.
+ *
+ * Positions are relative to where each target stood when it was added, so a target
+ * that already holds output (a log file opened at its end, for instance) receives
+ * the tee's output after it. Seeking the tee repositions the targets at the next
+ * flush; a target that can't seek to that position reports the error from flush.
+ * splice() is forwarded to each target's own splice(), so a bufseq::sink target
+ * still holds a reference to the spliced buffer rather than a copy.
+ *
+ * The targets are not owned, and must outlive the tee or be removed by clear_targets().
+ */
+class sink : public bstream::sink
+{
+public:
+	using base = bstream::sink;
+
+	sink(util::size_type buffer_size = BSTREAM_DEFAULT_TEE_BUFFER_SIZE, byte_order order = byte_order::big_endian);
+
+	sink(std::vector<bstream::sink*> const& targets,
+		 util::size_type                    buffer_size = BSTREAM_DEFAULT_TEE_BUFFER_SIZE,
+		 byte_order                         order       = byte_order::big_endian);
+
+	sink(sink&&)      = delete;
+	sink(sink const&) = delete;
+	sink&
+	operator=(sink&&)
+			= delete;
+	sink&
+	operator=(sink const&)
+			= delete;
+
+	/** Adds target, which receives whatever is written from now on, starting at
+	 * its current position. Output written earlier is not replayed to it. Pending
+	 * output is flushed to the existing targets first.
+	 */
+	sink&
+	add_target(bstream::sink& target, std::error_code& err);
+
+	sink&
+	add_target(bstream::sink& target);
+
+	void
+	clear_targets() noexcept
+	{
+		m_targets.clear();
+	}
+
+	util::size_type
+	target_count() const noexcept
+	{
+		return m_targets.size();
+	}
+
+protected:
+	struct target
+	{
+		bstream::sink*      sink;
+		util::position_type origin;
+	};
+
+	virtual void
+	really_flush(std::error_code& err) override;
+
+	virtual void
+	really_jump(std::error_code& err) override;
+
+	virtual void
+	really_overflow(util::size_type, std::error_code& err) override;
+
+	virtual bool
+	is_valid_position(util::position_type pos) const override;
+
+	virtual void
+	really_splice(util::shared_buffer const& buf, std::error_code& err) override;
+
+	/** Truncates every target at the corresponding position.
+	 */
+	virtual void
+	really_truncate(util::position_type pos, std::error_code& err) override;
+
+	/** Moves each target to the position corresponding to pos, if it isn't there already.
+	 */
+	void
+	align_targets(util::position_type pos, std::error_code& err);
+
+	void
+	reset_ptrs()
+	{
+		util::byte_type* base = m_buf.data();
+		set_ptrs(base, base, base + m_buf.capacity());
+	}
+
+	util::mutable_buffer m_buf;
+	std::vector<target>  m_targets;
+};
+
+}    // namespace tee
+}    // namespace bstream
+
+#endif    // BSTREAM_TEE_SINK_H
@@ -25,9 +25,11 @@
 #ifndef BSTREAM_TYPES_H
 #define BSTREAM_TYPES_H
 
+#include <algorithm>
 #include <array>
 #include <boost/endian/conversion.hpp>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <util/types.h>
 #include <system_error>
@@ -71,6 +73,60 @@ is_reverse(byte_order order)
 		   != ((order == byte_order::big_endian) ? boost::endian::order::big : boost::endian::order::little);
 }
 
+/*
+ * The byte order of the host. Streams that never leave a closed system may use it to avoid
+ * swapping multi-byte numbers altogether, at the cost of msgpack compatibility on hosts
+ * that aren't big-endian.
+ */
+static constexpr byte_order native_byte_order
+		= (boost::endian::order::native == boost::endian::order::big) ? byte_order::big_endian : byte_order::little_endian;
+
+/*
+ * Byte order selectors for basic_obstream and basic_ibstream. With runtime_byte_order, the
+ * order is taken from the sink or source (as set from the context); fixed_byte_order makes it
+ * a compile-time constant of the stream type.
+ */
+
+struct runtime_byte_order
+{
+	static constexpr bool is_fixed = false;
+	static constexpr bool reverse  = false;
+};
+
+template<byte_order Order>
+struct fixed_byte_order
+{
+	static constexpr bool       is_fixed = true;
+	static constexpr bool       reverse  = is_reverse(Order);
+	static constexpr byte_order order    = Order;
+};
+
+/*
+ * Growth steps for expandable memory sinks (buffer::sink). Growing to hold required bytes
+ * targets required * factor, but each step adds at least min_step bytes and, if max_step
+ * is nonzero, at most max_step bytes beyond what is required.
+ */
+struct growth_policy
+{
+	double          factor   = 1.5;
+	util::size_type min_step = 16;
+	util::size_type max_step = 0;
+
+	util::size_type
+	next_capacity(util::size_type capacity, util::size_type required) const
+	{
+		auto target = static_cast<util::size_type>(static_cast<double>(required) * factor);
+		auto step   = (target > capacity) ? target - capacity : 0;
+		step        = std::max(step, min_step);
+		auto result = std::max(capacity + step, required);
+		if (max_step > 0)
+		{
+			result = std::min(result, std::max(capacity, required) + max_step);
+		}
+		return result;
+	}
+};
+
 struct as_shared_buffer
 {};
 struct as_const_buffer
@@ -108,6 +164,24 @@ struct canonical_type<8>
 	using type = std::uint64_t;
 };
 
+template<class U>
+inline typename canonical_type<sizeof(U)>::type
+to_canonical(U value) noexcept
+{
+	typename canonical_type<sizeof(U)>::type cval;
+	::memcpy(&cval, &value, sizeof(U));
+	return cval;
+}
+
+template<class U>
+inline U
+from_canonical(typename canonical_type<sizeof(U)>::type cval) noexcept
+{
+	U value;
+	::memcpy(&value, &cval, sizeof(U));
+	return value;
+}
+
 }    // namespace detail
 
 }    // namespace bstream
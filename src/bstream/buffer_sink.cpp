@@ -23,22 +23,114 @@
  */
 
 #include <bstream/buffer/sink.h>
+#include <bstream/huge_pages.h>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 
 using namespace bstream;
 
+namespace
+{
+
+/*
+ * Lets util::mutable_buffer adopt a block buffer::sink grew on the heap: the first
+ * allocation returns that block, later ones (when the buffer expands) come from the same
+ * heap, malloc or huge pages, so the buffer can free and grow the block it was handed.
+ */
+class heap_block_allocator
+{
+public:
+	using value_type      = util::byte_type;
+	using pointer         = util::byte_type*;
+	using const_pointer   = const util::byte_type*;
+	using size_type       = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	heap_block_allocator(pointer block, bool huge) noexcept : m_block{block}, m_huge{huge} {}
+
+	pointer
+	allocate(size_type n)
+	{
+		pointer result = m_block;
+		m_block        = nullptr;
+		if (result == nullptr)
+		{
+			result = m_huge ? huge_pages::allocate(n) : static_cast<pointer>(::malloc(n));
+			if (result == nullptr)
+			{
+				throw std::bad_alloc{};
+			}
+		}
+		return result;
+	}
+
+	void
+	deallocate(pointer p, size_type n) noexcept
+	{
+		if (m_huge)
+		{
+			huge_pages::deallocate(p, n);
+		}
+		else
+		{
+			::free(p);
+		}
+	}
+
+	bool
+	operator==(heap_block_allocator const& rhs) const noexcept
+	{
+		return m_huge == rhs.m_huge;
+	}
+
+	bool
+	operator!=(heap_block_allocator const& rhs) const noexcept
+	{
+		return !(*this == rhs);
+	}
+
+private:
+	pointer m_block;
+	bool    m_huge;
+};
+
+}    // namespace
+
+buffer::sink::~sink()
+{
+	free_heap();
+}
+
+void
+buffer::sink::free_heap() noexcept
+{
+	if (m_heap && m_heap_owned)
+	{
+		if (m_heap_huge)
+		{
+			huge_pages::deallocate(m_heap, m_heap_capacity);
+		}
+		else
+		{
+			::free(m_heap);
+		}
+	}
+}
+
 void
 buffer::sink::really_overflow(util::size_type n, std::error_code& err)
 {
 	err.clear();
 	assert(std::less_equal<util::byte_type*>()(m_next, m_end));
-	assert((m_next - m_base) + n > m_buf.size());
+	assert((m_next - m_base) + n > capacity());
 	auto      pos      = ppos();
 	util::size_type required = (m_next - m_base) + n;
 	resize(required, err);
 	if (!err)
 	{
-		auto new_base = m_buf.data();
-		set_ptrs(new_base, new_base + pos, new_base + m_buf.capacity());
+		auto new_base = storage();
+		set_ptrs(new_base, new_base + pos, new_base + capacity());
 	}
 }
 
@@ -46,32 +138,82 @@ void
 buffer::sink::resize(util::size_type size, std::error_code& err)
 {
 	err.clear();
-	util::size_type cushioned_size = (size * 3) / 2;
+	auto new_capacity = m_growth.next_capacity(capacity(), size);
 
-	if (!m_buf.is_expandable())
+	if (!m_use_heap)
 	{
-		err = make_error_code(std::errc::no_buffer_space);
+		if (!m_buf.is_expandable())
+		{
+			err = make_error_code(std::errc::no_buffer_space);
+			goto exit;
+		}
+		m_buf.expand(new_capacity);
+		if (m_buf.capacity() < size)
+		{
+			err = make_error_code(std::errc::no_buffer_space);
+		}
 		goto exit;
 	}
 
-	// force a hard lower bound to avoid non-resizing dilemma in resizing, when cushioned == size == 1
-	m_buf.expand(std::max(16UL, cushioned_size));
-
-	if (m_buf.capacity() < cushioned_size)
 	{
-		err = make_error_code(std::errc::no_buffer_space);
-		goto exit;
+		bool huge = m_huge_pages && new_capacity >= huge_pages::min_size;
+		if (huge)
+		{
+			new_capacity = huge_pages::round_up(new_capacity);
+		}
+
+		util::byte_type* heap = nullptr;
+		if (m_heap && m_heap_owned && huge == m_heap_huge)
+		{
+			heap = huge ? huge_pages::reallocate(m_heap, m_heap_capacity, new_capacity)
+						: static_cast<util::byte_type*>(::realloc(m_heap, new_capacity));
+		}
+		else
+		{
+			// moving off m_buf, off storage shared with a buffer handed to the caller,
+			// or between malloc'd and huge-page storage
+			heap = huge ? huge_pages::allocate(new_capacity) : static_cast<util::byte_type*>(::malloc(new_capacity));
+			// past the high watermark, an eager jump may have left a zero-filled gap
+			auto used = std::min(static_cast<util::size_type>(std::max(get_high_watermark(), ppos())), capacity());
+			if (heap && used > 0)
+			{
+				::memcpy(heap, storage(), used);
+			}
+			if (heap)
+			{
+				free_heap();
+			}
+		}
+		if (heap == nullptr)
+		{
+			err = make_error_code(std::errc::not_enough_memory);
+			goto exit;
+		}
+		m_heap          = heap;
+		m_heap_capacity = new_capacity;
+		m_heap_owned    = true;
+		m_heap_huge     = huge;
 	}
 
 exit:
 	return;
 }
 
+void
+buffer::sink::sync_buffer()
+{
+	if (m_heap && m_heap_owned)
+	{
+		m_buf        = util::mutable_buffer{m_heap_capacity, heap_block_allocator{m_heap, m_heap_huge}};
+		m_heap_owned = false;
+	}
+}
+
 bool
 buffer::sink::is_valid_position(util::position_type pos) const
 {
 	bool result = false;
-	if (m_buf.is_expandable())
+	if (m_use_heap || m_buf.is_expandable())
 	{
 		result = pos >= 0;
 	}
@@ -99,6 +241,7 @@ buffer::sink::get_buffer()
 	{
 		flush();
 	}
+	sync_buffer();
 	m_buf.size(get_high_watermark());
 	return util::const_buffer{m_buf};
 }
@@ -110,6 +253,7 @@ buffer::sink::get_buffer_ref()
 	{
 		flush();
 	}
+	sync_buffer();
 	m_buf.size(get_high_watermark());
 	return m_buf;
 }
@@ -121,10 +265,13 @@ buffer::sink::release_buffer()
 	{
 		flush();
 	}
+	sync_buffer();
 	m_buf.size(get_high_watermark());
 	reset_high_water_mark();
-	m_did_jump = false;
-	m_dirty    = false;
+	m_did_jump      = false;
+	m_dirty         = false;
+	m_heap          = nullptr;
+	m_heap_capacity = 0;
 	set_ptrs(nullptr, nullptr, nullptr);
 	return util::const_buffer{std::move(m_buf)};
 }
@@ -136,10 +283,17 @@ buffer::sink::release_mutable_buffer()
 	{
 		flush();
 	}
-	m_buf.size(get_high_watermark());
+	// heap storage is handed over as is, not copied
+	sync_buffer();
+	auto                 size   = static_cast<util::size_type>(get_high_watermark());
+	util::mutable_buffer result = std::move(m_buf);
+	result.size(size);
 	reset_high_water_mark();
-	m_did_jump = false;
-	m_dirty    = false;
+	m_did_jump      = false;
+	m_dirty         = false;
+	m_heap          = nullptr;
+	m_heap_capacity = 0;
+	m_heap_owned    = false;
 	set_ptrs(nullptr, nullptr, nullptr);
-	return std::move(m_buf);
+	return result;
 }
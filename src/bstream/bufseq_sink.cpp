@@ -23,6 +23,14 @@
  */
 
 #include <bstream/bufseq/sink.h>
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 
 using namespace bstream;
 
@@ -30,29 +38,101 @@ void
 bufseq::sink::really_overflow(util::size_type n, std::error_code& err)
 {
 	err.clear();
-	if (m_base == nullptr)
+	if (m_base == nullptr)    // buffers were released
 	{
 		assert(m_bufs.size() == 0);
 		assert(m_current == 0);
 		assert(get_high_watermark() == 0);
-		assert(m_did_jump = false);
-		assert(m_dirty = false);
-		assert(m_base_offset = 0);
-		m_bufs.emplace_back(m_factory->create());
+		add_segment();
 		reset_ptrs();
+		goto exit;
 	}
-	assert(ppos() == (m_current + 1) * m_segment_capacity);
-	m_bufs[m_current].size(m_segment_capacity);
+	assert(ppos() == m_offsets[m_current + 1]);
+	m_bufs[m_current].size(segment_capacity(m_current));
 	if (m_current == m_bufs.size() - 1)    // last buffer in deque, extend deque
 	{
-		m_bufs.emplace_back(m_factory->create());
+		add_segment();
 	}
 	else
 	{
-		assert(get_high_watermark() > ppos());
+		// the next segment holds output, or the gap an eager jump zero-filled
+		unshare(m_current + 1);
 	}
 	++m_current;
 	reset_ptrs();
+
+exit:
+	return;
+}
+
+void
+bufseq::sink::add_segment()
+{
+	auto capacity = next_segment_capacity();
+	m_bufs.emplace_back(m_factory->create(capacity));
+	m_offsets.push_back(m_offsets.back() + capacity);
+	m_last_capacity = capacity;
+}
+
+void
+bufseq::sink::reset_segments()
+{
+	if (m_bufs.empty())
+	{
+		m_offsets.resize(1);
+		add_segment();
+	}
+	else
+	{
+		m_bufs.resize(1);
+		// a spliced segment 0, or the private copy unshare() made of one, is sized to
+		// the spliced buffer rather than to m_segment_capacity
+		if ((!m_spliced.empty() && m_spliced.front() == 0) || m_bufs[0].capacity() != m_segment_capacity)
+		{
+			m_bufs[0] = m_factory->create(m_segment_capacity);
+		}
+		m_offsets.resize(2);
+		m_offsets[1]    = m_segment_capacity;
+		m_last_capacity = m_segment_capacity;
+	}
+	m_spliced.clear();
+	m_has_spliced = false;
+	m_current     = 0;
+}
+
+void
+bufseq::sink::unshare(util::size_type index)
+{
+	auto it = std::lower_bound(m_spliced.begin(), m_spliced.end(), index);
+	if (it != m_spliced.end() && *it == index)
+	{
+		auto                 size = m_bufs[index].size();
+		auto                 copy = m_factory->create(size);
+		::memcpy(copy.data(), m_bufs[index].data(), size);
+		copy.size(size);
+		m_bufs[index] = std::move(copy);
+		m_spliced.erase(it);
+	}
+}
+
+util::size_type
+bufseq::sink::segment_index(util::position_type pos) const
+{
+	util::size_type result = 0;
+	if (pos > 0)
+	{
+		if (!m_has_spliced && m_max_segment_capacity == m_segment_capacity)
+		{
+			result = (pos - 1) / m_segment_capacity;
+		}
+		else
+		{
+			// first segment whose end is at or past pos
+			auto it = std::lower_bound(m_offsets.begin() + 1, m_offsets.end(), pos);
+			result  = it - (m_offsets.begin() + 1);
+		}
+	}
+	return result;
 }
 
 bool
@@ -65,8 +145,7 @@ bufseq::sink&
 bufseq::sink::clear() noexcept
 {
 	reset_high_water_mark();
-	m_bufs.resize(1);
-	m_current = 0;
+	reset_segments();
 	m_bufs[m_current].size(0);
 	reset_ptrs();
 	m_did_jump = false;
@@ -74,6 +153,71 @@ bufseq::sink::clear() noexcept
 	return *this;
 }
 
+util::size_type
+bufseq::sink::write_to(int fd)
+{
+	std::error_code err;
+	auto            result = write_to(fd, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+	return result;
+}
+
+util::size_type
+bufseq::sink::write_to(int fd, std::error_code& err)
+{
+	err.clear();
+	util::size_type written = 0;
+	auto&           bufs    = get_buffers();
+	std::vector<struct iovec> iov;
+	iov.reserve(std::min(bufs.size(), static_cast<std::size_t>(IOV_MAX)));
+
+	std::size_t     index  = 0;    // first segment not completely written
+	util::size_type offset = 0;    // bytes of segment index already written
+	while (index < bufs.size())
+	{
+		iov.clear();
+		for (auto i = index; i < bufs.size() && iov.size() < IOV_MAX; ++i)
+		{
+			auto skip = (i == index) ? offset : 0;
+			if (bufs[i].size() > skip)
+			{
+				iov.push_back({bufs[i].data() + skip, bufs[i].size() - skip});
+			}
+		}
+		if (iov.empty())
+		{
+			break;
+		}
+
+		auto result = ::writev(fd, iov.data(), static_cast<int>(iov.size()));
+		if (result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			err = std::error_code{errno, std::generic_category()};
+			goto exit;
+		}
+		written += static_cast<util::size_type>(result);
+
+		// advance past what was written; a partial write resumes mid-segment
+		auto n = static_cast<util::size_type>(result);
+		while (index < bufs.size() && n >= bufs[index].size() - offset)
+		{
+			n -= bufs[index].size() - offset;
+			offset = 0;
+			++index;
+		}
+		offset += n;
+	}
+exit:
+	return written;
+}
+
 bufseq::sink::buffers&
 bufseq::sink::get_buffers()
 {
@@ -91,25 +235,24 @@ bufseq::sink::set_size()
 	auto hwm = get_high_watermark();
 	if (hwm == 0)
 	{
-		assert(m_bufs.size() == 1);
-		assert(m_current == 0);
-		m_bufs[m_current].size(0);
+		for (auto& buf : m_bufs)
+		{
+			buf.size(0);
+		}
 	}
 	else
 	{
-		auto hwm_segment = hwm / m_segment_capacity;
-		auto hwm_seg_pos = hwm % m_segment_capacity;
-		if (hwm_seg_pos == 0)
-		{
-			assert(hwm_segment > 0);
-			// set ptrs to end of previous buffer; will immediately overflow
-			--hwm_segment;
-			hwm_seg_pos = m_segment_capacity;
-		}
-		assert(hwm_segment == m_bufs.size() - 1);
-		assert(hwm_seg_pos > 0 && hwm_seg_pos <= m_segment_capacity);
+		auto hwm_segment = segment_index(hwm);
+		auto hwm_seg_pos = static_cast<util::size_type>(hwm - m_offsets[hwm_segment]);
+		assert(hwm_seg_pos > 0 && hwm_seg_pos <= segment_capacity(hwm_segment));
 
 		m_bufs[hwm_segment].size(hwm_seg_pos);
+		// nothing written yet to the segment following a spliced buffer, or to those
+		// holding the gap an eager jump zero-filled
+		for (auto i = hwm_segment + 1; i < m_bufs.size(); ++i)
+		{
+			m_bufs[i].size(0);
+		}
 	}
 }
 
@@ -130,7 +273,17 @@ bufseq::sink::release_buffers()
 	m_base_offset = 0;
 	m_current     = 0;
 	set_ptrs(nullptr, nullptr, nullptr);
-	return std::move(m_bufs);
+	while (m_bufs.size() > 1 && m_bufs.back().size() == 0)
+	{
+		m_bufs.pop_back();
+	}
+	buffers result{std::move(m_bufs)};
+	m_bufs.clear();
+	m_offsets.resize(1);
+	m_last_capacity = 0;
+	m_spliced.clear();
+	m_has_spliced = false;
+	return result;
 }
 
 void
@@ -174,33 +327,121 @@ bufseq::sink::locate(util::position_type pos, std::error_code& err)
 {
 	err.clear();
 	assert(pos <= get_high_watermark());
-	if (pos == 0)
+	// a position on a segment boundary is placed at the end of the earlier
+	// segment; the next put will immediately overflow into the following one
+	auto new_current = segment_index(pos);
+	if (new_current >= m_bufs.size())
 	{
-		assert(m_bufs.size() == 1);
-		m_current = 0;
-		reset_ptrs();
+		err = make_error_code(std::errc::invalid_argument);
 	}
 	else
 	{
-		auto new_current = pos / m_segment_capacity;
-		auto seg_pos     = pos % m_segment_capacity;
-		if (seg_pos == 0)
+		m_current     = new_current;
+		m_base_offset = m_offsets[m_current];
+		if (pos < m_offsets[m_current + 1])
+		{
+			unshare(m_current);
+		}
+		auto new_base = m_bufs[m_current].data();
+		set_ptrs(new_base, new_base + (pos - m_base_offset), new_base + segment_capacity(m_current));
+	}
+}
+
+void
+bufseq::sink::really_truncate(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	assert(!m_dirty);
+	force_high_watermark(pos);
+	if (m_bufs.empty())    // buffers were released
+	{
+		assert(pos == 0);
+		goto exit;
+	}
+
+	{
+		auto last = segment_index(pos);
+		m_bufs.erase(m_bufs.begin() + (last + 1), m_bufs.end());
+		m_offsets.resize(last + 2);
+		m_spliced.erase(std::upper_bound(m_spliced.begin(), m_spliced.end(), last), m_spliced.end());
+	}
+	locate(pos, err);
+
+exit:
+	return;
+}
+
+void
+bufseq::sink::really_splice(util::shared_buffer const& buf, std::error_code& err)
+{
+	err.clear();
+	util::mutable_buffer spare;
+	util::size_type      spare_capacity = 0;
+
+	flush(err);
+	if (err)
+		goto exit;
+
+	if (m_did_jump)
+	{
+		really_jump(err);
+		if (err)
+			goto exit;
+	}
+
+	if (ppos() != get_high_watermark())
+	{
+		// splicing would shift everything after the current position
+		base::really_splice(buf, err);
+		goto exit;
+	}
+
+	if (!m_bufs.empty())
+	{
+		if (m_current + 1 < m_bufs.size())
 		{
-			assert(new_current > 0);
-			// set ptrs to end of previous buffer; will immediately overflow
-			--new_current;
-			seg_pos = m_segment_capacity;
+			// at the end of a segment, followed by an empty one
+			assert(ppos() == m_offsets[m_current + 1]);
+			++m_current;
 		}
-		if (new_current >= m_bufs.size())
+		assert(m_current == m_bufs.size() - 1);
+
+		// close the current segment at the current position; if nothing has
+		// been written to it, keep it to continue writing after buf
+		auto used = static_cast<util::size_type>(ppos() - m_offsets[m_current]);
+		if (used == 0)
 		{
-			err = make_error_code(std::errc::invalid_argument);
+			spare_capacity = segment_capacity(m_current);
+			spare          = std::move(m_bufs.back());
+			m_bufs.pop_back();
+			m_offsets.pop_back();
 		}
 		else
 		{
-			m_current     = new_current;
-			m_base_offset = m_current * m_segment_capacity;
-			auto new_base = m_bufs[m_current].data();
-			set_ptrs(new_base, new_base + seg_pos, new_base + m_segment_capacity);
+			m_bufs.back().size(used);
+			m_offsets.back() = m_offsets[m_current] + used;
 		}
 	}
+
+	m_spliced.push_back(m_bufs.size());
+	m_bufs.emplace_back(const_cast<util::byte_type*>(buf.data()), buf.size(), [hold = buf](void*) {});
+	m_offsets.push_back(m_offsets.back() + buf.size());
+
+	if (spare_capacity > 0)
+	{
+		m_bufs.emplace_back(std::move(spare));
+		m_offsets.push_back(m_offsets.back() + spare_capacity);
+	}
+	else
+	{
+		add_segment();
+	}
+
+	m_has_spliced = true;
+	m_current     = m_bufs.size() - 1;
+	reset_ptrs();
+	force_high_watermark(m_base_offset);
+
+exit:
+	return;
 }
@@ -0,0 +1,168 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <bstream/byte_swap.h>
+#include <boost/endian/conversion.hpp>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BSTREAM_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace bend = boost::endian;
+
+namespace
+{
+
+template<class T>
+void
+reverse_copy_scalar(util::byte_type* dst, const util::byte_type* src, util::size_type count)
+{
+	for (util::size_type i = 0; i < count; ++i)
+	{
+		T value;
+		::memcpy(&value, src, sizeof(T));
+		value = bend::endian_reverse(value);
+		::memcpy(dst, &value, sizeof(T));
+		src += sizeof(T);
+		dst += sizeof(T);
+	}
+}
+
+#if BSTREAM_X86_SIMD
+
+// pshufb controls that reverse each 2, 4 or 8-byte element within a 16-byte lane
+alignas(16) const std::uint8_t lane_masks[3][16] = {
+		{1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+		{3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+		{7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8},
+};
+
+enum class simd_level
+{
+	none,
+	ssse3,
+	avx2
+};
+
+simd_level
+detect_simd_level()
+{
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return simd_level::avx2;
+	}
+	else if (__builtin_cpu_supports("ssse3"))
+	{
+		return simd_level::ssse3;
+	}
+	else
+	{
+		return simd_level::none;
+	}
+}
+
+simd_level
+get_simd_level()
+{
+	static const simd_level level = detect_simd_level();
+	return level;
+}
+
+// each returns the number of bytes processed, a multiple of the vector width
+
+__attribute__((target("ssse3"))) util::size_type
+reverse_copy_ssse3(util::byte_type* dst, const util::byte_type* src, util::size_type nbytes, const std::uint8_t* mask_bytes)
+{
+	const __m128i   mask = _mm_load_si128(reinterpret_cast<const __m128i*>(mask_bytes));
+	util::size_type i    = 0;
+	for (; i + 16 <= nbytes; i += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, mask));
+	}
+	return i;
+}
+
+__attribute__((target("avx2"))) util::size_type
+reverse_copy_avx2(util::byte_type* dst, const util::byte_type* src, util::size_type nbytes, const std::uint8_t* mask_bytes)
+{
+	const __m256i mask = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(mask_bytes)));
+	util::size_type i  = 0;
+	for (; i + 32 <= nbytes; i += 32)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask));
+	}
+	return i;
+}
+
+#endif    // BSTREAM_X86_SIMD
+
+}    // namespace
+
+void
+bstream::detail::reverse_copy(util::byte_type* dst, const util::byte_type* src, util::size_type count, std::size_t width)
+{
+	assert(width == 2 || width == 4 || width == 8);
+
+	util::size_type nbytes = count * width;
+	util::size_type done   = 0;
+
+#if BSTREAM_X86_SIMD
+	const std::uint8_t* mask = lane_masks[(width == 2) ? 0 : ((width == 4) ? 1 : 2)];
+	switch (get_simd_level())
+	{
+		case simd_level::avx2:
+			done = reverse_copy_avx2(dst, src, nbytes, mask);
+			break;
+		case simd_level::ssse3:
+			done = reverse_copy_ssse3(dst, src, nbytes, mask);
+			break;
+		case simd_level::none:
+			break;
+	}
+#endif
+
+	dst += done;
+	src += done;
+	count = (nbytes - done) / width;
+
+	switch (width)
+	{
+		case 2:
+			reverse_copy_scalar<std::uint16_t>(dst, src, count);
+			break;
+		case 4:
+			reverse_copy_scalar<std::uint32_t>(dst, src, count);
+			break;
+		case 8:
+			reverse_copy_scalar<std::uint64_t>(dst, src, count);
+			break;
+	}
+}
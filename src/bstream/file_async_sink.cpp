@@ -0,0 +1,373 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <algorithm>
+#include <bstream/file/async_sink.h>
+#include <cerrno>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bstream;
+
+file::async_sink::async_sink(util::size_type buffer_size, util::size_type buffer_count, byte_order order)
+	: base{order},
+	  m_filename{},
+	  m_is_open{false},
+	  m_fd{-1},
+	  m_buffer_size{std::max(buffer_size, util::size_type{1})},
+	  m_bufs{},
+	  m_current{0},
+	  m_stop{false}
+{
+	auto count = std::max(buffer_count, util::size_type{2});
+	m_bufs.reserve(count);
+	for (util::size_type i = 0; i < count; ++i)
+	{
+		m_bufs.emplace_back(m_buffer_size);
+	}
+}
+
+file::async_sink::async_sink(
+		std::string const& filename,
+		open_mode          mode,
+		std::error_code&   err,
+		util::size_type    buffer_size,
+		util::size_type    buffer_count,
+		byte_order         order)
+	: async_sink{buffer_size, buffer_count, order}
+{
+	open(filename, mode, err);
+}
+
+file::async_sink::async_sink(
+		std::string const& filename,
+		open_mode          mode,
+		util::size_type    buffer_size,
+		util::size_type    buffer_count,
+		byte_order         order)
+	: async_sink{buffer_size, buffer_count, order}
+{
+	open(filename, mode);
+}
+
+file::async_sink::~async_sink()
+{
+	std::error_code err;
+	close(err);
+}
+
+void
+file::async_sink::open(std::string const& filename, open_mode mode, std::error_code& err)
+{
+	err.clear();
+	int         flags = O_WRONLY | O_CREAT;
+	struct stat info;
+
+	if (m_is_open)
+	{
+		close(err);
+		if (err)
+			goto exit;
+	}
+
+	if (mode == open_mode::truncate)
+	{
+		flags |= O_TRUNC;
+	}
+
+	m_filename = filename;
+	m_fd       = ::open(m_filename.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (m_fd < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+
+	if (::fstat(m_fd, &info) < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		::close(m_fd);
+		m_fd = -1;
+		goto exit;
+	}
+
+	{
+		auto size = static_cast<util::position_type>(info.st_size);
+		auto pos  = (mode == open_mode::at_end || mode == open_mode::append) ? size : 0;
+
+		m_pending.clear();
+		m_free.clear();
+		for (util::size_type i = 1; i < m_bufs.size(); ++i)
+		{
+			m_free.push_back(i);
+		}
+		m_deferred.clear();
+		m_stop = false;
+
+		use_buffer(0, pos);
+		force_high_watermark(size);
+		m_dirty    = false;
+		m_did_jump = false;
+		m_is_open  = true;
+		m_thread   = std::thread{&async_sink::run, this};
+	}
+
+exit:
+	return;
+}
+
+void
+file::async_sink::open(std::string const& filename, open_mode mode)
+{
+	std::error_code err;
+	open(filename, mode, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
+void
+file::async_sink::close(std::error_code& err)
+{
+	err.clear();
+	if (!m_is_open)
+		goto exit;
+
+	// the I/O thread must be stopped even if the final writes fail
+	flush(err);
+
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		m_stop = true;
+	}
+	m_work_cv.notify_one();
+	m_thread.join();
+
+	if (!err && m_deferred)
+	{
+		err = m_deferred;
+	}
+	m_deferred.clear();
+
+	if (::close(m_fd) < 0 && !err)
+	{
+		err = std::error_code{errno, std::generic_category()};
+	}
+	m_fd       = -1;
+	m_is_open  = false;
+	m_dirty    = false;
+	m_did_jump = false;
+	set_ptrs(nullptr, nullptr, nullptr);
+
+exit:
+	return;
+}
+
+void
+file::async_sink::close()
+{
+	std::error_code err;
+	close(err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
+void
+file::async_sink::run()
+{
+	std::unique_lock<std::mutex> lock{m_mutex};
+	while (true)
+	{
+		m_work_cv.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+		if (m_pending.empty())
+		{
+			break;
+		}
+
+		// the request stays queued while it is written, so an empty queue means idle
+		auto req = m_pending.front();
+		lock.unlock();
+		std::error_code err;
+		write_all(req, err);
+		lock.lock();
+
+		if (err && !m_deferred)
+		{
+			m_deferred = err;
+		}
+		m_pending.pop_front();
+		m_free.push_back(req.index);
+		m_done_cv.notify_all();
+	}
+}
+
+void
+file::async_sink::write_all(write_request const& req, std::error_code& err)
+{
+	err.clear();
+	auto src       = m_bufs[req.index].data();
+	auto offset    = req.offset;
+	auto remaining = req.length;
+
+	while (remaining > 0)
+	{
+		auto result = ::pwrite(m_fd, src, remaining, offset);
+		if (result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			err = std::error_code{errno, std::generic_category()};
+			goto exit;
+		}
+		src += result;
+		offset += result;
+		remaining -= static_cast<util::size_type>(result);
+	}
+
+exit:
+	return;
+}
+
+void
+file::async_sink::really_flush(std::error_code& err)
+{
+	err.clear();
+	assert(m_dirty && m_dirty_start == m_base);
+
+	if (!m_is_open)
+	{
+		err = make_error_code(std::errc::bad_file_descriptor);
+		goto exit;
+	}
+
+	{
+		auto                         pos = ppos();
+		std::unique_lock<std::mutex> lock{m_mutex};
+		if (m_deferred)
+		{
+			err = m_deferred;
+			m_deferred.clear();
+			goto exit;
+		}
+
+		m_pending.push_back({m_current, m_base_offset, static_cast<util::size_type>(m_next - m_base)});
+		m_work_cv.notify_one();
+
+		m_done_cv.wait(lock, [this]() { return !m_free.empty(); });
+		auto next = m_free.back();
+		m_free.pop_back();
+		lock.unlock();
+
+		use_buffer(next, pos);
+	}
+
+exit:
+	return;
+}
+
+void
+file::async_sink::really_drain(std::error_code& err)
+{
+	err.clear();
+	if (!m_is_open)
+		goto exit;
+
+	{
+		std::unique_lock<std::mutex> lock{m_mutex};
+		m_done_cv.wait(lock, [this]() { return m_pending.empty(); });
+		err = m_deferred;
+		m_deferred.clear();
+	}
+
+exit:
+	return;
+}
+
+bool
+file::async_sink::is_valid_position(util::position_type pos) const
+{
+	return pos >= 0;
+}
+
+void
+file::async_sink::really_jump(std::error_code& err)
+{
+	err.clear();
+	assert(m_did_jump);
+	assert(!m_dirty);    // previously flushed, so the buffer is empty
+
+	// pwrite() leaves a hole, read as zeros, between the end of the file and m_jump_to
+	m_base_offset = m_jump_to;
+	m_next        = m_base;
+	m_did_jump    = false;
+}
+
+void
+file::async_sink::really_overflow(util::size_type, std::error_code& err)
+{
+	err.clear();
+	if (!m_is_open)
+	{
+		err = make_error_code(std::errc::bad_file_descriptor);
+		goto exit;
+	}
+
+	// flushing switched to a free buffer
+	assert(m_next == m_base);
+
+exit:
+	return;
+}
+
+void
+file::async_sink::really_truncate(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	assert(!m_dirty);    // truncate() flushed, which waited for the queued writes
+
+	if (!m_is_open)
+	{
+		err = make_error_code(std::errc::bad_file_descriptor);
+		goto exit;
+	}
+
+	if (::ftruncate(m_fd, pos) < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+
+	m_base_offset = pos;
+	m_next        = m_base;
+	force_high_watermark(pos);
+
+exit:
+	return;
+}
@@ -0,0 +1,333 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <algorithm>
+#include <bstream/file/mmap_sink.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bstream;
+
+namespace
+{
+util::size_type
+page_size()
+{
+	static const util::size_type page = static_cast<util::size_type>(::sysconf(_SC_PAGESIZE));
+	return page;
+}
+
+util::size_type
+round_to_pages(util::size_type n)
+{
+	return ((n + page_size() - 1) / page_size()) * page_size();
+}
+
+/*
+ * Extends the file from size bytes to new_size with its blocks allocated, so that a full
+ * disk is reported here as ENOSPC instead of raising SIGBUS on a later store through the
+ * mapping. File systems without fallocate support get a sparse extension.
+ */
+int
+extend_file(int fd, util::size_type size, util::size_type new_size)
+{
+	int result = 0;
+#if defined(__APPLE__)
+	result = ::ftruncate(fd, new_size) < 0 ? errno : 0;
+#else
+	result = ::posix_fallocate(fd, size, new_size - size);
+	if (result == EOPNOTSUPP || result == EINVAL || result == ENOSYS)
+	{
+		result = ::ftruncate(fd, new_size) < 0 ? errno : 0;
+	}
+#endif
+	return result;
+}
+}    // namespace
+
+file::mmap_sink::mmap_sink(map_sync sync, util::size_type growth_step, byte_order order)
+	: base{order},
+	  m_filename{},
+	  m_is_open{false},
+	  m_fd{-1},
+	  m_sync{sync},
+	  m_growth_step{std::max(growth_step, util::size_type{1})},
+	  m_capacity{0}
+{}
+
+file::mmap_sink::mmap_sink(
+		std::string const& filename,
+		open_mode          mode,
+		std::error_code&   err,
+		map_sync           sync,
+		util::size_type    growth_step,
+		byte_order         order)
+	: mmap_sink{sync, growth_step, order}
+{
+	open(filename, mode, err);
+}
+
+file::mmap_sink::mmap_sink(
+		std::string const& filename,
+		open_mode          mode,
+		map_sync           sync,
+		util::size_type    growth_step,
+		byte_order         order)
+	: mmap_sink{sync, growth_step, order}
+{
+	open(filename, mode);
+}
+
+file::mmap_sink::~mmap_sink()
+{
+	std::error_code err;
+	close(err);
+}
+
+void
+file::mmap_sink::open(std::string const& filename, open_mode mode, std::error_code& err)
+{
+	err.clear();
+	int             flags    = O_RDWR | O_CREAT;
+	util::size_type size     = 0;
+	util::size_type capacity = 0;
+	void*           addr     = MAP_FAILED;
+	struct stat     info;
+
+	if (m_is_open)
+	{
+		close(err);
+		if (err)
+			goto exit;
+	}
+
+	if (mode == open_mode::truncate)
+	{
+		flags |= O_TRUNC;
+	}
+
+	m_filename = filename;
+	m_fd       = ::open(m_filename.c_str(), flags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (m_fd < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+
+	if (::fstat(m_fd, &info) < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+	size     = static_cast<util::size_type>(info.st_size);
+	capacity = round_to_pages(std::max(size, m_growth_step));
+
+	if (capacity > size)
+	{
+		auto result = extend_file(m_fd, size, capacity);
+		if (result != 0)
+		{
+			err = std::error_code{result, std::generic_category()};
+			goto exit;
+		}
+	}
+
+	addr = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (addr == MAP_FAILED)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+
+	{
+		auto map_base = static_cast<util::byte_type*>(addr);
+		auto pos      = (mode == open_mode::at_end || mode == open_mode::append) ? size : 0;
+		m_capacity    = capacity;
+		m_is_open     = true;
+		m_base_offset = 0;
+		set_ptrs(map_base, map_base + pos, map_base + capacity);
+		force_high_watermark(size);
+		m_dirty    = false;
+		m_did_jump = false;
+	}
+
+exit:
+	if (err && m_fd >= 0 && !m_is_open)
+	{
+		if (capacity > size)
+		{
+			::ftruncate(m_fd, size);
+		}
+		::close(m_fd);
+		m_fd = -1;
+	}
+	return;
+}
+
+void
+file::mmap_sink::open(std::string const& filename, open_mode mode)
+{
+	std::error_code err;
+	open(filename, mode, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
+void
+file::mmap_sink::close(std::error_code& err)
+{
+	err.clear();
+	if (!m_is_open)
+		goto exit;
+
+	flush(err);
+	if (err)
+		goto exit;
+
+	{
+		auto size = get_high_watermark();
+		unmap();
+		if (::ftruncate(m_fd, size) < 0)
+		{
+			err = std::error_code{errno, std::generic_category()};
+		}
+		if (::close(m_fd) < 0 && !err)
+		{
+			err = std::error_code{errno, std::generic_category()};
+		}
+		m_fd       = -1;
+		m_is_open  = false;
+		m_did_jump = false;
+	}
+
+exit:
+	return;
+}
+
+void
+file::mmap_sink::close()
+{
+	std::error_code err;
+	close(err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
+void
+file::mmap_sink::unmap() noexcept
+{
+	if (m_base != nullptr)
+	{
+		::munmap(m_base, m_capacity);
+	}
+	set_ptrs(nullptr, nullptr, nullptr);
+	m_capacity = 0;
+}
+
+void
+file::mmap_sink::really_flush(std::error_code& err)
+{
+	err.clear();
+	assert(m_dirty && m_next >= m_dirty_start);
+
+	if (m_sync != map_sync::none && m_next > m_dirty_start)
+	{
+		// msync needs a page-aligned start
+		auto start  = static_cast<util::size_type>(m_dirty_start - m_base);
+		start       = (start / page_size()) * page_size();
+		auto length = static_cast<util::size_type>(m_next - m_base) - start;
+		if (::msync(m_base + start, length, m_sync == map_sync::sync ? MS_SYNC : MS_ASYNC) < 0)
+		{
+			err = std::error_code{errno, std::generic_category()};
+		}
+	}
+}
+
+bool
+file::mmap_sink::is_valid_position(util::position_type pos) const
+{
+	return pos >= 0;
+}
+
+void
+file::mmap_sink::really_overflow(util::size_type n, std::error_code& err)
+{
+	err.clear();
+	if (!m_is_open)
+	{
+		err = make_error_code(std::errc::bad_file_descriptor);
+		goto exit;
+	}
+
+	grow(static_cast<util::size_type>(ppos()) + n, err);
+
+exit:
+	return;
+}
+
+void
+file::mmap_sink::grow(util::size_type required, std::error_code& err)
+{
+	err.clear();
+	auto  pos          = m_next - m_base;
+	auto  new_capacity = round_to_pages(std::max(required, m_capacity + std::max(m_growth_step, m_capacity / 2)));
+	void* addr         = MAP_FAILED;
+
+	{
+		auto result = extend_file(m_fd, m_capacity, new_capacity);
+		if (result != 0)
+		{
+			err = std::error_code{result, std::generic_category()};
+			goto exit;
+		}
+	}
+
+#ifdef MREMAP_MAYMOVE
+	addr = ::mremap(m_base, m_capacity, new_capacity, MREMAP_MAYMOVE);
+#else
+	unmap();
+	addr = ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+#endif
+	if (addr == MAP_FAILED)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+
+	{
+		auto map_base = static_cast<util::byte_type*>(addr);
+		m_capacity    = new_capacity;
+		set_ptrs(map_base, map_base + pos, map_base + new_capacity);
+	}
+
+exit:
+	return;
+}
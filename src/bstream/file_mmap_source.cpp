@@ -0,0 +1,209 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <bstream/error.h>
+#include <bstream/file/mmap_source.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bstream;
+
+file::mmap_source::mmap_source(map_advice advice, bool populate, byte_order order)
+	: base{0, order}, m_map{}, m_advice{advice}, m_populate{populate}
+{}
+
+file::mmap_source::mmap_source(
+		std::string const& filename,
+		std::error_code&   err,
+		map_advice         advice,
+		bool               populate,
+		byte_order         order)
+	: base{0, order}, m_map{}, m_advice{advice}, m_populate{populate}
+{
+	open(filename, err);
+}
+
+file::mmap_source::mmap_source(std::string const& filename, map_advice advice, bool populate, byte_order order)
+	: base{0, order}, m_map{}, m_advice{advice}, m_populate{populate}
+{
+	open(filename);
+}
+
+void
+file::mmap_source::init_open(std::error_code& err)
+{
+	err.clear();
+	struct stat info;
+	void*       addr  = nullptr;
+	int         flags = MAP_PRIVATE;
+
+	if (::fstat(m_fd, &info) < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+	m_size = static_cast<util::size_type>(info.st_size);
+
+	if (m_size > 0)    // an empty mapping isn't allowed; an empty file reads as an empty stream
+	{
+#ifdef MAP_POPULATE
+		if (m_populate)
+		{
+			flags |= MAP_POPULATE;
+		}
+#endif
+		addr = ::mmap(nullptr, m_size, PROT_READ, flags, m_fd, 0);
+		if (addr == MAP_FAILED)
+		{
+			err = std::error_code{errno, std::generic_category()};
+			goto exit;
+		}
+
+		switch (m_advice)
+		{
+			case map_advice::sequential:
+				::madvise(addr, m_size, MADV_SEQUENTIAL);
+				break;
+			case map_advice::random:
+				::madvise(addr, m_size, MADV_RANDOM);
+				break;
+			case map_advice::normal:
+				break;
+		}
+
+		m_map = util::shared_buffer{
+				util::mutable_buffer{addr, m_size, [size = m_size](void* p) { ::munmap(p, size); }}};
+	}
+	else
+	{
+		m_map = util::shared_buffer{};
+	}
+
+	// the mapping doesn't need the descriptor
+	::close(m_fd);
+	m_fd = -1;
+
+	m_is_open     = true;
+	m_base_offset = 0;
+	set_ptrs(m_map.data(), m_map.data(), m_map.data() + m_map.size());
+
+exit:
+	if (err)
+	{
+		::close(m_fd);
+		m_fd = -1;
+	}
+	return;
+}
+
+void
+file::mmap_source::really_close(std::error_code& err)
+{
+	err.clear();
+	m_map = util::shared_buffer{};    // outstanding slices keep the mapping alive
+	m_size        = 0;
+	m_base_offset = 0;
+	set_ptrs(nullptr, nullptr, nullptr);
+	m_is_open = false;
+}
+
+util::size_type
+file::mmap_source::really_underflow(std::error_code& err)
+{
+	// the whole file is in the internal sequence
+	err.clear();
+	m_next = m_end;
+	return 0UL;
+}
+
+util::size_type
+file::mmap_source::really_get_size() const
+{
+	return m_size;
+}
+
+util::position_type
+file::mmap_source::really_seek(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	m_next = m_base + pos;
+	return pos;
+}
+
+util::position_type
+file::mmap_source::really_get_position() const
+{
+	return gpos();
+}
+
+util::shared_buffer
+file::mmap_source::get_shared_slice(util::size_type n, std::error_code& err)
+{
+	err.clear();
+	util::shared_buffer result;
+
+	if (n < 1)
+		goto exit;
+
+	if (n > static_cast<util::size_type>(m_end - m_next))
+	{
+		err = make_error_code(bstream::errc::read_past_end_of_stream);
+		goto exit;
+	}
+
+	result = util::shared_buffer{m_map, static_cast<util::position_type>(m_next - m_base), n, err};
+	if (!err)
+	{
+		gbump(n);
+	}
+
+exit:
+	return result;
+}
+
+util::shared_buffer
+file::mmap_source::get_shared_slice(util::size_type n)
+{
+	std::error_code err;
+	auto            result = get_shared_slice(n, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+	return result;
+}
+
+util::const_buffer
+file::mmap_source::get_slice(util::size_type n, std::error_code& err)
+{
+	return util::const_buffer{get_shared_slice(n, err)};
+}
+
+util::const_buffer
+file::mmap_source::get_slice(util::size_type n)
+{
+	return util::const_buffer{get_shared_slice(n)};
+}
@@ -0,0 +1,290 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <bstream/file/prefetch_source.h>
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace bstream;
+
+file::prefetch_source::prefetch_source(util::size_type buffer_size, util::size_type buffer_count, byte_order order)
+	: base{0, order},
+	  m_buffer_size{std::max(buffer_size, util::size_type{1})},
+	  m_bufs{},
+	  m_current{no_buffer},
+	  m_read_pos{0},
+	  m_generation{0},
+	  m_done{false},
+	  m_stop{false}
+{
+	auto count = std::max(buffer_count, util::size_type{2});
+	m_bufs.reserve(count);
+	for (util::size_type i = 0; i < count; ++i)
+	{
+		m_bufs.emplace_back(m_buffer_size);
+	}
+}
+
+file::prefetch_source::prefetch_source(
+		std::string const& filename,
+		std::error_code&   err,
+		util::size_type    buffer_size,
+		util::size_type    buffer_count,
+		byte_order         order)
+	: prefetch_source{buffer_size, buffer_count, order}
+{
+	open(filename, err);
+}
+
+file::prefetch_source::prefetch_source(
+		std::string const& filename,
+		util::size_type    buffer_size,
+		util::size_type    buffer_count,
+		byte_order         order)
+	: prefetch_source{buffer_size, buffer_count, order}
+{
+	open(filename);
+}
+
+file::prefetch_source::~prefetch_source()
+{
+	std::error_code err;
+	close(err);
+}
+
+void
+file::prefetch_source::init_open(std::error_code& err)
+{
+	base::init_open(err);
+	if (err)
+		goto exit;
+
+	m_ready.clear();
+	m_free.clear();
+	for (util::size_type i = 0; i < m_bufs.size(); ++i)
+	{
+		m_free.push_back(i);
+	}
+	m_current     = no_buffer;
+	m_read_pos    = 0;
+	m_done        = false;
+	m_stop        = false;
+	m_base_offset = 0;
+	set_ptrs(nullptr, nullptr, nullptr);
+	m_thread = std::thread{&prefetch_source::run, this};
+
+exit:
+	return;
+}
+
+void
+file::prefetch_source::really_close(std::error_code& err)
+{
+	if (m_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock{m_mutex};
+			m_stop = true;
+		}
+		m_work_cv.notify_one();
+		m_thread.join();
+	}
+	m_ready.clear();
+	m_current     = no_buffer;
+	m_base_offset = 0;
+	set_ptrs(nullptr, nullptr, nullptr);
+
+	base::really_close(err);
+}
+
+void
+file::prefetch_source::run()
+{
+	std::unique_lock<std::mutex> lock{m_mutex};
+	while (true)
+	{
+		m_work_cv.wait(lock, [this]() { return m_stop || (!m_done && !m_free.empty()); });
+		if (m_stop)
+		{
+			break;
+		}
+
+		auto index      = m_free.back();
+		auto offset     = m_read_pos;
+		auto generation = m_generation;
+		m_free.pop_back();
+		m_read_pos += m_buffer_size;
+		lock.unlock();
+
+		std::error_code err;
+		auto            length = read_chunk(index, offset, err);
+		lock.lock();
+
+		if (generation != m_generation)    // redirected while reading
+		{
+			m_free.push_back(index);
+			continue;
+		}
+
+		// a short read is the end of the file
+		if (err || length < m_buffer_size)
+		{
+			m_done = true;
+		}
+		m_ready.push_back({index, offset, length, err});
+		m_ready_cv.notify_one();
+	}
+}
+
+util::size_type
+file::prefetch_source::read_chunk(util::size_type index, util::position_type offset, std::error_code& err)
+{
+	err.clear();
+	auto            dst    = m_bufs[index].data();
+	util::size_type length = 0;
+
+	while (length < m_buffer_size)
+	{
+		auto result = ::pread(m_fd, dst + length, m_buffer_size - length, offset + length);
+		if (result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			err = std::error_code{errno, std::generic_category()};
+			goto exit;
+		}
+		if (result == 0)
+		{
+			break;
+		}
+		length += static_cast<util::size_type>(result);
+	}
+
+exit:
+	return length;
+}
+
+util::size_type
+file::prefetch_source::really_underflow(std::error_code& err)
+{
+	err.clear();
+	assert(m_next == m_end);
+	util::size_type available = 0;
+	chunk           next;
+
+	// the buffer goes back to the helper, so keep no pointers into it
+	m_base_offset = gpos();
+	set_ptrs(nullptr, nullptr, nullptr);
+
+	{
+		std::unique_lock<std::mutex> lock{m_mutex};
+		if (m_current != no_buffer)
+		{
+			m_free.push_back(m_current);
+			m_current = no_buffer;
+			m_work_cv.notify_one();
+		}
+
+		m_ready_cv.wait(lock, [this]() { return !m_ready.empty() || m_done || m_stop; });
+		if (m_ready.empty())    // consumed the end of the file
+		{
+			goto exit;
+		}
+
+		next = std::move(m_ready.front());
+		m_ready.pop_front();
+		assert(next.offset == gpos());
+
+		if (next.err || next.length == 0)
+		{
+			err = next.err;
+			m_free.push_back(next.index);
+			m_work_cv.notify_one();
+			goto exit;
+		}
+	}
+
+	{
+		auto base     = m_bufs[next.index].data();
+		m_current     = next.index;
+		m_base_offset = next.offset;
+		set_ptrs(base, base, base + next.length);
+		available = next.length;
+	}
+
+exit:
+	return available;
+}
+
+util::position_type
+file::prefetch_source::really_seek(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+
+	if (m_current != no_buffer && pos >= m_base_offset && pos <= m_base_offset + (m_end - m_base))
+	{
+		m_next = m_base + (pos - m_base_offset);
+		goto exit;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{m_mutex};
+		redirect(pos);
+	}
+	m_work_cv.notify_one();
+
+	m_base_offset = pos;
+	set_ptrs(nullptr, nullptr, nullptr);
+
+exit:
+	return pos;
+}
+
+void
+file::prefetch_source::redirect(util::position_type pos)
+{
+	++m_generation;
+	for (auto& c : m_ready)
+	{
+		m_free.push_back(c.index);
+	}
+	m_ready.clear();
+	if (m_current != no_buffer)
+	{
+		m_free.push_back(m_current);
+		m_current = no_buffer;
+	}
+	m_read_pos = pos;
+	m_done     = false;
+}
+
+void
+file::prefetch_source::really_rewind()
+{
+	std::error_code err;
+	really_seek(0, err);
+}
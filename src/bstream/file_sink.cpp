@@ -24,6 +24,9 @@
 
 #include <fcntl.h>
 #include <bstream/file/sink.h>
+#include <bstream/huge_pages.h>
+#include <cerrno>
+#include <sys/uio.h>
 #include <unistd.h>
 
 using namespace bstream;
@@ -200,6 +203,77 @@ exit:
 	return;
 }
 
+util::size_type
+file::sink::really_write_direct(const util::byte_type* src, util::size_type n, std::error_code& err)
+{
+	err.clear();
+	util::size_type result = 0;
+	if (n < m_buf.capacity())
+		goto exit;
+
+	{
+		assert(!m_dirty || m_dirty_start == m_base);
+		auto head = m_dirty ? static_cast<util::size_type>(m_next - m_base) : 0;
+
+		struct iovec iov[2] = {{m_base, head}, {const_cast<util::byte_type*>(src), n}};
+		struct iovec* first = (head > 0) ? &iov[0] : &iov[1];
+		int           count = (head > 0) ? 2 : 1;
+		while (count > 0)
+		{
+			auto write_result = ::writev(m_fd, first, count);
+			if (write_result < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				err = std::error_code{errno, std::generic_category()};
+				goto exit;
+			}
+
+			// resume after a partial write
+			auto written = static_cast<std::size_t>(write_result);
+			while (count > 0 && written >= first->iov_len)
+			{
+				written -= first->iov_len;
+				++first;
+				--count;
+			}
+			if (count > 0)
+			{
+				first->iov_base = static_cast<util::byte_type*>(first->iov_base) + written;
+				first->iov_len -= written;
+			}
+		}
+
+		m_base_offset += head + n;
+		m_next  = m_base;
+		m_dirty = false;
+		if (m_base_offset > get_high_watermark())
+		{
+			force_high_watermark(m_base_offset);
+		}
+		result = n;
+	}
+
+exit:
+	return result;
+}
+
+void
+file::sink::huge_pages(bool flag)
+{
+	flush();
+	// a buffer under huge_pages::min_size would come from operator new; as the mapping
+	// takes whole huge pages anyway, the buffer grows to fill them
+	auto                 capacity = flag ? huge_pages::round_up(m_buf.capacity()) : m_buf.capacity();
+	auto                 next     = m_next - m_base;
+	util::mutable_buffer buf      = flag ? util::mutable_buffer{capacity, huge_page_allocator{}} : util::mutable_buffer{capacity};
+	m_buf                         = std::move(buf);
+	auto base                     = m_buf.data();
+	set_ptrs(base, base + next, base + capacity);
+}
+
 bool
 file::sink::is_valid_position(util::position_type pos) const
 {
@@ -323,6 +397,30 @@ file::sink::truncate()
 	return result;
 }
 
+void
+file::sink::really_truncate(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	assert(!m_dirty);
+
+	if (::ftruncate(m_fd, pos) < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+	if (::lseek(m_fd, pos, SEEK_SET) < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+	force_high_watermark(pos);
+	m_base_offset = pos;
+	m_next        = m_base;
+
+exit:
+	return;
+}
+
 void
 file::sink::really_open(std::error_code& err)
 {
@@ -24,6 +24,9 @@
 
 #include <fcntl.h>
 #include <bstream/file/source.h>
+#include <bstream/huge_pages.h>
+#include <cerrno>
+#include <cstring>
 #include <unistd.h>
 
 using namespace bstream;
@@ -83,41 +86,111 @@ file::source::really_underflow(std::error_code& err)
 	return available;
 }
 
-void
-file::source::close(std::error_code& err)
+util::size_type
+file::source::really_read_direct(util::byte_type* dst, util::size_type n, std::error_code& err)
 {
 	err.clear();
-	if (m_is_open)
+	util::size_type result = 0;
+
+	// unbuffered sources (mmap_source, prefetch_source) don't read from m_fd's position
+	if (m_buf.capacity() == 0 || n < m_buf.capacity())
+		goto exit;
+
+	assert(m_next == m_end);
+	while (result < n)
 	{
-		auto close_result = ::close(m_fd);
-		if (close_result < 0)
+		auto read_result = ::read(m_fd, dst + result, n - result);
+		if (read_result < 0)
 		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
 			err = std::error_code{errno, std::generic_category()};
-			goto exit;
+			break;
 		}
-
-		m_is_open = false;
+		if (read_result == 0)
+		{
+			break;
+		}
+		result += static_cast<util::size_type>(read_result);
 	}
 
+	m_base_offset = gpos() + result;
+	m_buf.size(0);
+	reset_ptrs();
+
 exit:
-	return;
+	return result;
 }
 
 void
-file::source::close()
+file::source::huge_pages(bool flag)
 {
+	if (m_buf.capacity() == 0)    // unbuffered (mmap_source)
+	{
+		return;
+	}
+
+	// as in file::sink::huge_pages(), the buffer grows to fill whole huge pages
+	auto                 capacity = flag ? huge_pages::round_up(m_buf.capacity()) : m_buf.capacity();
+	// bytes pending in an ensure() window stay there; the buffered input behind it moves
+	auto&                base_ptr = m_in_window ? m_saved_base : m_base;
+	auto&                next_ptr = m_in_window ? m_saved_next : m_next;
+	auto&                end_ptr  = m_in_window ? m_saved_end : m_end;
+	auto                 next     = next_ptr - base_ptr;
+	auto                 end      = end_ptr - base_ptr;
+	util::mutable_buffer buf      = flag ? util::mutable_buffer{capacity, huge_page_allocator{}} : util::mutable_buffer{capacity};
+	if (end > 0)
+	{
+		::memcpy(buf.data(), base_ptr, end);
+	}
+	buf.size(m_buf.size());
+	m_buf     = std::move(buf);
+	auto base = m_buf.data();
+	base_ptr  = base;
+	next_ptr  = base + next;
+	end_ptr   = base + end;
+}
+
+void
+file::source::close(std::error_code& err)
+{
+	err.clear();
 	if (m_is_open)
 	{
-		auto close_result = ::close(m_fd);
-		if (close_result < 0)
-		{
-			throw std::system_error{std::error_code{errno, std::generic_category()}};
-		}
+		really_close(err);
+	}
+}
 
-		m_is_open = false;
+void
+file::source::close()
+{
+	std::error_code err;
+	close(err);
+	if (err)
+	{
+		throw std::system_error{err};
 	}
 }
 
+void
+file::source::really_close(std::error_code& err)
+{
+	err.clear();
+	auto close_result = ::close(m_fd);
+	if (close_result < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+
+	m_is_open = false;
+
+exit:
+	return;
+}
+
 util::size_type
 file::source::load_buffer(std::error_code& err)
 {
@@ -141,8 +214,6 @@ file::source::really_open(std::error_code& err)
 {
 	err.clear();
 
-	off_t seek_result = 0;
-
 	if (m_is_open)
 	{
 		close(err);
@@ -158,7 +229,18 @@ file::source::really_open(std::error_code& err)
 		goto exit;
 	}
 
-	seek_result = ::lseek(m_fd, 0, SEEK_END);
+	init_open(err);
+
+exit:
+	return;
+}
+
+void
+file::source::init_open(std::error_code& err)
+{
+	err.clear();
+
+	off_t seek_result = ::lseek(m_fd, 0, SEEK_END);
 	if (seek_result < 0)
 	{
 		err    = std::error_code{errno, std::generic_category()};
@@ -184,6 +266,37 @@ exit:
 	return;
 }
 
+void
+file::source::attach(int fd, std::error_code& err)
+{
+	err.clear();
+
+	if (m_is_open)
+	{
+		close(err);
+		if (err)
+			goto exit;
+	}
+
+	m_filename.clear();
+	m_fd = fd;
+	init_open(err);
+
+exit:
+	return;
+}
+
+void
+file::source::attach(int fd)
+{
+	std::error_code err;
+	attach(fd, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
 util::size_type
 file::source::really_get_size() const
 {
@@ -0,0 +1,141 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <bstream/huge_pages.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+
+using namespace bstream;
+
+namespace
+{
+/*
+ * Maps size bytes (a whole number of huge pages) of anonymous memory starting on a huge
+ * page boundary, or returns null.
+ */
+util::byte_type*
+map_aligned(util::size_type size) noexcept
+{
+	util::byte_type* result = nullptr;
+
+	// over-allocate by a page, then trim either end so the block starts on a page boundary
+	auto  span = size + huge_pages::page_size;
+	void* p    = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		goto exit;
+
+	{
+		auto addr    = reinterpret_cast<std::uintptr_t>(p);
+		auto aligned = (addr + huge_pages::page_size - 1) & ~static_cast<std::uintptr_t>(huge_pages::page_size - 1);
+		if (aligned > addr)
+		{
+			::munmap(p, aligned - addr);
+		}
+		auto tail = (addr + span) - (aligned + size);
+		if (tail > 0)
+		{
+			::munmap(reinterpret_cast<void*>(aligned + size), tail);
+		}
+		result = reinterpret_cast<util::byte_type*>(aligned);
+	}
+
+exit:
+	return result;
+}
+}    // namespace
+
+util::byte_type*
+huge_pages::allocate(util::size_type n) noexcept
+{
+	auto size   = round_up(n);
+	auto result = map_aligned(size);
+
+#ifdef MADV_HUGEPAGE
+	if (result)
+	{
+		::madvise(result, size, MADV_HUGEPAGE);
+	}
+#endif
+
+	return result;
+}
+
+void
+huge_pages::deallocate(util::byte_type* p, util::size_type n) noexcept
+{
+	if (p)
+	{
+		::munmap(p, round_up(n));
+	}
+}
+
+util::byte_type*
+huge_pages::reallocate(util::byte_type* p, util::size_type old_size, util::size_type new_size) noexcept
+{
+	util::byte_type* result = nullptr;
+	auto             old_span = round_up(old_size);
+	auto             new_span = round_up(new_size);
+
+	if (new_span == old_span)
+	{
+		result = p;
+		goto exit;
+	}
+
+#if defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+	{
+		// in place if the pages after the block are free (always, when shrinking)
+		void* q = ::mremap(p, old_span, new_span, 0);
+		if (q == MAP_FAILED)
+		{
+			// otherwise move the pages onto an aligned reservation, which mremap replaces;
+			// MREMAP_MAYMOVE alone could leave the block off a huge page boundary
+			auto target = map_aligned(new_span);
+			if (target == nullptr)
+				goto exit;
+			q = ::mremap(p, old_span, new_span, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+			if (q == MAP_FAILED)
+			{
+				::munmap(target, new_span);
+				goto exit;
+			}
+		}
+		result = static_cast<util::byte_type*>(q);
+	}
+#ifdef MADV_HUGEPAGE
+	::madvise(result, new_span, MADV_HUGEPAGE);
+#endif
+#else
+	result = allocate(new_size);
+	if (result == nullptr)
+		goto exit;
+	::memcpy(result, p, std::min(old_span, new_span));
+	deallocate(p, old_size);
+#endif
+
+exit:
+	return result;
+}
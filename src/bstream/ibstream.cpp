@@ -282,31 +282,7 @@ ibstream::ingest(util::bufwriter& os)
 std::size_t
 ibstream::read_string_header()
 {
-	std::size_t length = 0ul;
-	auto        tcode  = get();
-	if (tcode >= typecode::fixstr_min && tcode <= typecode::fixstr_max)
-	{
-		std::uint8_t mask = 0x1f;
-		length            = tcode & mask;
-	}
-	else
-	{
-		switch (tcode)
-		{
-			case typecode::str_8:
-				length = get_num<std::uint8_t>();
-				break;
-			case typecode::str_16:
-				length = get_num<std::uint16_t>();
-				break;
-			case typecode::str_32:
-				length = get_num<std::uint32_t>();
-				break;
-			default:
-				throw std::system_error{make_error_code(bstream::errc::expected_string)};
-		}
-	}
-	return length;
+	return decode_string_header(*this);
 }
 
 std::size_t
@@ -328,28 +304,7 @@ ibstream::read_string_header(std::error_code& err)
 std::size_t
 ibstream::read_array_header()
 {
-	std::size_t length = 0;
-	auto        tcode  = get();
-	if (tcode >= typecode::fixarray_min && tcode <= typecode::fixarray_max)
-	{
-		std::uint8_t mask = 0x0f;
-		length            = tcode & mask;
-	}
-	else
-	{
-		switch (tcode)
-		{
-			case typecode::array_16:
-				length = get_num<std::uint16_t>();
-				break;
-			case typecode::array_32:
-				length = get_num<std::uint32_t>();
-				break;
-			default:
-				throw std::system_error{make_error_code(bstream::errc::expected_array)};
-		}
-	}
-	return length;
+	return decode_array_header(*this);
 }
 
 std::size_t
@@ -371,28 +326,7 @@ ibstream::read_array_header(std::error_code& err)
 std::size_t
 ibstream::read_map_header()
 {
-	std::size_t length = 0;
-	auto        tcode  = get();
-	if (tcode >= typecode::fixmap_min && tcode <= typecode::fixarray_max)
-	{
-		std::uint8_t mask = 0x0f;
-		length            = tcode & mask;
-	}
-	else
-	{
-		switch (tcode)
-		{
-			case typecode::map_16:
-				length = get_num<std::uint16_t>();
-				break;
-			case typecode::map_32:
-				length = get_num<std::uint32_t>();
-				break;
-			default:
-				throw std::system_error{make_error_code(bstream::errc::expected_map)};
-		}
-	}
-	return length;
+	return decode_map_header(*this);
 }
 
 std::size_t
@@ -483,23 +417,7 @@ ibstream::check_map_header(std::size_t expected, std::error_code& err)
 std::size_t
 ibstream::read_blob_header()
 {
-	std::size_t length = 0;
-	auto        tcode  = get();
-	switch (tcode)
-	{
-		case typecode::bin_8:
-			length = get_num<std::uint8_t>();
-			break;
-		case typecode::bin_16:
-			length = get_num<std::uint16_t>();
-			break;
-		case typecode::bin_32:
-			length = get_num<std::uint32_t>();
-			break;
-		default:
-			throw std::system_error{make_error_code(bstream::errc::expected_blob)};
-	}
-	return length;
+	return decode_blob_header(*this);
 }
 
 std::size_t
@@ -546,6 +464,20 @@ ibstream::read_blob(std::error_code& err)
 	}
 }
 
+buffer_chain
+ibstream::read_blob_chain(std::error_code& err)
+{
+	auto nbytes = read_blob_header(err);
+	if (err)
+	{
+		return buffer_chain{};
+	}
+	else
+	{
+		return get_slice_chain(nbytes, err);
+	}
+}
+
 std::size_t
 ibstream::read_ext_header(std::uint8_t& ext_type)
 {
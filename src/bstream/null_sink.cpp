@@ -0,0 +1,90 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <bstream/null/sink.h>
+
+using namespace bstream;
+
+null::sink&
+null::sink::clear() noexcept
+{
+	m_base_offset = 0;
+	set_ptrs(m_scratch, m_scratch, m_scratch + sizeof(m_scratch));
+	reset_high_water_mark();
+	m_did_jump = false;
+	m_dirty    = false;
+	return *this;
+}
+
+void
+null::sink::really_jump(std::error_code& err)
+{
+	err.clear();
+	assert(m_did_jump);
+	assert(!m_dirty);    // previously flushed
+
+	// nothing is stored, so there is no gap to fill; as for other sinks, a jump past the
+	// high watermark extends the sequence once something is written there
+	m_base_offset = m_jump_to;
+	m_next        = m_base;
+	m_did_jump    = false;
+}
+
+bool
+null::sink::is_valid_position(util::position_type pos) const
+{
+	return pos >= 0;
+}
+
+void
+null::sink::really_overflow(util::size_type, std::error_code& err)
+{
+	err.clear();
+	m_base_offset += m_next - m_base;
+	m_next = m_base;
+}
+
+util::size_type
+null::sink::really_write_direct(const util::byte_type*, util::size_type n, std::error_code& err)
+{
+	err.clear();
+	// nothing is stored, so the bytes are counted without copying them to scratch
+	m_base_offset += (m_next - m_base) + n;
+	m_next  = m_base;
+	m_dirty = false;
+	if (m_base_offset > get_high_watermark())
+	{
+		force_high_watermark(m_base_offset);
+	}
+	return n;
+}
+
+void
+null::sink::really_truncate(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	force_high_watermark(pos);
+	m_base_offset = pos;
+	m_next        = m_base;
+}
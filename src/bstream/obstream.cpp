@@ -23,28 +23,54 @@
  */
 
 #include <bstream/obstream.h>
+#include <bstream/tee/sink.h>
 #include <util/error.h>
 
 using namespace bstream;
 
-obstream&
-obstream::write_map_header(std::uint32_t size)
+obstream::obstream(std::vector<bstream::sink*> const& targets, context_base const& context)
+	: obstream{std::make_unique<tee::sink>(targets, context.buffer_size(), context.byte_order()), context}
+{}
+
+void
+obstream::rollback(checkpoint_token const& token, std::error_code& err)
 {
-	if (size <= 15)
+	err.clear();
+	m_sink->truncate(token.size, err);
+	if (err)
+		goto exit;
+
+	if (token.position != static_cast<util::position_type>(token.size))
 	{
-		std::uint8_t code = 0x80 | static_cast<std::uint8_t>(size);
-		put(code);
+		m_sink->position(token.position, err);
+		if (err)
+			goto exit;
 	}
-	else if (size <= std::numeric_limits<std::uint16_t>::max())
+
+	if (m_ptr_deduper)
 	{
-		put(typecode::map_16);
-		put_num(static_cast<std::uint16_t>(size));
+		m_ptr_deduper->rollback(token.saved_ptrs);
 	}
-	else
+
+exit:
+	return;
+}
+
+void
+obstream::rollback(checkpoint_token const& token)
+{
+	std::error_code err;
+	rollback(token, err);
+	if (err)
 	{
-		put(typecode::map_32);
-		put_num(static_cast<std::uint32_t>(size));
+		throw std::system_error{err};
 	}
+}
+
+obstream&
+obstream::write_map_header(std::uint32_t size)
+{
+	encode_map_header(*this, size);
 	return *this;
 }
 
@@ -66,21 +92,7 @@ obstream::write_map_header(std::uint32_t size, std::error_code& err)
 obstream&
 obstream::write_array_header(std::uint32_t size)
 {
-	if (size <= 15)
-	{
-		std::uint8_t code = 0x90 | static_cast<std::uint8_t>(size);
-		put(code);
-	}
-	else if (size <= std::numeric_limits<std::uint16_t>::max())
-	{
-		put(typecode::array_16);
-		put_num(static_cast<std::uint16_t>(size));
-	}
-	else
-	{
-		put(typecode::array_32);
-		put_num(static_cast<std::uint32_t>(size));
-	}
+	encode_array_header(*this, size);
 	return *this;
 }
 
@@ -102,21 +114,7 @@ obstream::write_array_header(std::uint32_t size, std::error_code& err)
 obstream&
 obstream::write_blob_header(std::uint32_t size)
 {
-	if (size <= std::numeric_limits<std::uint8_t>::max())
-	{
-		put(typecode::bin_8);
-		put_num(static_cast<std::uint8_t>(size));
-	}
-	else if (size <= std::numeric_limits<std::uint16_t>::max())
-	{
-		put(typecode::bin_16);
-		put_num(static_cast<std::uint16_t>(size));
-	}
-	else
-	{
-		put(typecode::bin_32);
-		put_num(static_cast<std::uint32_t>(size));
-	}
+	encode_blob_header(*this, size);
 	return *this;
 }
 
@@ -0,0 +1,238 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <bstream/segment_pool.h>
+#include <algorithm>
+#include <new>
+
+using namespace bstream;
+
+namespace
+{
+// trivially destructible, so it can still be read after the thread's cache is gone
+thread_local bool t_cache_destroyed = false;
+}    // namespace
+
+class segment_pool::thread_cache
+{
+public:
+	~thread_cache()
+	{
+		t_cache_destroyed = true;
+		for (auto& e : m_entries)
+		{
+			if (e.pool && !e.segments.empty())
+			{
+				e.pool->put_global(e.segments.data(), e.segments.size());
+			}
+		}
+	}
+
+	std::vector<util::byte_type*>&
+	segments_for(segment_pool& pool)
+	{
+		if (m_entries.size() <= pool.m_index)
+		{
+			m_entries.resize(pool.m_index + 1);
+		}
+		auto& e = m_entries[pool.m_index];
+		if (!e.pool)
+		{
+			e.pool = &pool;
+			e.segments.reserve(BSTREAM_SEGMENT_POOL_LOCAL_CACHE_SIZE);
+		}
+		return e.segments;
+	}
+
+private:
+	struct entry
+	{
+		segment_pool*                 pool = nullptr;
+		std::vector<util::byte_type*> segments;
+	};
+
+	std::vector<entry> m_entries;
+};
+
+segment_pool::segment_pool(util::size_type segment_size, std::size_t index)
+	: m_segment_size{segment_size}, m_index{index}, m_mutex{}, m_free{}, m_limit{BSTREAM_SEGMENT_POOL_DEFAULT_LIMIT}
+{}
+
+segment_pool&
+segment_pool::instance(util::size_type segment_size)
+{
+	// pools are never destroyed; thread caches may refer to them until their threads exit
+	static std::mutex                  registry_mutex;
+	static std::vector<segment_pool*>* registry = new std::vector<segment_pool*>;
+
+	std::lock_guard<std::mutex> lock{registry_mutex};
+	for (auto pool : *registry)
+	{
+		if (pool->segment_size() == segment_size)
+		{
+			return *pool;
+		}
+	}
+	registry->push_back(new segment_pool{segment_size, registry->size()});
+	return *registry->back();
+}
+
+segment_pool::thread_cache*
+segment_pool::local_cache()
+{
+	if (t_cache_destroyed)
+	{
+		return nullptr;
+	}
+	thread_local thread_cache cache;
+	return &cache;
+}
+
+util::byte_type*
+segment_pool::allocate()
+{
+	util::byte_type* result = nullptr;
+	auto             cache  = local_cache();
+	if (cache)
+	{
+		auto& segments = cache->segments_for(*this);
+		if (segments.empty())
+		{
+			segments.resize(BSTREAM_SEGMENT_POOL_LOCAL_CACHE_SIZE / 2);
+			segments.resize(get_global(segments.data(), segments.size()));
+		}
+		if (!segments.empty())
+		{
+			result = segments.back();
+			segments.pop_back();
+		}
+	}
+	else
+	{
+		get_global(&result, 1);
+	}
+
+	if (!result)
+	{
+		result = static_cast<util::byte_type*>(::operator new(m_segment_size));
+	}
+	return result;
+}
+
+void
+segment_pool::deallocate(util::byte_type* segment) noexcept
+{
+	try
+	{
+		auto cache = local_cache();
+		if (cache)
+		{
+			auto& segments = cache->segments_for(*this);
+			if (segments.size() >= BSTREAM_SEGMENT_POOL_LOCAL_CACHE_SIZE)
+			{
+				auto half = segments.size() / 2;
+				put_global(segments.data() + segments.size() - half, half);
+				segments.resize(segments.size() - half);
+			}
+			segments.push_back(segment);
+		}
+		else
+		{
+			put_global(&segment, 1);
+		}
+	}
+	catch (...)
+	{
+		// the cache table couldn't grow
+		put_global(&segment, 1);
+	}
+}
+
+std::size_t
+segment_pool::limit() const
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	return m_limit;
+}
+
+void
+segment_pool::limit(std::size_t max_segments)
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	m_limit = max_segments;
+	while (m_free.size() > m_limit)
+	{
+		::operator delete(m_free.back());
+		m_free.pop_back();
+	}
+}
+
+std::size_t
+segment_pool::global_count() const
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	return m_free.size();
+}
+
+void
+segment_pool::trim()
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	for (auto segment : m_free)
+	{
+		::operator delete(segment);
+	}
+	m_free.clear();
+	m_free.shrink_to_fit();
+}
+
+void
+segment_pool::put_global(util::byte_type** segments, std::size_t n) noexcept
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		if (m_free.size() < m_limit)
+		{
+			try
+			{
+				m_free.push_back(segments[i]);
+				continue;
+			}
+			catch (...)
+			{}
+		}
+		::operator delete(segments[i]);
+	}
+}
+
+std::size_t
+segment_pool::get_global(util::byte_type** segments, std::size_t n)
+{
+	std::lock_guard<std::mutex> lock{m_mutex};
+	auto                        count = std::min(n, m_free.size());
+	std::copy(m_free.end() - count, m_free.end(), segments);
+	m_free.resize(m_free.size() - count);
+	return count;
+}
@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <bstream/byte_swap.h>
 #include <bstream/sink.h>
 
 using namespace bstream;
@@ -36,7 +38,9 @@ bstream::sink::sink(util::byte_type* data, util::size_type size, byte_order orde
 	  m_dirty_start{data},
 	  m_dirty{false},
 	  m_did_jump{false},
-	  m_reverse{is_reverse(order)}
+	  m_reverse{is_reverse(order)},
+	  m_eager_jumps{false},
+	  m_scratch_window{false}
 {}
 
 bstream::sink::sink(byte_order order)
@@ -49,7 +53,9 @@ bstream::sink::sink(byte_order order)
 	  m_dirty_start{nullptr},
 	  m_dirty{false},
 	  m_did_jump{false},
-	  m_reverse{is_reverse(order)}
+	  m_reverse{is_reverse(order)},
+	  m_eager_jumps{false},
+	  m_scratch_window{false}
 {}
 
 bstream::sink::sink(sink&& rhs)
@@ -62,8 +68,12 @@ bstream::sink::sink(sink&& rhs)
 	  m_dirty_start{rhs.m_dirty_start},
 	  m_dirty{rhs.m_dirty},
 	  m_did_jump{rhs.m_did_jump},
-	  m_reverse{rhs.m_reverse}
+	  m_reverse{rhs.m_reverse},
+	  m_eager_jumps{rhs.m_eager_jumps},
+	  m_scratch_window{false},
+	  m_window{std::move(rhs.m_window)}
 {
+	assert(!rhs.m_scratch_window);
 	rhs.m_base_offset    = 0;
 	rhs.m_high_watermark = 0;
 	rhs.m_jump_to        = 0;
@@ -77,6 +87,30 @@ bstream::sink::sink(sink&& rhs)
 
 void
 bstream::sink::flush(std::error_code& err)
+{
+	flush_buffer(err);
+	if (err)
+		goto exit;
+
+	really_drain(err);
+
+exit:
+	return;
+}
+
+void
+bstream::sink::flush()
+{
+	std::error_code err;
+	flush(err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
+void
+bstream::sink::flush_buffer(std::error_code& err)
 {
 	err.clear();
 	if (m_dirty)
@@ -94,7 +128,7 @@ exit:
 }
 
 void
-bstream::sink::flush()
+bstream::sink::flush_buffer()
 {
 	if (m_dirty)
 	{
@@ -110,7 +144,7 @@ bstream::sink::flush()
 }
 
 void
-bstream::sink::put(util::byte_type byte, std::error_code& err)
+bstream::sink::put_slow(util::byte_type byte, std::error_code& err)
 {
 	err.clear();
 	if (m_did_jump)
@@ -139,7 +173,7 @@ exit:
 }
 
 void
-bstream::sink::put(util::byte_type byte)
+bstream::sink::put_slow(util::byte_type byte)
 {
 	if (m_did_jump)
 	{
@@ -163,7 +197,7 @@ bstream::sink::put(util::byte_type byte)
 }
 
 void
-bstream::sink::putn(const util::byte_type* src, util::size_type n, std::error_code& err)
+bstream::sink::putn_slow(const util::byte_type* src, util::size_type n, std::error_code& err)
 {
 	err.clear();
 	if (n < 1)
@@ -190,6 +224,11 @@ bstream::sink::putn(const util::byte_type* src, util::size_type n, std::error_co
 	{
 		auto p     = src;
 		auto limit = src + n;
+
+		p += really_write_direct(src, n, err);
+		if (err)
+			goto exit;
+
 		while (p < limit)
 		{
 			if (m_base == nullptr || m_next >= m_end)
@@ -217,7 +256,7 @@ exit:
 }
 
 void
-bstream::sink::putn(const util::byte_type* src, util::size_type n)
+bstream::sink::putn_slow(const util::byte_type* src, util::size_type n)
 {
 	if (n > 0)
 	{
@@ -243,6 +282,14 @@ bstream::sink::putn(const util::byte_type* src, util::size_type n)
 		{
 			auto p     = src;
 			auto limit = src + n;
+
+			{
+				std::error_code err;
+				p += really_write_direct(src, n, err);
+				if (err)
+					throw std::system_error{err};
+			}
+
 			while (p < limit)
 			{
 				if (m_base == nullptr || m_next >= m_end)
@@ -267,6 +314,154 @@ bstream::sink::putn(const util::byte_type* src, util::size_type n)
 }
 
 
+void
+bstream::sink::put_reversed(const util::byte_type* src, util::size_type n, std::size_t width, std::error_code& err)
+{
+	err.clear();
+	while (n > 0)
+	{
+		util::size_type room = m_did_jump ? 0 : static_cast<util::size_type>(m_end - m_next) / width;
+		if (room < 1)
+		{
+			// let the general path resolve the jump or overflow, one element at a time
+			util::byte_type elem[8];
+			detail::reverse_copy(elem, src, 1, width);
+			putn_slow(elem, width, err);
+			if (err)
+				goto exit;
+			src += width;
+			--n;
+		}
+		else
+		{
+			util::size_type count = std::min(n, room);
+			if (!m_dirty)
+			{
+				m_dirty_start = m_next;
+				m_dirty       = true;
+			}
+			detail::reverse_copy(m_next, src, count, width);
+			m_next += count * width;
+			src += count * width;
+			n -= count;
+		}
+	}
+
+exit:
+	return;
+}
+
+void
+bstream::sink::put_reversed(const util::byte_type* src, util::size_type n, std::size_t width)
+{
+	while (n > 0)
+	{
+		util::size_type room = m_did_jump ? 0 : static_cast<util::size_type>(m_end - m_next) / width;
+		if (room < 1)
+		{
+			util::byte_type elem[8];
+			detail::reverse_copy(elem, src, 1, width);
+			putn_slow(elem, width);
+			src += width;
+			--n;
+		}
+		else
+		{
+			util::size_type count = std::min(n, room);
+			if (!m_dirty)
+			{
+				m_dirty_start = m_next;
+				m_dirty       = true;
+			}
+			detail::reverse_copy(m_next, src, count, width);
+			m_next += count * width;
+			src += count * width;
+			n -= count;
+		}
+	}
+}
+
+
+util::byte_type*
+bstream::sink::reserve_slow(util::size_type n, std::error_code& err)
+{
+	err.clear();
+	util::byte_type* result = nullptr;
+
+	if (m_did_jump)
+	{
+		really_jump(err);
+		if (err)
+			goto exit;
+	}
+
+	if (m_base == nullptr || m_next >= m_end)
+	{
+		overflow(n, err);
+		if (err)
+			goto exit;
+	}
+
+	if (n <= static_cast<util::size_type>(m_end - m_next))
+	{
+		result = m_next;
+	}
+	else if (!can_grow())
+	{
+		// the window could never be committed, and building it would allocate
+		err = make_error_code(std::errc::no_buffer_space);
+	}
+	else
+	{
+		if (m_window.size() < n)
+		{
+			m_window.resize(n);
+		}
+		m_scratch_window = true;
+		result           = m_window.data();
+	}
+
+exit:
+	return result;
+}
+
+util::byte_type*
+bstream::sink::reserve_slow(util::size_type n)
+{
+	std::error_code err;
+	auto            result = reserve_slow(n, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+	return result;
+}
+
+void
+bstream::sink::commit_slow(util::size_type k, std::error_code& err)
+{
+	assert(m_scratch_window);
+	assert(k <= m_window.size());
+	m_scratch_window = false;
+	if (k > 0)
+	{
+		putn_slow(m_window.data(), k, err);
+	}
+}
+
+void
+bstream::sink::commit_slow(util::size_type k)
+{
+	assert(m_scratch_window);
+	assert(k <= m_window.size());
+	m_scratch_window = false;
+	if (k > 0)
+	{
+		putn_slow(m_window.data(), k);
+	}
+}
+
+
 void
 bstream::sink::filln(const util::byte_type fill_byte, util::size_type n, std::error_code& err)
 {
@@ -387,10 +582,20 @@ bstream::sink::position(util::offset_type offset, seek_anchor where)
 	{
 		if (m_dirty)
 		{
-			flush();
+			flush_buffer();
 		}
 		m_did_jump = true;
 		m_jump_to  = new_pos;
+
+		if (m_eager_jumps)
+		{
+			std::error_code err;
+			jump_eagerly(err);
+			if (err)
+			{
+				throw std::system_error{err};
+			}
+		}
 	}
 
 	return new_pos;
@@ -413,12 +618,19 @@ bstream::sink::position(util::offset_type offset, seek_anchor where, std::error_
 	{
 		if (m_dirty)
 		{
-			flush(err);
+			flush_buffer(err);
 			if (err)
 				goto exit;
 		}
 		m_did_jump = true;
 		m_jump_to  = new_pos;
+
+		if (m_eager_jumps)
+		{
+			jump_eagerly(err);
+			if (err)
+				goto exit;
+		}
 	}
 
 exit:
@@ -434,7 +646,7 @@ bstream::sink::position() const
 void
 bstream::sink::overflow(util::size_type requested, std::error_code& err)
 {
-	flush(err);
+	flush_buffer(err);
 	if (err)
 		goto exit;
 
@@ -451,7 +663,7 @@ exit:
 void
 bstream::sink::overflow(util::size_type requested)
 {
-	flush();
+	flush_buffer();
 	std::error_code err;
 
 	really_overflow(requested, err);
@@ -494,12 +706,119 @@ bstream::sink::really_jump(std::error_code& err)
 	m_did_jump = false;
 }
 
+void
+bstream::sink::jump_eagerly(std::error_code& err)
+{
+	auto hwm = get_high_watermark();
+	really_jump(err);
+	if (err)
+		goto exit;
+
+	if (m_dirty)
+	{
+		// the zero-filled gap isn't output until something is written past it, as with
+		// a deferred jump; until then it is only storage
+		assert(ppos() > hwm);
+		force_high_watermark(hwm);
+		m_dirty = false;
+	}
+
+exit:
+	return;
+}
+
+void
+bstream::sink::splice(util::shared_buffer const& buf, std::error_code& err)
+{
+	err.clear();
+	if (buf.size() < 1)
+		goto exit;
+
+	really_splice(buf, err);
+
+exit:
+	return;
+}
+
+void
+bstream::sink::splice(util::shared_buffer const& buf)
+{
+	std::error_code err;
+	splice(buf, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
+void
+bstream::sink::really_splice(util::shared_buffer const& buf, std::error_code& err)
+{
+	putn(buf.data(), buf.size(), err);
+}
+
+void
+bstream::sink::truncate(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	if (pos < 0 || pos > static_cast<util::position_type>(size()))
+	{
+		err = make_error_code(std::errc::invalid_argument);
+		goto exit;
+	}
+
+	flush(err);
+	if (err)
+		goto exit;
+
+	m_did_jump = false;
+	really_truncate(pos, err);
+
+exit:
+	return;
+}
+
+void
+bstream::sink::truncate(util::position_type pos)
+{
+	std::error_code err;
+	truncate(pos, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+}
+
+void
+bstream::sink::really_truncate(util::position_type pos, std::error_code& err)
+{
+	// the output sequence is the internal sequence; positions before it are gone
+	err.clear();
+	assert(!m_dirty);
+	if (pos < m_base_offset)
+	{
+		err = make_error_code(std::errc::invalid_argument);
+		goto exit;
+	}
+	m_next = m_base + (pos - m_base_offset);
+	force_high_watermark(pos);
+
+exit:
+	return;
+}
+
 void
 bstream::sink::really_overflow(util::size_type, std::error_code& err)
 {
 	err = make_error_code(std::errc::no_buffer_space);
 }
 
+bool
+bstream::sink::can_grow() const
+{
+	return true;
+}
+
 void
 bstream::sink::really_flush(std::error_code& err)
 {
@@ -507,6 +826,19 @@ bstream::sink::really_flush(std::error_code& err)
 	assert(m_dirty && m_next > m_dirty_start);
 }
 
+void
+bstream::sink::really_drain(std::error_code& err)
+{
+	err.clear();
+}
+
+util::size_type
+bstream::sink::really_write_direct(const util::byte_type*, util::size_type, std::error_code& err)
+{
+	err.clear();
+	return 0;
+}
+
 util::size_type
 bstream::sink::really_get_size() const
 {
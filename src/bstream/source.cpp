@@ -22,6 +22,8 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <bstream/byte_swap.h>
 #include <bstream/error.h>
 #include <bstream/source.h>
 
@@ -55,6 +57,13 @@ source::really_rewind()
 	m_next = m_base;
 }
 
+util::size_type
+source::really_read_direct(util::byte_type*, util::size_type, std::error_code& err)
+{
+	err.clear();
+	return 0;
+}
+
 util::size_type
 source::really_get_size() const
 {
@@ -62,7 +71,7 @@ source::really_get_size() const
 }
 
 util::byte_type
-source::get(std::error_code& err)
+source::get_slow(std::error_code& err)
 {
 	err.clear();
 	util::byte_type result = 0;
@@ -85,7 +94,7 @@ exit:
 }
 
 util::byte_type
-source::get()
+source::get_slow()
 {
 	if (m_next >= m_end)
 	{
@@ -100,7 +109,7 @@ source::get()
 }
 
 util::byte_type
-source::peek(std::error_code& err)
+source::peek_slow(std::error_code& err)
 {
 	err.clear();
 	util::byte_type result = 0;
@@ -123,7 +132,7 @@ exit:
 }
 
 util::byte_type
-source::peek()
+source::peek_slow()
 {
 	if (m_next >= m_end)
 	{
@@ -211,8 +220,20 @@ source::get_slice(util::size_type n)
 	return util::const_buffer{std::move(buf)};
 }
 
+buffer_chain
+source::get_slice_chain(util::size_type n, std::error_code& err)
+{
+	return buffer_chain{get_shared_slice(n, err)};
+}
+
+buffer_chain
+source::get_slice_chain(util::size_type n)
+{
+	return buffer_chain{get_shared_slice(n)};
+}
+
 util::size_type
-source::getn(util::byte_type* dst, util::size_type n, std::error_code& err)
+source::getn_slow(util::byte_type* dst, util::size_type n, std::error_code& err)
 {
 	err.clear();
 	util::size_type result = 0;
@@ -237,6 +258,17 @@ source::getn(util::byte_type* dst, util::size_type n, std::error_code& err)
 			if (m_next >= m_end)
 			{
 				assert(m_next == m_end);
+				if (m_in_window)
+				{
+					leave_window();
+					continue;
+				}
+				p += really_read_direct(p, static_cast<util::size_type>(endp - p), err);
+				if (err)
+					goto exit;
+				if (p >= endp)
+					break;
+
 				auto available = underflow(err);
 				if (err)
 					goto exit;
@@ -260,7 +292,7 @@ exit:
 }
 
 util::size_type
-source::getn(util::byte_type* dst, util::size_type n)
+source::getn_slow(util::byte_type* dst, util::size_type n)
 {
 	util::size_type result = 0;
 	if (n < 1)
@@ -283,6 +315,20 @@ source::getn(util::byte_type* dst, util::size_type n)
 			if (m_next >= m_end)
 			{
 				assert(m_next == m_end);
+				if (m_in_window)
+				{
+					leave_window();
+					continue;
+				}
+				{
+					std::error_code err;
+					p += really_read_direct(p, static_cast<util::size_type>(endp - p), err);
+					if (err)
+						throw std::system_error{err};
+				}
+				if (p >= endp)
+					break;
+
 				if (underflow() < 1)
 				{
 					throw std::system_error{make_error_code(bstream::errc::read_past_end_of_stream)};
@@ -301,11 +347,184 @@ exit:
 	return result;
 }
 
+void
+source::get_reversed(util::byte_type* dst, util::size_type n, std::size_t width, std::error_code& err)
+{
+	err.clear();
+	while (n > 0)
+	{
+		util::size_type available = static_cast<util::size_type>(m_end - m_next) / width;
+		if (available < 1)
+		{
+			// the next element straddles the end of the internal sequence
+			util::byte_type elem[8];
+			if (getn_slow(elem, width, err) < width)
+			{
+				if (!err)
+				{
+					err = make_error_code(bstream::errc::read_past_end_of_stream);
+				}
+				goto exit;
+			}
+			detail::reverse_copy(dst, elem, 1, width);
+			dst += width;
+			--n;
+		}
+		else
+		{
+			util::size_type count = std::min(n, available);
+			detail::reverse_copy(dst, m_next, count, width);
+			m_next += count * width;
+			dst += count * width;
+			n -= count;
+		}
+	}
+
+exit:
+	return;
+}
+
+void
+source::get_reversed(util::byte_type* dst, util::size_type n, std::size_t width)
+{
+	while (n > 0)
+	{
+		util::size_type available = static_cast<util::size_type>(m_end - m_next) / width;
+		if (available < 1)
+		{
+			util::byte_type elem[8];
+			if (getn_slow(elem, width) < width)
+			{
+				throw std::system_error{make_error_code(bstream::errc::read_past_end_of_stream)};
+			}
+			detail::reverse_copy(dst, elem, 1, width);
+			dst += width;
+			--n;
+		}
+		else
+		{
+			util::size_type count = std::min(n, available);
+			detail::reverse_copy(dst, m_next, count, width);
+			m_next += count * width;
+			dst += count * width;
+			n -= count;
+		}
+	}
+}
+
+const util::byte_type*
+source::ensure_slow(util::size_type n, std::error_code& err)
+{
+	err.clear();
+	const util::byte_type* result   = nullptr;
+	util::size_type        got      = 0;
+	bool                   refilled = false;
+
+	if (m_in_window)
+	{
+		// carry the window's unread bytes over to the front of the new one
+		got = static_cast<util::size_type>(m_end - m_next);
+		::memmove(m_window.data(), m_next, got);
+		leave_window();
+		refilled = true;
+	}
+
+	if (m_window.size() < n)
+	{
+		m_window.resize(n);
+	}
+
+	while (got < n)
+	{
+		if (m_next >= m_end)
+		{
+			auto available = underflow(err);
+			if (err)
+				goto exit;
+			if (available < 1)
+			{
+				err = make_error_code(bstream::errc::read_past_end_of_stream);
+				goto exit;
+			}
+			refilled = true;
+		}
+		auto chunk = std::min(static_cast<util::size_type>(m_end - m_next), n - got);
+		::memcpy(m_window.data() + got, m_next, chunk);
+		m_next += chunk;
+		got += chunk;
+	}
+
+exit:
+	if (!refilled)
+	{
+		// everything stitched came from the internal sequence, which still holds it
+		m_next -= got;
+		result = err ? nullptr : m_next;
+	}
+	else if (got > 0)
+	{
+		enter_window(got);
+		result = err ? nullptr : m_next;
+	}
+	return result;
+}
+
+const util::byte_type*
+source::ensure_slow(util::size_type n)
+{
+	std::error_code err;
+	auto            result = ensure_slow(n, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+	return result;
+}
+
+void
+source::enter_window(util::size_type n)
+{
+	assert(!m_in_window);
+	assert(n <= m_window.size());
+	m_saved_base = m_base;
+	m_saved_next = m_next;
+	m_saved_end  = m_end;
+	m_base       = m_window.data();
+	m_next       = m_base;
+	m_end        = m_base + n;
+	m_in_window  = true;
+}
+
+void
+source::leave_window()
+{
+	assert(m_in_window);
+	m_base      = m_saved_base;
+	m_next      = m_saved_next;
+	m_end       = m_saved_end;
+	m_in_window = false;
+}
+
+util::size_type
+source::underflow(std::error_code& err)
+{
+	if (m_in_window)
+	{
+		leave_window();
+		if (m_next < m_end)
+		{
+			err.clear();
+			return static_cast<util::size_type>(m_end - m_next);
+		}
+	}
+	return really_underflow(err);
+}
+
 util::size_type
 source::underflow()
 {
 	std::error_code err;
-	auto            available = really_underflow(err);
+	auto            available = underflow(err);
 	if (err)
 	{
 		throw std::system_error{err};
@@ -321,7 +540,7 @@ source::new_position(util::offset_type offset, seek_anchor where) const
 	switch (where)
 	{
 		case seek_anchor::current:
-			result = really_get_position() + offset;
+			result = position() + offset;
 			break;
 
 		case seek_anchor::end:
@@ -349,6 +568,10 @@ source::position(util::offset_type offset, seek_anchor where, std::error_code& e
 		goto exit;
 	}
 
+	if (m_in_window)
+	{
+		leave_window();
+	}
 	result = really_seek(result, err);
 	if (err)
 		goto exit;
@@ -390,5 +613,5 @@ source::position(util::position_type pos, std::error_code& err)
 util::position_type
 source::position() const
 {
-	return really_get_position();
+	return m_in_window ? gpos() : really_get_position();
 }
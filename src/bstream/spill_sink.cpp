@@ -0,0 +1,356 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <bstream/bufseq/source.h>
+#include <bstream/error.h>
+#include <bstream/file/source.h>
+#include <bstream/spill/sink.h>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace bstream;
+
+spill::sink::sink(util::size_type threshold, util::size_type segment_size, std::string const& directory, byte_order order)
+	: base{segment_size, order},
+	  m_threshold{std::max(threshold, segment_size)},
+	  m_directory{directory},
+	  m_order{order},
+	  m_fd{-1}
+{}
+
+spill::sink::~sink()
+{
+	if (m_fd >= 0)
+	{
+		::close(m_fd);
+	}
+}
+
+spill::sink&
+spill::sink::clear() noexcept
+{
+	if (m_fd >= 0)
+	{
+		::close(m_fd);
+		m_fd = -1;
+	}
+	base::clear();
+	return *this;
+}
+
+spill::sink::buffers&
+spill::sink::get_buffers()
+{
+	if (is_spilled())
+	{
+		throw std::system_error{make_error_code(bstream::errc::invalid_state)};
+	}
+	return base::get_buffers();
+}
+
+spill::sink::buffers
+spill::sink::release_buffers()
+{
+	if (is_spilled())
+	{
+		throw std::system_error{make_error_code(bstream::errc::invalid_state)};
+	}
+	return base::release_buffers();
+}
+
+std::unique_ptr<bstream::source>
+spill::sink::get_source(std::error_code& err)
+{
+	err.clear();
+	std::unique_ptr<bstream::source> result;
+
+	if (m_dirty)
+	{
+		flush(err);
+		if (err)
+			goto exit;
+	}
+
+	if (!is_spilled())
+	{
+		std::deque<util::const_buffer> bufs;
+		for (auto const& buf : base::get_buffers())
+		{
+			bufs.emplace_back(buf);
+		}
+		result = std::make_unique<bufseq::source<util::const_buffer>>(std::move(bufs), m_order);
+	}
+	else
+	{
+		auto fd = ::dup(m_fd);
+		if (fd < 0)
+		{
+			err = std::error_code{errno, std::generic_category()};
+			goto exit;
+		}
+		auto src = std::make_unique<file::source>(m_segment_capacity, m_order);
+		src->attach(fd, err);
+		if (err)
+		{
+			::close(fd);
+			goto exit;
+		}
+		result = std::move(src);
+	}
+
+exit:
+	return result;
+}
+
+std::unique_ptr<bstream::source>
+spill::sink::get_source()
+{
+	std::error_code err;
+	auto            result = get_source(err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+	return result;
+}
+
+void
+spill::sink::really_overflow(util::size_type n, std::error_code& err)
+{
+	err.clear();
+	if (!is_spilled())
+	{
+		bool needs_segment = m_base == nullptr || m_current == m_bufs.size() - 1;
+		if (!needs_segment || m_offsets.back() + next_segment_capacity() <= m_threshold)
+		{
+			base::really_overflow(n, err);
+			goto exit;
+		}
+
+		spill(err);
+		if (err)
+			goto exit;
+	}
+
+	// the write buffer was emptied by the preceding flush
+	assert(m_base_offset == ppos() && m_next == m_base);
+
+exit:
+	return;
+}
+
+void
+spill::sink::really_flush(std::error_code& err)
+{
+	err.clear();
+	if (!is_spilled())
+	{
+		base::really_flush(err);
+		goto exit;
+	}
+
+	{
+		assert(m_dirty);
+		auto pos = ppos();
+		write_at(m_base, static_cast<util::size_type>(m_next - m_base), m_base_offset, err);
+		if (err)
+			goto exit;
+		m_base_offset = pos;
+		m_next        = m_base;
+	}
+
+exit:
+	return;
+}
+
+void
+spill::sink::really_splice(util::shared_buffer const& buf, std::error_code& err)
+{
+	if (is_spilled())
+	{
+		bstream::sink::really_splice(buf, err);    // copied into the file
+	}
+	else
+	{
+		base::really_splice(buf, err);
+	}
+}
+
+void
+spill::sink::really_truncate(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	if (!is_spilled())
+	{
+		base::really_truncate(pos, err);
+		goto exit;
+	}
+
+	if (::ftruncate(m_fd, pos) < 0)
+	{
+		err = std::error_code{errno, std::generic_category()};
+		goto exit;
+	}
+	force_high_watermark(pos);
+	m_base_offset = pos;
+	m_next        = m_base;
+
+exit:
+	return;
+}
+
+void
+spill::sink::really_jump(std::error_code& err)
+{
+	err.clear();
+	assert(m_did_jump);
+	assert(!m_dirty);
+
+	if (!is_spilled())
+	{
+		if (static_cast<util::size_type>(m_jump_to) <= m_threshold)
+		{
+			base::really_jump(err);    // may spill while filling a gap past the high watermark
+			goto exit;
+		}
+
+		spill(err);
+		if (err)
+			goto exit;
+	}
+
+	// a gap past the high watermark becomes a hole in the file, which reads as zeros
+	if (m_jump_to > get_high_watermark())
+	{
+		if (::ftruncate(m_fd, m_jump_to) < 0)
+		{
+			err = std::error_code{errno, std::generic_category()};
+			goto exit;
+		}
+		force_high_watermark(m_jump_to);
+	}
+	m_base_offset = m_jump_to;
+	m_next        = m_base;
+
+exit:
+	m_did_jump = false;
+}
+
+void
+spill::sink::spill(std::error_code& err)
+{
+	err.clear();
+	assert(!m_dirty);
+
+	auto pos = ppos();
+	auto hwm = static_cast<util::size_type>(get_high_watermark());
+
+	open_temp_file(err);
+	if (err)
+		goto exit;
+
+	for (util::size_type i = 0; i < m_bufs.size() && static_cast<util::size_type>(m_offsets[i]) < hwm; ++i)
+	{
+		auto offset = static_cast<util::size_type>(m_offsets[i]);
+		write_at(m_bufs[i].data(), std::min(segment_capacity(i), hwm - offset), offset, err);
+		if (err)
+		{
+			::close(m_fd);
+			m_fd = -1;
+			goto exit;
+		}
+	}
+
+	// keep one segment as the write buffer for the file
+	assert(!m_bufs.empty());
+	reset_segments();
+	{
+		auto buf_base = m_bufs[0].data();
+		set_ptrs(buf_base, buf_base, buf_base + segment_capacity(0));
+	}
+	m_base_offset = pos;
+
+exit:
+	return;
+}
+
+void
+spill::sink::open_temp_file(std::error_code& err)
+{
+	err.clear();
+
+	std::string dir = m_directory;
+	if (dir.empty())
+	{
+		auto tmpdir = std::getenv("TMPDIR");
+		dir         = (tmpdir && *tmpdir) ? tmpdir : "/tmp";
+	}
+
+#ifdef O_TMPFILE
+	m_fd = ::open(dir.c_str(), O_TMPFILE | O_RDWR, S_IRUSR | S_IWUSR);
+	if (m_fd >= 0)
+		goto exit;
+#endif
+
+	{
+		// no O_TMPFILE support here or in this file system; create a named file and unlink it
+		std::string       path = dir + "/bstream-spill-XXXXXX";
+		std::vector<char> name{path.begin(), path.end()};
+		name.push_back('\0');
+		m_fd = ::mkstemp(name.data());
+		if (m_fd < 0)
+		{
+			err = std::error_code{errno, std::generic_category()};
+			goto exit;
+		}
+		::unlink(name.data());
+	}
+
+exit:
+	return;
+}
+
+void
+spill::sink::write_at(const util::byte_type* src, util::size_type n, util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	while (n > 0)
+	{
+		auto result = ::pwrite(m_fd, src, n, pos);
+		if (result < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			err = std::error_code{errno, std::generic_category()};
+			break;
+		}
+		src += result;
+		pos += result;
+		n -= static_cast<util::size_type>(result);
+	}
+}
@@ -0,0 +1,218 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2017 David Curtis.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <bstream/tee/sink.h>
+
+using namespace bstream;
+
+tee::sink::sink(util::size_type buffer_size, byte_order order) : base{order}, m_buf{buffer_size}, m_targets{}
+{
+	reset_ptrs();
+}
+
+tee::sink::sink(std::vector<bstream::sink*> const& targets, util::size_type buffer_size, byte_order order)
+	: base{order}, m_buf{buffer_size}, m_targets{}
+{
+	reset_ptrs();
+	m_targets.reserve(targets.size());
+	for (auto target : targets)
+	{
+		assert(target != nullptr);
+		m_targets.push_back({target, target->position()});
+	}
+}
+
+tee::sink&
+tee::sink::add_target(bstream::sink& target, std::error_code& err)
+{
+	err.clear();
+	flush(err);
+	if (err)
+		goto exit;
+
+	m_targets.push_back({&target, target.position() - position()});
+
+exit:
+	return *this;
+}
+
+tee::sink&
+tee::sink::add_target(bstream::sink& target)
+{
+	std::error_code err;
+	add_target(target, err);
+	if (err)
+	{
+		throw std::system_error{err};
+	}
+	return *this;
+}
+
+void
+tee::sink::align_targets(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	for (auto& t : m_targets)
+	{
+		auto target_pos = t.origin + pos;
+		if (t.sink->position() != target_pos)
+		{
+			t.sink->position(target_pos, err);
+			if (err)
+				goto exit;
+		}
+	}
+
+exit:
+	return;
+}
+
+void
+tee::sink::really_flush(std::error_code& err)
+{
+	err.clear();
+	auto pos = ppos();
+	assert(m_dirty && m_next > m_dirty_start);
+	assert(m_dirty_start == m_base);
+
+	util::size_type n = static_cast<util::size_type>(m_next - m_base);
+
+	align_targets(m_base_offset, err);
+	if (err)
+		goto exit;
+
+	for (auto& t : m_targets)
+	{
+		t.sink->putn(m_base, n, err);
+		if (err)
+			goto exit;
+		t.sink->flush(err);
+		if (err)
+			goto exit;
+	}
+
+	m_base_offset = pos;
+	m_next        = m_base;
+exit:
+	return;
+}
+
+bool
+tee::sink::is_valid_position(util::position_type pos) const
+{
+	return pos >= 0;
+}
+
+void
+tee::sink::really_jump(std::error_code& err)
+{
+	err.clear();
+	assert(m_did_jump);
+
+	if (m_dirty)
+	{
+		flush(err);
+		if (err)
+			goto exit;
+	}
+
+	// targets follow at the next flush
+	m_base_offset = m_jump_to;
+	m_next        = m_base;
+	assert(ppos() == m_jump_to);
+
+exit:
+	m_did_jump = false;
+	return;
+}
+
+void
+tee::sink::really_overflow(util::size_type, std::error_code& err)
+{
+	err.clear();
+	assert(m_base_offset == ppos() && m_next == m_base);
+}
+
+void
+tee::sink::really_splice(util::shared_buffer const& buf, std::error_code& err)
+{
+	err.clear();
+	util::position_type pos = 0;
+
+	flush(err);
+	if (err)
+		goto exit;
+
+	if (m_did_jump)
+	{
+		really_jump(err);
+		if (err)
+			goto exit;
+	}
+
+	pos = ppos();
+	align_targets(pos, err);
+	if (err)
+		goto exit;
+
+	for (auto& t : m_targets)
+	{
+		t.sink->splice(buf, err);
+		if (err)
+			goto exit;
+		t.sink->flush(err);
+		if (err)
+			goto exit;
+	}
+
+	m_base_offset = pos + buf.size();
+	m_next        = m_base;
+	if (m_base_offset > get_high_watermark())
+	{
+		force_high_watermark(m_base_offset);
+	}
+
+exit:
+	return;
+}
+
+void
+tee::sink::really_truncate(util::position_type pos, std::error_code& err)
+{
+	err.clear();
+	assert(!m_dirty);
+
+	for (auto& t : m_targets)
+	{
+		t.sink->truncate(t.origin + pos, err);
+		if (err)
+			goto exit;
+	}
+	force_high_watermark(pos);
+	m_base_offset = pos;
+	m_next        = m_base;
+
+exit:
+	return;
+}
@@ -26,7 +26,17 @@
 #include "common.h"
 #include <doctest.h>
 #include <bstream/error.h>
+#include <bstream/ibstream.h>
+#include <bstream/obstream.h>
+#include <bstream/bufseq/source.h>
+#include <bstream/segment_pool.h>
+#include <bstream/spill/sink.h>
+#include <bstream/stdlib/vector.h>
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
 #include <util/buffer.h>
+#include <vector>
 
 using namespace bstream;
 
@@ -169,6 +179,499 @@ TEST_CASE("bstream::bufseq::sink [ smoke ] { expanding buffer with seek }")
 	// std::cout << "capacity is " << probe.buffer().capacity() << std::endl;
 }
 
+TEST_CASE("bstream::bufseq::sink [ smoke ] { numeric arrays straddling segments }")
+{
+	std::vector<std::uint16_t> shorts(77);
+	std::vector<std::uint32_t> ints(1000);
+	std::vector<double>        doubles(301);
+
+	for (std::size_t i = 0; i < shorts.size(); ++i)
+		shorts[i] = static_cast<std::uint16_t>(i * 0x0101 + 1);
+	for (std::size_t i = 0; i < ints.size(); ++i)
+		ints[i] = static_cast<std::uint32_t>(i * 0x01020304 + 7);
+	for (std::size_t i = 0; i < doubles.size(); ++i)
+		doubles[i] = i * 0.5 - 3.0;
+
+	// 30-byte segments, so that elements of every width straddle segment boundaries
+	bufseq::sink one_by_one{30};
+	bufseq::sink bulk{30};
+
+	std::error_code err;
+
+	one_by_one.put(0xa5);
+	for (auto v : shorts)
+		one_by_one.put_num(v);
+	for (auto v : ints)
+		one_by_one.put_num(v);
+	for (auto v : doubles)
+		one_by_one.put_num(v);
+
+	bulk.put(0xa5);
+	bulk.put_num_array(shorts.data(), shorts.size(), err);
+	CHECK(!err);
+	bulk.put_num_array(ints.data(), ints.size());
+	bulk.put_num_array(doubles.data(), doubles.size(), err);
+	CHECK(!err);
+
+	CHECK(bulk.size() == one_by_one.size());
+
+	std::deque<util::const_buffer> bufs;
+	std::vector<util::byte_type>   flat;
+	for (auto& buf : bulk.get_buffers())
+	{
+		bufs.emplace_back(buf);
+		flat.insert(flat.end(), buf.data(), buf.data() + buf.size());
+	}
+	std::vector<util::byte_type> expected;
+	for (auto& buf : one_by_one.get_buffers())
+	{
+		expected.insert(expected.end(), buf.data(), buf.data() + buf.size());
+	}
+	CHECK(flat == expected);
+
+	bufseq::source<util::const_buffer> src{bufs};
+
+	std::vector<std::uint16_t> shorts_in(shorts.size());
+	std::vector<std::uint32_t> ints_in(ints.size());
+	std::vector<double>        doubles_in(doubles.size());
+
+	CHECK(src.get() == 0xa5);
+	src.get_num_array(shorts_in.data(), shorts_in.size());
+	src.get_num_array(ints_in.data(), ints_in.size(), err);
+	CHECK(!err);
+	src.get_num_array(doubles_in.data(), doubles_in.size());
+
+	CHECK(shorts_in == shorts);
+	CHECK(ints_in == ints);
+	CHECK(doubles_in == doubles);
+
+	std::uint64_t past_end[1];
+	src.get_num_array(past_end, 1, err);
+	CHECK(err == bstream::errc::read_past_end_of_stream);
+	CHECK_THROWS_AS(src.get_num_array(past_end, 1), std::system_error);
+}
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { reserve and commit across segments }")
+{
+	util::byte_type expected[] = {
+			0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0xa0, 0xa1,
+			0xa2, 0xa3, 0xa4, 0xa5, 0xb0, 0xb1,
+	};
+
+	bufseq::sink snk{16};
+	std::error_code err;
+
+	snk.putn(&expected[0], 14);
+
+	// straddles the first segment boundary, so the window is a scratch area
+	util::byte_type* window = snk.reserve(6, err);
+	CHECK(!err);
+	REQUIRE(window != nullptr);
+	::memcpy(window, &expected[14], 6);
+	snk.commit(6, err);
+	CHECK(!err);
+	CHECK(snk.position() == 20);
+
+	// fits in the current segment
+	window = snk.reserve(8);
+	window[0] = 0xb0;
+	window[1] = 0xb1;
+	snk.commit(2);
+	snk.commit(0);
+	CHECK(snk.size() == 22);
+
+	CHECK(snk.get_buffers().size() == 2);
+	CHECK(MATCH_BUFFER(snk.get_buffers()[0], &expected[0]));
+	CHECK(MATCH_BUFFER(snk.get_buffers()[1], &expected[16]));
+
+	// serializers write through windows; their output must not depend on segment layout
+	obstream seg_os{std::make_unique<bufseq::sink>(7)};
+	obstream flat_os{std::make_unique<bufseq::sink>(4096)};
+	for (auto os : {&seg_os, &flat_os})
+	{
+		*os << std::string{"a short string"} << std::string(40, 'x') << std::string(300, 'y');
+		*os << 0x7f << 0xff << 0x1234 << 0x12345678 << 0x123456789aULL << -17 << -100 << -1000 << -100000;
+		*os << std::int64_t{-10000000000} << 1.5f << 2.5;
+		os->write_array_header(20).write_map_header(70000).write_blob_header(300);
+	}
+
+	std::vector<util::byte_type> seg_bytes;
+	for (auto& buf : static_cast<bufseq::sink&>(seg_os.get_sink()).get_buffers())
+		seg_bytes.insert(seg_bytes.end(), buf.data(), buf.data() + buf.size());
+	auto& flat_buf = static_cast<bufseq::sink&>(flat_os.get_sink()).get_buffers();
+	REQUIRE(flat_buf.size() == 1);
+	std::vector<util::byte_type> flat_bytes(flat_buf[0].data(), flat_buf[0].data() + flat_buf[0].size());
+	CHECK(seg_bytes == flat_bytes);
+
+	std::deque<util::const_buffer> bufs{util::const_buffer{flat_buf[0]}};
+	ibstream is{std::make_unique<bufseq::source<util::const_buffer>>(bufs)};
+	CHECK(is.read_as<std::string>() == "a short string");
+	CHECK(is.read_as<std::string>() == std::string(40, 'x'));
+	CHECK(is.read_as<std::string>() == std::string(300, 'y'));
+	CHECK(is.read_as<int>() == 0x7f);
+	CHECK(is.read_as<int>() == 0xff);
+	CHECK(is.read_as<int>() == 0x1234);
+	CHECK(is.read_as<int>() == 0x12345678);
+	CHECK(is.read_as<std::uint64_t>() == 0x123456789aULL);
+	CHECK(is.read_as<int>() == -17);
+	CHECK(is.read_as<int>() == -100);
+	CHECK(is.read_as<int>() == -1000);
+	CHECK(is.read_as<int>() == -100000);
+	CHECK(is.read_as<std::int64_t>() == -10000000000);
+	CHECK(is.read_as<float>() == 1.5f);
+	CHECK(is.read_as<double>() == 2.5);
+	CHECK(is.read_array_header() == 20);
+	CHECK(is.read_map_header() == 70000);
+	CHECK(is.read_blob_header() == 300);
+
+	// serializers reserve exactly what they write, so values that fit in front of a
+	// segment boundary go straight into the segment
+	obstream exact_os{std::make_unique<bufseq::sink>(8)};
+	auto&    exact = static_cast<bufseq::sink&>(exact_os.get_sink());
+	bufseq::detail::sink_test_probe exact_probe{exact};
+	exact_os.putn(&expected[0], 5);
+	exact_os << 200u << 1;
+	CHECK(exact.size() == 8);
+	exact_os << std::string{"abc"} << -1000;
+	exact_os.write_array_header(3);
+	CHECK(exact.size() == 16);
+	CHECK(exact_probe.segment_count() == 2);
+	CHECK(exact_probe.scratch_window_size() == 0);
+}
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { geometric segment growth }")
+{
+	util::byte_type data[200];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i);
+	}
+
+	bufseq::sink snk{8, 32};
+	snk.putn(data, sizeof(data));
+	CHECK(snk.size() == 200);
+	{
+		// 8 + 16 + 32 * 5 + 16
+		auto& bufs = snk.get_buffers();
+		CHECK(bufs.size() == 8);
+		CHECK(bufs[0].size() == 8);
+		CHECK(bufs[1].size() == 16);
+		CHECK(bufs[2].size() == 32);
+		CHECK(bufs[6].size() == 32);
+		CHECK(bufs[7].size() == 16);
+		CHECK(MATCH_BUFFER(bufs[1], &data[8]));
+		CHECK(MATCH_BUFFER(bufs[7], &data[184]));
+	}
+
+	// overwrite across the boundary between the 16- and 32-byte segments
+	snk.position(20);
+	std::uint64_t n{0xDEADBEEFCAFEBABEULL};
+	snk.put_num(n);
+	CHECK(snk.position() == 28);
+	data[20] = 0xDE;
+	data[21] = 0xAD;
+	data[22] = 0xBE;
+	data[23] = 0xEF;
+	data[24] = 0xCA;
+	data[25] = 0xFE;
+	data[26] = 0xBA;
+	data[27] = 0xBE;
+
+	// seek onto a segment boundary, then write through it
+	snk.position(24);
+	snk.put(0x24);
+	data[24] = 0x24;
+	CHECK(snk.size() == 200);
+
+	auto bufs = snk.release_buffers();
+	CHECK(bufs.size() == 8);
+	bufseq::source<util::const_buffer> src{std::move(bufs)};
+	util::byte_type readback[sizeof(data)];
+	src.getn(readback, sizeof(readback));
+	CHECK(std::equal(readback, readback + sizeof(readback), data));
+
+	for (util::position_type pos : {0, 7, 8, 23, 24, 56, 120, 184, 199})
+	{
+		src.position(pos);
+		CHECK(src.get() == data[pos]);
+	}
+
+	// after release, the sink starts over at the initial segment size
+	snk.putn(data, 10);
+	CHECK(snk.get_buffers().size() == 2);
+	CHECK(snk.get_buffers()[0].size() == 8);
+	CHECK(snk.get_buffers()[1].size() == 2);
+}
+
+namespace
+{
+// records the size of every allocation it makes
+class recording_allocator
+{
+public:
+	using value_type      = util::byte_type;
+	using pointer         = util::byte_type*;
+	using const_pointer   = const util::byte_type*;
+	using size_type       = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	explicit recording_allocator(std::vector<size_type>& sizes) : m_sizes{&sizes} {}
+
+	pointer
+	allocate(size_type n)
+	{
+		m_sizes->push_back(n);
+		return static_cast<pointer>(::operator new(n));
+	}
+
+	void
+	deallocate(pointer p, size_type) noexcept
+	{
+		::operator delete(p);
+	}
+
+	bool
+	operator==(recording_allocator const& rhs) const noexcept
+	{
+		return m_sizes == rhs.m_sizes;
+	}
+
+	bool
+	operator!=(recording_allocator const& rhs) const noexcept
+	{
+		return m_sizes != rhs.m_sizes;
+	}
+
+private:
+	std::vector<size_type>* m_sizes;
+};
+}    // namespace
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { grown segments use the allocator }")
+{
+	util::byte_type data[100] = {};
+	std::vector<std::size_t> sizes;
+
+	bufseq::sink snk{8, 32, recording_allocator{sizes}};
+	snk.putn(data, sizeof(data));
+	CHECK(snk.get_buffers().size() == 5);
+	CHECK(sizes == std::vector<std::size_t>{8, 16, 32, 32, 32});
+
+	// after release, the first segment is recreated at its initial size, with the same allocator
+	snk.release_buffers();
+	sizes.clear();
+	snk.putn(data, 10);
+	CHECK(sizes == std::vector<std::size_t>{8, 16});
+}
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { spliced blob }")
+{
+	util::byte_type blob_data[1000];
+	for (auto i = 0u; i < sizeof(blob_data); ++i)
+	{
+		blob_data[i] = static_cast<util::byte_type>(i * 7);
+	}
+	util::shared_buffer blob{blob_data, sizeof(blob_data)};
+
+	obstream os{std::make_unique<bufseq::sink>(64)};
+	os << std::string{"before"};
+	os.write_blob_ref(blob);
+	os << std::string{"after"};
+
+	auto& snk = static_cast<bufseq::sink&>(os.get_sink());
+	{
+		// the blob is a segment of its own, sharing the caller's storage
+		auto& bufs = snk.get_buffers();
+		REQUIRE(bufs.size() == 3);
+		CHECK(bufs[0].size() == 10);    // "before" and the blob header
+		CHECK(bufs[1].data() == blob.data());
+		CHECK(bufs[1].size() == blob.size());
+		CHECK(bufs[2].size() == 6);
+	}
+
+	// overwriting the string ahead of the blob leaves the caller's buffer alone
+	auto end = snk.position();
+	snk.position(1);
+	snk.putn(reinterpret_cast<const util::byte_type*>("BEFORE"), 6);
+	CHECK(std::equal(blob.data(), blob.data() + blob.size(), blob_data));
+
+	// ... as does writing into the spliced segment, which is then copied
+	snk.position(10);
+	snk.put(0xee);
+	CHECK(blob.data()[0] == blob_data[0]);
+	CHECK(snk.get_buffers()[1].data() != blob.data());
+	snk.position(10);
+	snk.put(blob_data[0]);
+	snk.position(end);
+
+	std::deque<util::const_buffer> segments;
+	for (auto const& buf : snk.get_buffers())
+	{
+		segments.emplace_back(buf);
+	}
+	ibstream is{std::make_unique<bufseq::source<util::const_buffer>>(segments)};
+	CHECK(is.read_as<std::string>() == "BEFORE");
+	CHECK(is.read_blob_header() == sizeof(blob_data));
+	auto body = is.read_blob_body(sizeof(blob_data));
+	CHECK(std::equal(body.data(), body.data() + body.size(), blob_data));
+	CHECK(is.read_as<std::string>() == "after");
+}
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { splice at segment boundaries }")
+{
+	util::shared_buffer a{"aaaa"};
+	util::shared_buffer b{"bbbbbb"};
+
+	bufseq::sink snk{8};
+	snk.splice(a);    // nothing written yet; the empty first segment follows a
+	snk.splice(b);    // back to back
+	snk.putn(reinterpret_cast<const util::byte_type*>("0123456789"), 10);
+	CHECK(snk.size() == 20);
+
+	// splicing after seeking backward copies instead
+	snk.position(4);
+	snk.splice(util::shared_buffer{"BB"});
+	CHECK(snk.position() == 6);
+	CHECK(snk.size() == 20);
+
+	auto bufs = snk.release_buffers();
+	REQUIRE(bufs.size() == 4);
+	CHECK(bufs[0].size() == 4);
+	CHECK(bufs[0].data() == a.data());
+	CHECK(bufs[1].size() == 6);
+	CHECK(bufs[1].data() != b.data());    // written into by the copied splice
+	CHECK(bufs[2].size() == 8);
+	CHECK(bufs[3].size() == 2);
+
+	std::string flat;
+	for (auto const& buf : bufs)
+	{
+		flat.append(reinterpret_cast<const char*>(buf.data()), buf.size());
+	}
+	CHECK(flat == "aaaaBBbbbb0123456789");
+	CHECK(b.to_string() == "bbbbbb");
+
+	// a released sink splices into a fresh sequence
+	snk.splice(a);
+	snk.put('x');
+	bufs = snk.release_buffers();
+	REQUIRE(bufs.size() == 2);
+	CHECK(bufs[0].data() == a.data());
+	CHECK(bufs[1].size() == 1);
+}
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { clear after unsharing a spliced first segment }")
+{
+	util::byte_type data[64];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i);
+	}
+
+	bufseq::sink snk{64};
+	snk.splice(util::shared_buffer{"12345678"});
+	snk.position(0);
+	snk.put('A');    // segment 0 becomes an 8-byte private copy
+	snk.clear();
+
+	// the first segment is back to full capacity
+	snk.putn(data, sizeof(data));
+	CHECK(snk.size() == sizeof(data));
+	auto bufs = snk.release_buffers();
+	REQUIRE(bufs.size() == 1);
+	CHECK(bufs[0].size() == sizeof(data));
+	CHECK(std::equal(bufs[0].data(), bufs[0].data() + bufs[0].size(), data));
+}
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { gathered write to file descriptor }")
+{
+	// more segments than one writev() call takes
+	std::vector<util::byte_type> data(24000);
+	for (auto i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 7);
+	}
+
+	bufseq::sink snk{16, 16};
+	snk.putn(data.data(), data.size());
+	CHECK(snk.get_buffers().size() == 1500);
+
+	int fds[2];
+	REQUIRE(::pipe(fds) == 0);
+	std::vector<util::byte_type> received;
+	std::thread                  reader{[&]() {
+		util::byte_type chunk[4096];
+		ssize_t         n;
+		while ((n = ::read(fds[0], chunk, sizeof(chunk))) > 0)
+		{
+			received.insert(received.end(), chunk, chunk + n);
+		}
+	}};
+
+	std::error_code err;
+	auto            written = snk.write_to(fds[1], err);
+	::close(fds[1]);
+	reader.join();
+	::close(fds[0]);
+
+	CHECK(!err);
+	CHECK(written == data.size());
+	CHECK(received == data);
+
+	// contents are still in place
+	CHECK(snk.size() == data.size());
+
+	written = snk.write_to(-1, err);
+	CHECK(err == std::errc::bad_file_descriptor);
+	CHECK(written == 0);
+	CHECK_THROWS_AS(snk.write_to(-1), std::system_error);
+}
+
+TEST_CASE("bstream::bufseq::source [ smoke ] { ensure across segments }")
+{
+	obstream os{std::make_unique<bufseq::sink>(4096)};
+	os << std::string{"fixed"} << 2.75 << 1.25f << std::string{"another fixed string"} << 3.0;
+	os.put(0x01).put(0x02).put(0x03).put(0x04);
+
+	auto&                          flat = static_cast<bufseq::sink&>(os.get_sink()).get_buffers()[0];
+	std::deque<util::const_buffer> segments;
+	for (util::size_type off = 0; off < flat.size(); off += 3)
+	{
+		segments.emplace_back(flat.data() + off, std::min(util::size_type{3}, flat.size() - off));
+	}
+
+	ibstream is{std::make_unique<bufseq::source<util::const_buffer>>(segments)};
+	CHECK(is.read_as<std::string>() == "fixed");
+	CHECK(is.read_as<double>() == 2.75);
+	CHECK(is.read_as<float>() == 1.25f);
+	CHECK(is.read_as<std::string>() == "another fixed string");
+	CHECK(is.read_as<double>() == 3.0);
+
+	// a stitched window that is only partly consumed gives the rest back
+	auto pos = is.position();
+	std::error_code err;
+	const util::byte_type* p = is.ensure(4, err);
+	CHECK(!err);
+	CHECK(p[0] == 0x01);
+	CHECK(p[3] == 0x04);
+	is.advance(1);
+	CHECK(is.position() == pos + 1);
+	CHECK(is.get() == 0x02);
+
+	CHECK(is.load_num<std::uint16_t>(is.ensure(2)) == 0x0304);
+	is.advance(2);
+
+	is.ensure(1, err);
+	CHECK(err == bstream::errc::read_past_end_of_stream);
+
+	// as does a failed one, across a segment boundary
+	is.position(pos + 2);
+	CHECK(is.ensure(3, err) == nullptr);
+	CHECK(err == bstream::errc::read_past_end_of_stream);
+	CHECK(is.position() == pos + 2);
+	CHECK(is.get() == 0x03);
+}
+
 TEST_CASE("bstream::bufseq::source [ smoke ] { basic util::const_buffer }")
 {
 	util::byte_type data_0[] = {
@@ -388,4 +891,317 @@ TEST_CASE("bstream::bufseq::source [ smoke ] { basic shared_buffer }")
 	CHECK(sb2.data() == src.get_buffers_ref()[6].data());
 	CHECK(sb2.size() == 1);
 	CHECK(sb2.data()[0] == expected[63]);
-}
\ No newline at end of file
+}
+TEST_CASE("bstream::bufseq::source [ smoke ] { blob chains }")
+{
+	util::byte_type blob_data[100];
+	for (auto i = 0u; i < sizeof(blob_data); ++i)
+	{
+		blob_data[i] = static_cast<util::byte_type>(i + 1);
+	}
+
+	obstream os{std::make_unique<bufseq::sink>(16)};
+	os.write_blob(blob_data, sizeof(blob_data));
+	os << 42;
+	auto released = static_cast<bufseq::sink&>(os.get_sink()).release_buffers();
+
+	std::deque<util::shared_buffer> segments;
+	for (auto& buf : released)
+	{
+		segments.emplace_back(util::shared_buffer{std::move(buf)});
+	}
+	REQUIRE(segments.size() == 7);
+
+	{
+		ibstream is{std::make_unique<bufseq::source<util::shared_buffer>>(segments)};
+		auto     chain = is.read_blob_chain();
+		CHECK(chain.size() == sizeof(blob_data));
+		REQUIRE(chain.segment_count() == 7);
+		CHECK(chain.segment(0).data() == segments[0].data() + 2);    // after the blob header
+		CHECK(chain.segment(0).size() == 14);
+		CHECK(chain.segment(3).data() == segments[3].data());
+		CHECK(chain.segment(6).size() == 6);
+
+		util::byte_type readback[sizeof(blob_data)];
+		CHECK(chain.copy(readback, sizeof(readback)) == sizeof(readback));
+		CHECK(std::equal(readback, readback + sizeof(readback), blob_data));
+		CHECK(chain.copy(readback, 4, 50) == 4);
+		CHECK(std::equal(readback, readback + 4, blob_data + 50));
+		auto flat = chain.flatten();
+		CHECK(std::equal(flat.data(), flat.data() + flat.size(), blob_data));
+
+		CHECK(is.read_as<int>() == 42);
+
+		std::error_code err;
+		is.position(2);
+		auto past_end = is.get_slice_chain(200, err);
+		CHECK(err == bstream::errc::read_past_end_of_stream);
+		CHECK(past_end.empty());
+
+		// the chain is the segmented slice
+		auto& src      = static_cast<bufseq::source<util::shared_buffer>&>(is.get_source());
+		auto  segments = src.get_segmented_slice(sizeof(blob_data), err);
+		CHECK(!err);
+		REQUIRE(segments.size() == 7);
+		CHECK(segments[0].data() == chain.segment(0).data());
+		CHECK(segments[6].size() == 6);
+		is.position(2);
+		CHECK(src.get_segmented_slice(200, err).empty());
+		CHECK(err == bstream::errc::read_past_end_of_stream);
+	}
+
+	{
+		// a source without shared segments copies into a single segment
+		std::deque<util::const_buffer> const_segments{segments.begin(), segments.end()};
+		ibstream                       is{std::make_unique<bufseq::source<util::const_buffer>>(const_segments)};
+		auto                           chain = is.read_blob_chain();
+		REQUIRE(chain.segment_count() == 1);
+		CHECK(std::equal(chain.segment(0).data(), chain.segment(0).data() + chain.size(), blob_data));
+		CHECK(is.read_as<int>() == 42);
+	}
+}
+
+TEST_CASE("bstream::bufseq::source [ smoke ] { consuming mode }")
+{
+	util::byte_type data[40];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i);
+	}
+
+	bufseq::source<util::shared_buffer> src;
+	src.append(util::shared_buffer{data, 10});
+	src.append(util::shared_buffer{data + 10, 10});
+	src.consuming(true);
+	CHECK(src.consuming());
+
+	util::byte_type got[40];
+	CHECK(src.getn(got, 15) == 15);
+	CHECK(src.position() == 15);
+	CHECK(src.get_buffers_ref().size() == 1);
+
+	// segments appended while reading keep absolute positions
+	src.append(util::shared_buffer{data + 20, 10});
+	src.append(util::shared_buffer{data + 30, 10});
+	CHECK(src.size() == 40);
+	CHECK(src.remaining() == 25);
+
+	CHECK(src.getn(got + 15, 10) == 10);
+	CHECK(src.get_buffers_ref().size() == 2);
+
+	std::error_code err;
+	src.position(10, err);
+	CHECK(err == std::errc::invalid_seek);
+	CHECK(src.position() == 25);
+	CHECK_THROWS_AS(src.rewind(), std::system_error);
+
+	// forward seeks are allowed and drop what they skip
+	src.position(32);
+	CHECK(src.get_buffers_ref().size() == 1);
+	CHECK(src.getn(got + 32, 8) == 8);
+	CHECK(std::equal(got, got + 25, data));
+	CHECK(std::equal(got + 32, got + 40, data + 32));
+}
+
+TEST_CASE("bstream::bufseq::source [ smoke ] { ensure in consuming mode }")
+{
+	util::byte_type data[30];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i);
+	}
+
+	bufseq::source<util::shared_buffer> src;
+	src.append(util::shared_buffer{data, 10});
+	src.append(util::shared_buffer{data + 10, 10});
+	src.append(util::shared_buffer{data + 20, 10});
+	src.consuming(true);
+
+	util::byte_type got[30];
+	CHECK(src.getn(got, 8) == 8);
+
+	// a window straddling two segments, mostly left unconsumed, without seeking back
+	std::error_code err;
+	auto            p = src.ensure(6, err);
+	REQUIRE(!err);
+	CHECK(std::equal(p, p + 6, data + 8));
+	src.advance(1, err);
+	CHECK(!err);
+	CHECK(src.position() == 9);
+	CHECK(src.remaining() == 21);
+	CHECK(src.get() == data[9]);
+
+	// the unconsumed bytes feed reads, slices and further windows
+	auto slice = src.get_shared_slice(2);
+	CHECK(std::equal(slice.data(), slice.data() + 2, data + 10));
+	p = src.ensure(4);
+	CHECK(std::equal(p, p + 4, data + 12));
+	src.advance(4);
+	auto segments = src.get_segmented_slice(6);
+	REQUIRE(segments.size() == 2);
+	CHECK(segments[0].size() + segments[1].size() == 6);
+	CHECK(std::equal(segments[0].data(), segments[0].data() + segments[0].size(), data + 16));
+	CHECK(segments[1].data()[segments[1].size() - 1] == data[21]);
+	CHECK(src.position() == 22);
+
+	// a window that runs off the end leaves the position where it was
+	CHECK(src.getn(got, 5) == 5);
+	CHECK(src.ensure(4, err) == nullptr);
+	CHECK(err == bstream::errc::read_past_end_of_stream);
+	CHECK(src.position() == 27);
+	CHECK(src.getn(got, 3) == 3);
+	CHECK(std::equal(got, got + 3, data + 27));
+}
+
+TEST_CASE("bstream::spill::sink [ smoke ] { spills past threshold }")
+{
+	std::vector<util::byte_type> expected(200);
+	for (auto i = 0u; i < expected.size(); ++i)
+	{
+		expected[i] = static_cast<util::byte_type>(i);
+	}
+
+	spill::sink snk{64, 32};
+	snk.putn(expected.data(), 60);
+	CHECK(!snk.is_spilled());
+	CHECK(snk.get_buffers().size() == 2);
+
+	snk.putn(expected.data() + 60, 140);
+	CHECK(snk.is_spilled());
+	CHECK(bufseq::detail::sink_test_probe{snk}.segment_count() == 1);
+	CHECK(snk.size() == 200);
+	CHECK_THROWS_AS(snk.get_buffers(), std::system_error);
+
+	// overwrite in place, then extend past the end
+	snk.position(10);
+	snk.put(0xee);
+	expected[10] = 0xee;
+	snk.position(250);
+	snk.put(0xdd);
+	expected.resize(251, 0);
+	expected[250] = 0xdd;
+	CHECK(snk.size() == 251);
+
+	auto src = snk.get_source();
+	CHECK(src->size() == 251);
+	std::vector<util::byte_type> actual(251);
+	src->getn(actual.data(), actual.size());
+	CHECK(actual == expected);
+
+	snk.clear();
+	CHECK(!snk.is_spilled());
+	CHECK(snk.size() == 0);
+	snk.put(1);
+	CHECK(snk.get_buffers()[0].size() == 1);
+}
+
+TEST_CASE("bstream::spill::sink [ smoke ] { streams before and after spilling }")
+{
+	std::vector<std::int64_t> small(4, -1);
+	std::vector<std::int64_t> large(5000);
+	for (auto i = 0u; i < large.size(); ++i)
+	{
+		large[i] = static_cast<std::int64_t>(i) * 1000003;
+	}
+
+	for (auto const* vec : {&small, &large})
+	{
+		obstream os{std::make_unique<spill::sink>(4096, 1024)};
+		os << *vec;
+		auto& snk = static_cast<spill::sink&>(os.get_sink());
+		CHECK(snk.is_spilled() == (vec == &large));
+
+		ibstream is{snk.get_source()};
+		CHECK(is.read_as<std::vector<std::int64_t>>() == *vec);
+	}
+
+	// a jump far past the threshold spills without filling memory
+	spill::sink snk{4096, 1024};
+	snk.put(7);
+	snk.position(1 << 20);
+	snk.put(8);
+	CHECK(snk.is_spilled());
+	CHECK(bufseq::detail::sink_test_probe{snk}.segment_count() == 1);
+	CHECK(snk.size() == (1 << 20) + 1);
+	auto src = snk.get_source();
+	CHECK(src->get() == 7);
+	src->position(1000);
+	CHECK(src->get() == 0);
+	src->position(1 << 20);
+	CHECK(src->get() == 8);
+}
+
+TEST_CASE("bstream::segment_pool [ smoke ] { recycling }")
+{
+	auto& pool = segment_pool::instance(96);
+	CHECK(&pool == &segment_pool::instance(96));
+	CHECK(pool.segment_size() == 96);
+
+	auto a = pool.allocate();
+	auto b = pool.allocate();
+	pool.deallocate(a);
+	CHECK(pool.allocate() == a);
+	pool.deallocate(a);
+	pool.deallocate(b);
+
+	// segments freed on another thread end up back in the global list when it exits
+	std::vector<util::byte_type*> segments;
+	for (auto i = 0; i < 40; ++i)
+	{
+		segments.push_back(pool.allocate());
+	}
+	pool.trim();
+	std::thread t{[&]() {
+		for (auto segment : segments)
+		{
+			pool.deallocate(segment);
+		}
+	}};
+	t.join();
+	CHECK(pool.global_count() == 40);
+
+	pool.limit(10);
+	CHECK(pool.global_count() == 10);
+	pool.limit(BSTREAM_SEGMENT_POOL_DEFAULT_LIMIT);
+	pool.trim();
+	CHECK(pool.global_count() == 0);
+}
+
+TEST_CASE("bstream::bufseq::sink [ smoke ] { pooled segments }")
+{
+	auto& pool = segment_pool::instance(64);
+
+	util::byte_type data[200];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i);
+	}
+
+	std::vector<const util::byte_type*> first;
+	{
+		bufseq::sink snk{pool};
+		snk.putn(data, sizeof(data));
+		auto bufs = snk.release_buffers();
+		CHECK(bufs.size() == 4);
+		for (auto const& buf : bufs)
+		{
+			first.push_back(buf.data());
+		}
+		bufseq::source<util::const_buffer> src{std::move(bufs)};
+		util::byte_type readback[sizeof(data)];
+		src.getn(readback, sizeof(readback));
+		CHECK(std::equal(readback, readback + sizeof(readback), data));
+	}
+
+	// the released buffers are gone, so their segments are reused
+	bufseq::sink snk{pool};
+	snk.putn(data, sizeof(data));
+	std::vector<const util::byte_type*> second;
+	for (auto const& buf : snk.get_buffers())
+	{
+		second.push_back(buf.data());
+	}
+	std::sort(first.begin(), first.end());
+	std::sort(second.begin(), second.end());
+	CHECK(first == second);
+}
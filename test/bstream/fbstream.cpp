@@ -23,6 +23,7 @@
  */
 
 #include <doctest.h>
+#include <bstream/huge_pages.h>
 #include <bstream/ifbstream.h>
 #include <bstream/ofbstream.h>
 
@@ -163,3 +164,44 @@ TEST_CASE("smoke/bstream/fbstream/write_read_ate")
 		os.close();
 	}
 }
+
+TEST_CASE("smoke/bstream/fbstream/huge_pages")
+{
+	bstream::context<> ctx{context_options{}.buffer_size(huge_pages::page_size).huge_pages(true)};
+
+	std::vector<std::uint8_t> data(huge_pages::page_size + 1000);
+	for (auto i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<std::uint8_t>(i * 7);
+	}
+	{
+		bstream::ofbstream os("fbstream_test_file", bstream::open_mode::truncate, ctx);
+		os.putn(data.data(), data.size());
+		os.close();
+	}
+	{
+		bstream::ifbstream is("fbstream_test_file", ctx);
+		auto               inbuf = is.get_slice(is.size());
+		CHECK(inbuf.size() == data.size());
+		CHECK(std::equal(inbuf.data(), inbuf.data() + inbuf.size(), data.data()));
+	}
+}
+
+TEST_CASE("smoke/bstream/fbstream/rollback")
+{
+	{
+		bstream::ofbstream os("fbstream_test_file", bstream::open_mode::truncate);
+		os << std::string{"kept"};
+		auto cp = os.checkpoint();
+		os << std::string(BSTREAM_DEFAULT_FILE_BUFFER_SIZE * 2, 'x');
+		os.rollback(cp);
+		os << std::string{"after"};
+		os.close();
+	}
+	{
+		bstream::ifbstream is("fbstream_test_file");
+		CHECK(is.read_as<std::string>() == "kept");
+		CHECK(is.read_as<std::string>() == "after");
+		CHECK(is.position() == is.size());
+	}
+}
@@ -28,6 +28,12 @@
 // #include <experimental/filesystem>
 #include <ghc/filesystem.hpp>
 #include <bstream/error.h>
+#include <bstream/file/async_sink.h>
+#include <bstream/file/mmap_sink.h>
+#include <bstream/file/mmap_source.h>
+#include <bstream/file/prefetch_source.h>
+#include <bstream/huge_pages.h>
+#include <bstream/ifbstream.h>
 
 using namespace bstream;
 
@@ -82,9 +88,10 @@ TEST_CASE("bstream::file::source [ smoke ] { source seek read }")
 		CHECK(!err);
 		CHECK(count == sizeof(data));
 		CHECK(probe.pos() == sizeof(data));
-		CHECK(probe.base_offset() == sizeof(data) - probe.buffer().capacity());
+		// larger than the buffer, so read directly into read_block
+		CHECK(probe.base_offset() == sizeof(data));
 		CHECK(probe.end() == probe.next());
-		CHECK((probe.base() + probe.buffer().capacity()) == probe.end());
+		CHECK(probe.base() == probe.end());
 
 		CHECK(MATCH_MEMORY(data, read_block));
 
@@ -152,9 +159,10 @@ TEST_CASE("bstream::file::sink [ smoke ] { sink seek write }")
 		CHECK(!err);
 		CHECK(count == sizeof(data));
 		CHECK(probe.pos() == sizeof(data));
-		CHECK(probe.base_offset() == sizeof(data) - probe.buffer().capacity());
+		// larger than the buffer, so read directly into read_block
+		CHECK(probe.base_offset() == sizeof(data));
 		CHECK(probe.end() == probe.next());
-		CHECK((probe.base() + probe.buffer().capacity()) == probe.end());
+		CHECK(probe.base() == probe.end());
 
 		CHECK(MATCH_MEMORY(expected, read_block));
 
@@ -228,9 +236,10 @@ TEST_CASE("bstream::file::sink [ smoke ] { sink seek write }")
 		CHECK(!err);
 		CHECK(count == sizeof(data));
 		CHECK(probe.pos() == sizeof(data));
-		CHECK(probe.base_offset() == sizeof(data) - probe.buffer().capacity());
+		// larger than the buffer, so read directly into read_block
+		CHECK(probe.base_offset() == sizeof(data));
 		CHECK(probe.end() == probe.next());
-		CHECK((probe.base() + probe.buffer().capacity()) == probe.end());
+		CHECK(probe.base() == probe.end());
 
 		CHECK(MATCH_MEMORY(data, read_block));
 
@@ -238,3 +247,375 @@ TEST_CASE("bstream::file::sink [ smoke ] { sink seek write }")
 		CHECK(!err);
 	}
 }
+
+TEST_CASE("bstream::file::mmap_source [ smoke ] { mapped reads and slices }")
+{
+	util::byte_type data[64];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 3);
+	}
+
+	if (!fs::is_directory("test_output") || !fs::exists("test_output"))
+	{
+		fs::create_directory("test_output");
+	}
+
+	{
+		file::sink snk{"test_output/file_mmap_0", open_mode::truncate, 16};
+		snk.putn(data, sizeof(data));
+		snk.close();
+	}
+
+	util::shared_buffer slice;
+	{
+		std::error_code   err;
+		file::mmap_source src{"test_output/file_mmap_0", err, file::map_advice::random, true};
+		CHECK(!err);
+		CHECK(src.is_open());
+		CHECK(src.size() == sizeof(data));
+
+		file::detail::source_test_probe probe{src};
+		CHECK(probe.buffer().capacity() == 0);
+		CHECK(probe.end() - probe.base() == sizeof(data));
+
+		util::byte_type read_block[16];
+		CHECK(src.getn(read_block, sizeof(read_block)) == sizeof(read_block));
+		CHECK(MATCH_MEMORY(read_block, data));
+
+		src.position(40);
+		CHECK(src.get() == data[40]);
+
+		// slices are views into the mapping
+		auto view = probe.next();
+		slice     = src.get_shared_slice(8);
+		CHECK(slice.data() == view);
+		CHECK(src.position() == 49);
+		CHECK(MATCH_BUFFER(slice, &data[41]));
+
+		src.get_shared_slice(16, err);
+		CHECK(err == bstream::errc::read_past_end_of_stream);
+
+		src.close();
+		CHECK(!src.is_open());
+	}
+	// the slice still holds the mapping
+	CHECK(MATCH_BUFFER(slice, &data[41]));
+
+	{
+		ifbstream is{std::make_unique<file::mmap_source>("test_output/file_mmap_0")};
+		CHECK(is.size() == sizeof(data));
+		is.position(8);
+		CHECK(is.get() == data[8]);
+
+		// reopening through ifbstream maps the file again
+		is.close();
+		is.open("test_output/file_mmap_0");
+		CHECK(is.is_open());
+		CHECK(is.get() == data[0]);
+	}
+
+	{
+		file::sink snk{"test_output/file_mmap_empty", open_mode::truncate, 16};
+		snk.close();
+	}
+	file::mmap_source empty{"test_output/file_mmap_empty"};
+	CHECK(empty.size() == 0);
+	std::error_code err;
+	empty.get(err);
+	CHECK(err == bstream::errc::read_past_end_of_stream);
+}
+
+TEST_CASE("bstream::file::mmap_sink [ smoke ] { mapped writes, growth and patching }")
+{
+	if (!fs::is_directory("test_output") || !fs::exists("test_output"))
+	{
+		fs::create_directory("test_output");
+	}
+
+	std::vector<util::byte_type> data(20000);
+	for (auto i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 7);
+	}
+
+	{
+		std::error_code err;
+		file::mmap_sink snk{"test_output/file_mmap_1", open_mode::truncate, err, file::map_sync::sync, 4096};
+		CHECK(!err);
+		CHECK(snk.is_open());
+		CHECK(snk.capacity() == 4096);
+
+		// grows past several growth steps
+		snk.putn(data.data(), data.size());
+		CHECK(snk.capacity() >= data.size());
+		CHECK(snk.size() == data.size());
+
+		// patch in place, then leave a gap past the end
+		snk.position(100);
+		snk.put_num(std::uint32_t{0xDEADBEEF});
+		data[100] = 0xDE;
+		data[101] = 0xAD;
+		data[102] = 0xBE;
+		data[103] = 0xEF;
+		snk.position(data.size() + 10);
+		snk.put(0x42);
+		data.resize(data.size() + 10, 0);
+		data.push_back(0x42);
+
+		snk.close(err);
+		CHECK(!err);
+		CHECK(fs::file_size("test_output/file_mmap_1") == data.size());
+	}
+	{
+		file::source                 src{"test_output/file_mmap_1"};
+		std::vector<util::byte_type> read_back(data.size());
+		CHECK(src.getn(read_back.data(), read_back.size()) == data.size());
+		CHECK(read_back == data);
+	}
+	{
+		// reopen at the end, append, and trim with truncate()
+		file::mmap_sink snk{"test_output/file_mmap_1", open_mode::at_end};
+		CHECK(snk.position() == data.size());
+		snk.put(0x01);
+		snk.put(0x02);
+		snk.truncate(data.size() + 1);
+		snk.close();
+		CHECK(fs::file_size("test_output/file_mmap_1") == data.size() + 1);
+	}
+}
+
+TEST_CASE("bstream::file::async_sink [ smoke ] { write-behind, patching and deferred errors }")
+{
+	if (!fs::is_directory("test_output") || !fs::exists("test_output"))
+	{
+		fs::create_directory("test_output");
+	}
+
+	std::vector<util::byte_type> data(50000);
+	for (auto i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 13);
+	}
+
+	{
+		std::error_code  err;
+		file::async_sink snk{"test_output/file_async_1", open_mode::truncate, err, 1024, 2};
+		CHECK(!err);
+		CHECK(snk.is_open());
+		CHECK(snk.buffer_count() == 2);
+
+		// many more buffers' worth than the sink owns
+		for (auto i = 0u; i < data.size(); i += 100)
+		{
+			snk.putn(data.data() + i, std::min(std::size_t{100}, data.size() - i));
+		}
+		snk.flush(err);
+		CHECK(!err);
+		CHECK(fs::file_size("test_output/file_async_1") == data.size());
+
+		// patch behind the end, then leave a gap past it
+		snk.position(3000);
+		snk.put_num(std::uint32_t{0xDEADBEEF});
+		data[3000] = 0xDE;
+		data[3001] = 0xAD;
+		data[3002] = 0xBE;
+		data[3003] = 0xEF;
+		snk.position(data.size() + 10);
+		snk.put(0x42);
+		data.resize(data.size() + 10, 0);
+		data.push_back(0x42);
+
+		snk.close(err);
+		CHECK(!err);
+		CHECK(!snk.is_open());
+		CHECK(fs::file_size("test_output/file_async_1") == data.size());
+	}
+	{
+		file::source                 src{"test_output/file_async_1"};
+		std::vector<util::byte_type> read_back(data.size());
+		CHECK(src.getn(read_back.data(), read_back.size()) == data.size());
+		CHECK(read_back == data);
+	}
+	{
+		// reopen at the end, append, and trim with truncate()
+		file::async_sink snk{"test_output/file_async_1", open_mode::at_end};
+		CHECK(snk.position() == data.size());
+		snk.put(0x01);
+		snk.put(0x02);
+		snk.truncate(data.size() + 1);
+		CHECK(snk.size() == data.size() + 1);
+		snk.close();
+		CHECK(fs::file_size("test_output/file_async_1") == data.size() + 1);
+	}
+	{
+		// a failed write on the I/O thread surfaces from flush()
+		std::error_code  err;
+		file::async_sink snk{"/dev/full", open_mode::at_begin, err, 64, 2};
+		CHECK(!err);
+		snk.putn(data.data(), 32);
+		snk.flush(err);
+		CHECK(err == std::errc::no_space_on_device);
+		snk.close(err);
+		CHECK(!err);
+	}
+}
+
+TEST_CASE("bstream::file::prefetch_source [ smoke ] { read-ahead and redirected seeks }")
+{
+	if (!fs::is_directory("test_output") || !fs::exists("test_output"))
+	{
+		fs::create_directory("test_output");
+	}
+
+	std::vector<util::byte_type> data(10000);
+	for (auto i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 11);
+	}
+	{
+		file::sink snk{"test_output/file_prefetch_0", open_mode::truncate, 4096};
+		snk.putn(data.data(), data.size());
+		snk.close();
+	}
+
+	{
+		std::error_code       err;
+		file::prefetch_source src{"test_output/file_prefetch_0", err, 1000, 3};
+		CHECK(!err);
+		CHECK(src.is_open());
+		CHECK(src.size() == data.size());
+		CHECK(src.buffer_count() == 3);
+
+		// sequential read across many chunks
+		std::vector<util::byte_type> read_back(data.size());
+		CHECK(src.getn(read_back.data(), read_back.size()) == data.size());
+		CHECK(read_back == data);
+		src.get(err);
+		CHECK(err == bstream::errc::read_past_end_of_stream);
+
+		// backward, within a chunk, and forward seeks
+		src.position(1500);
+		CHECK(src.get() == data[1500]);
+		src.position(1200);
+		CHECK(src.get() == data[1200]);
+		src.position(8999);
+		CHECK(src.get() == data[8999]);
+		CHECK(src.get() == data[9000]);
+		src.rewind();
+		CHECK(src.position() == 0);
+		CHECK(src.get() == data[0]);
+
+		src.close();
+		CHECK(!src.is_open());
+	}
+
+	{
+		// exactly one chunk, then end of file
+		file::prefetch_source        src{"test_output/file_prefetch_0", 5000, 2};
+		std::vector<util::byte_type> read_back(data.size());
+		CHECK(src.getn(read_back.data(), read_back.size()) == data.size());
+		CHECK(read_back == data);
+	}
+
+	{
+		ifbstream is{std::make_unique<file::prefetch_source>("test_output/file_prefetch_0", 512)};
+		CHECK(is.size() == data.size());
+		is.position(4097);
+		CHECK(is.get() == data[4097]);
+	}
+}
+
+TEST_CASE("bstream::file::sink [ smoke ] { large transfers bypass the buffer }")
+{
+	if (!fs::is_directory("test_output") || !fs::exists("test_output"))
+	{
+		fs::create_directory("test_output");
+	}
+
+	std::vector<util::byte_type> data(4210);
+	for (auto i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 17);
+	}
+
+	{
+		file::sink snk{"test_output/file_direct_0", open_mode::truncate, 256};
+		file::detail::sink_test_probe probe{snk};
+
+		// buffered head and payload go out together
+		snk.putn(data.data(), 10);
+		snk.putn(data.data() + 10, 3000);
+		CHECK(snk.position() == 3010);
+		CHECK(snk.size() == 3010);
+		CHECK(probe.next() == probe.base());
+		CHECK(!probe.dirty());
+
+		// a payload alone, then buffered output after it
+		snk.putn(data.data() + 3010, 1000);
+		snk.putn(data.data() + 4010, 200);
+		CHECK(snk.position() == data.size());
+		CHECK(fs::file_size("test_output/file_direct_0") == 4010);
+		snk.close();
+		CHECK(fs::file_size("test_output/file_direct_0") == data.size());
+	}
+
+	{
+		file::source                   src{"test_output/file_direct_0", 0, 256};
+		file::detail::source_test_probe probe{src};
+		std::vector<util::byte_type>   read_back(data.size());
+
+		// buffered head, then the rest straight from the file
+		CHECK(src.getn(read_back.data(), 10) == 10);
+		CHECK(src.getn(read_back.data() + 10, 3000) == 3000);
+		CHECK(src.position() == 3010);
+		CHECK(probe.next() == probe.end());
+		CHECK(src.getn(read_back.data() + 3010, 1200) == 1200);
+		CHECK(read_back == data);
+
+		std::error_code err;
+		src.position(3000);
+		src.getn(read_back.data(), 2000, err);
+		CHECK(err == bstream::errc::read_past_end_of_stream);
+	}
+}
+
+TEST_CASE("bstream::file::sink [ smoke ] { huge pages size up the buffer }")
+{
+	if (!fs::is_directory("test_output") || !fs::exists("test_output"))
+	{
+		fs::create_directory("test_output");
+	}
+
+	util::byte_type data[100];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 5);
+	}
+
+	{
+		// a default-sized buffer is below huge_pages::min_size; it grows to a whole huge page
+		file::sink                    snk{"test_output/file_huge_0", open_mode::truncate, 64 * 1024};
+		file::detail::sink_test_probe probe{snk};
+		snk.putn(data, 10);
+		snk.huge_pages(true);
+		CHECK(probe.buffer().capacity() == huge_pages::page_size);
+		CHECK(reinterpret_cast<std::uintptr_t>(probe.base()) % huge_pages::page_size == 0);
+		snk.putn(data + 10, sizeof(data) - 10);
+		snk.close();
+		CHECK(fs::file_size("test_output/file_huge_0") == sizeof(data));
+	}
+
+	{
+		file::source                    src{"test_output/file_huge_0", 0, 64 * 1024};
+		file::detail::source_test_probe probe{src};
+		CHECK(src.get() == data[0]);
+		src.huge_pages(true);
+		CHECK(probe.buffer().capacity() == huge_pages::page_size);
+		CHECK(reinterpret_cast<std::uintptr_t>(probe.base()) % huge_pages::page_size == 0);
+		util::byte_type read_back[sizeof(data)];
+		read_back[0] = src.get();
+		CHECK(src.getn(read_back + 1, sizeof(data) - 2) == sizeof(data) - 2);
+		CHECK(std::equal(read_back, read_back + sizeof(data) - 1, data + 1));
+	}
+}
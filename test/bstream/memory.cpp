@@ -25,11 +25,73 @@
 #include "test_probes/buffer.h"
 #include "common.h"
 #include <doctest.h>
+#include <bstream/basic_ibstream.h>
+#include <bstream/basic_obstream.h>
+#include <bstream/buffer/source.h>
+#include <bstream/bufseq/sink.h>
+#include <bstream/container/sink.h>
 #include <bstream/error.h>
+#include <bstream/fixed_obstream.h>
+#include <bstream/huge_pages.h>
+#include <bstream/macros.h>
+#include <bstream/ombstream.h>
+#include <bstream/serialized_size.h>
+#include <bstream/span_ibstream.h>
+#include <bstream/stdlib/pair.h>
+#include <bstream/stdlib/tuple.h>
+#include <bstream/stdlib/vector.h>
+#include <bstream/tee/sink.h>
 #include <util/buffer.h>
 
 using namespace bstream;
 
+namespace serialized_size_types
+{
+
+class point : BSTRM_BASE(point)
+{
+public:
+	point(std::int32_t x, std::int32_t y, double weight) : x_{x}, y_{y}, weight_{weight} {}
+
+	BSTRM_CLASS(point, , (x_, y_, weight_))
+
+private:
+	std::int32_t x_;
+	std::int32_t y_;
+	double       weight_;
+};
+
+class tagged_point : BSTRM_BASE(tagged_point), public point
+{
+public:
+	tagged_point(point const& p, std::uint16_t tag, bool visible) : point{p}, tag_{tag}, visible_{visible} {}
+
+	BSTRM_CLASS(tagged_point, (point), (tag_, visible_))
+
+private:
+	std::uint16_t tag_;
+	bool          visible_;
+};
+
+class labeled_point : BSTRM_BASE(labeled_point), public point
+{
+public:
+	labeled_point(point const& p, std::string const& label) : point{p}, label_{label} {}
+
+	BSTRM_CLASS(labeled_point, (point), (label_))
+
+private:
+	std::string label_;
+};
+
+class unstreamed_point : public point
+{
+public:
+	using point::point;
+};
+
+}    // namespace serialized_size_types
+
 
 TEST_CASE("bstream::buffer::sink [ smoke ] { basic functionality }")
 {
@@ -196,6 +258,261 @@ TEST_CASE("bstream::buffer::sink [ smoke ] { seek expanding buffer }")
 	std::cout << "capacity is " << probe.buffer().capacity() << std::endl;
 }
 
+TEST_CASE("bstream::buffer::sink [ smoke ] { growth policy }")
+{
+	growth_policy growth;
+	CHECK(growth.next_capacity(32, 33) == 49);
+	CHECK(growth.next_capacity(32, 40) == 60);
+	CHECK(growth.next_capacity(1000, 1001) == 1501);
+
+	growth.factor   = 4.0;
+	growth.max_step = 100;
+	CHECK(growth.next_capacity(32, 40) == 140);
+	growth.min_step = 64;
+	growth.factor   = 1.0;
+	CHECK(growth.next_capacity(32, 40) == 96);
+
+	bstream::context<> ctx{context_options{}.buffer_size(16).growth_factor(1.0).growth_min_step(16).growth_max_step(32)};
+	CHECK(ctx.buffer_growth().max_step == 32);
+
+	util::byte_type data[1000];
+	for (auto i = 0u; i < sizeof(data); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 3);
+	}
+
+	ombstream os{ctx};
+	os.putn(data, 100);
+	auto early = os.get_buffer();
+	CHECK(early.size() == 100);
+	CHECK(os.get_sink().get_buffer_ref().capacity() <= 100 + 32);
+
+	// growing past a buffer already handed out leaves that buffer intact
+	os.putn(data + 100, 900);
+	CHECK(std::equal(early.data(), early.data() + early.size(), data));
+	auto all = os.get_buffer();
+	CHECK(all.size() == 1000);
+	CHECK(std::equal(all.data(), all.data() + all.size(), data));
+	CHECK(os.get_sink().get_buffer_ref().capacity() <= 1000 + 32);
+
+	auto released = os.get_sink().release_buffer();
+	CHECK(std::equal(released.data(), released.data() + released.size(), data));
+	os.putn(data, 20);
+	CHECK(os.get_buffer().size() == 20);
+	CHECK(std::equal(os.get_buffer().data(), os.get_buffer().data() + 20, data));
+
+	// a released buffer can seed another stream that keeps growing it
+	os.putn(data + 20, 980);
+	auto storage = detail::sink_test_probe{os.get_sink()}.base();
+	auto mbuf    = os.release_mutable_buffer();
+	CHECK(mbuf.size() == 1000);
+	CHECK(mbuf.is_expandable());
+	CHECK(mbuf.data() == storage);
+	CHECK(std::equal(mbuf.data(), mbuf.data() + 1000, data));
+	ombstream os2{std::move(mbuf), ctx};
+	os2.putn(data, 1000);
+	os2.putn(data, 1000);
+	auto grown = os2.get_buffer();
+	REQUIRE(grown.size() == 2000);
+	CHECK(std::equal(grown.data(), grown.data() + 1000, data));
+	CHECK(std::equal(grown.data() + 1000, grown.data() + 2000, data));
+}
+
+TEST_CASE("bstream::huge_pages [ smoke ] { allocation and growth }")
+{
+	auto size = huge_pages::page_size + 100;
+	auto p    = huge_pages::allocate(size);
+	REQUIRE(p != nullptr);
+	CHECK(reinterpret_cast<std::uintptr_t>(p) % huge_pages::page_size == 0);
+	for (util::size_type i = 0; i < size; i += 4096)
+	{
+		p[i] = static_cast<util::byte_type>(i >> 12);
+	}
+	// another block, likely mapped just past p, may force growth to move it; either way it stays aligned
+	auto blocker = huge_pages::allocate(huge_pages::page_size);
+	auto q       = huge_pages::reallocate(p, size, 3 * huge_pages::page_size);
+	REQUIRE(q != nullptr);
+	CHECK(reinterpret_cast<std::uintptr_t>(q) % huge_pages::page_size == 0);
+	huge_pages::deallocate(blocker, huge_pages::page_size);
+	bool intact = true;
+	for (util::size_type i = 0; i < size; i += 4096)
+	{
+		intact = intact && q[i] == static_cast<util::byte_type>(i >> 12);
+	}
+	CHECK(intact);
+	huge_pages::deallocate(q, 3 * huge_pages::page_size);
+
+	// small requests don't take a huge page
+	huge_page_allocator alloc;
+	auto                small = alloc.allocate(64);
+	alloc.deallocate(small, 64);
+	auto large = alloc.allocate(huge_pages::min_size);
+	CHECK(reinterpret_cast<std::uintptr_t>(large) % huge_pages::page_size == 0);
+	alloc.deallocate(large, huge_pages::min_size);
+
+	bstream::context<> ctx{context_options{}.huge_pages(true)};
+	CHECK(ctx.huge_pages());
+
+	std::vector<util::byte_type> data(3 * huge_pages::page_size);
+	for (auto i = 0u; i < data.size(); ++i)
+	{
+		data[i] = static_cast<util::byte_type>(i * 13);
+	}
+	ombstream os{ctx};
+	CHECK(os.get_sink().huge_pages());
+	os.putn(data.data(), data.size() / 2);
+	os.putn(data.data() + data.size() / 2, data.size() - data.size() / 2);
+	auto buf = os.get_buffer();
+	CHECK(reinterpret_cast<std::uintptr_t>(buf.data()) % 4096 == 0);
+	CHECK(buf.size() == data.size());
+	CHECK(std::equal(buf.data(), buf.data() + buf.size(), data.data()));
+}
+
+TEST_CASE("bstream::tee::sink [ smoke ] { fan-out to several sinks }")
+{
+	buffer::sink log{8};
+	bufseq::sink replay{16};
+	bufseq::sink peer{16};
+
+	// a target that already holds output receives the tee's output after it
+	util::byte_type header[] = {0xAA, 0xBB};
+	peer.putn(header, sizeof(header));
+
+	obstream os{{&log, &replay, &peer}};
+	os << std::string{"tee"} << std::uint32_t{0xDEADBEEF};
+	os.write_array_header(2);
+	os << 1 << 2;
+	auto end = os.position();
+
+	// rewrite the first byte of the array elements
+	os.position(end - 2);
+	os << 3;
+	os.position(end);
+	os.write_blob_ref(util::shared_buffer{"spliced"});
+	os.get_sink().flush();
+
+	ombstream ref{util::size_type{128}};
+	ref << std::string{"tee"} << std::uint32_t{0xDEADBEEF};
+	ref.write_array_header(2);
+	ref << 3 << 2;
+	ref.write_blob(util::shared_buffer{"spliced"});
+	auto ref_buf  = ref.get_buffer();
+	auto expected = ref_buf.data();
+	auto ref_size = ref_buf.size();
+
+	CHECK(os.get_sink().size() == ref_size);
+	CHECK(log.size() == ref_size);
+	CHECK(std::equal(log.get_buffer_ref().data(), log.get_buffer_ref().data() + ref_size, expected));
+
+	auto flatten = [](bufseq::sink& snk) {
+		std::vector<util::byte_type> bytes;
+		for (auto const& buf : snk.get_buffers())
+		{
+			bytes.insert(bytes.end(), buf.data(), buf.data() + buf.size());
+		}
+		return bytes;
+	};
+	auto replayed = flatten(replay);
+	CHECK(replayed.size() == ref_size);
+	CHECK(std::equal(replayed.begin(), replayed.end(), expected));
+
+	auto peered = flatten(peer);
+	CHECK(peered.size() == ref_size + 2);
+	CHECK(peered[0] == 0xAA);
+	CHECK(peered[1] == 0xBB);
+	CHECK(std::equal(peered.begin() + 2, peered.end(), expected));
+
+	// a target added later starts at its own position
+	bufseq::sink late{16};
+	auto&        tee = static_cast<tee::sink&>(os.get_sink());
+	tee.add_target(late);
+	CHECK(tee.target_count() == 4);
+	os.put(0x7F);
+	os.get_sink().flush();
+	CHECK(late.size() == 1);
+	CHECK(flatten(late)[0] == 0x7F);
+	CHECK(log.size() == ref_size + 1);
+}
+
+TEST_CASE("bstream::obstream [ smoke ] { checkpoint and rollback }")
+{
+	ombstream ref{util::size_type{64}};
+	ref << std::string{"kept"} << std::string{"after"};
+	auto expected = ref.get_buffer();
+
+	{
+		ombstream os{util::size_type{8}};
+		os << std::string{"kept"};
+		auto cp = os.checkpoint();
+		CHECK(cp.size == os.size());
+		os << std::string{"a record that fails halfway"} << 3.5;
+		os.rollback(cp);
+		CHECK(os.size() == cp.size);
+		CHECK(os.position() == cp.position);
+		os << std::string{"after"};
+		CHECK(os.get_buffer() == expected);
+	}
+	{
+		// rolls back across segments, including a spliced one
+		obstream os{std::make_unique<bufseq::sink>(16)};
+		auto&    snk = static_cast<bufseq::sink&>(os.get_sink());
+		os << std::string{"kept"};
+		auto cp = os.checkpoint();
+		os << std::string{"a record long enough to span segments"};
+		snk.splice(util::shared_buffer{"spliced"});
+		os << 7;
+		os.rollback(cp);
+		os << std::string{"after"};
+
+		auto& bufs = snk.get_buffers();
+		CHECK(bufs.size() == 1);
+		CHECK(MATCH_BUFFER(bufs[0], expected.data()));
+		CHECK(snk.size() == expected.size());
+	}
+	{
+		// a checkpoint taken after seeking back restores the size and the position
+		ombstream os{util::size_type{32}};
+		os << std::string{"kept"} << std::string{"after"};
+		os.position(0);
+		auto cp = os.checkpoint();
+		os << std::string{"overwritten?"};
+		os.rollback(cp);
+		CHECK(os.position() == 0);
+		CHECK(os.size() == expected.size());
+	}
+
+	obstream::ptr_deduper deduper;
+	auto                  a = std::make_shared<int>(1);
+	auto                  b = std::make_shared<int>(2);
+	deduper.save_ptr(a, 1);
+	auto count = deduper.size();
+	deduper.save_ptr(b, 1);
+	CHECK(deduper.size() == 2);
+	deduper.rollback(count);
+	obstream::saved_ptr_info info;
+	CHECK(deduper.size() == 1);
+	CHECK(deduper.is_saved(a, info));
+	CHECK(!deduper.is_saved(b, info));
+	deduper.save_ptr(b, 1);
+	CHECK(deduper.is_saved(b, info));
+	CHECK(info.second == 1);
+
+	// nested checkpoints, rolled back innermost first, then to the start
+	auto c = std::make_shared<int>(3);
+	auto inner = deduper.size();
+	deduper.save_ptr(c, 2);
+	deduper.rollback(inner);
+	CHECK(!deduper.is_saved(c, info));
+	CHECK(deduper.is_saved(b, info));
+	deduper.rollback(0);
+	CHECK(deduper.size() == 0);
+	CHECK(!deduper.is_saved(a, info));
+	CHECK(!deduper.is_saved(b, info));
+	deduper.save_ptr(c, 2);
+	CHECK(deduper.is_saved(c, info));
+	CHECK(info == obstream::saved_ptr_info{2, 0});
+}
+
 TEST_CASE("bstream::buffer::source [ smoke ] { basic functionality }")
 {
 	util::byte_type data[] = {
@@ -311,4 +628,539 @@ TEST_CASE("bstream::buffer::source [ smoke ] { basic functionality }")
 	CHECK(is_there == 0x2f);
 	CHECK(probe.pos() == 32);
 	CHECK(src.position() == 32);
-}
\ No newline at end of file
+}
+TEST_CASE("bstream::basic_obstream [ smoke ] { buffer::sink with memory policy }")
+{
+	util::byte_type data[] = {
+			0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04,
+	};
+
+	using stream_type = basic_obstream<buffer::sink>;
+	static_assert(std::is_same<stream_type::policy_type, memory_sink_policy>::value, "unexpected default policy");
+
+	stream_type os{get_default_context(), util::size_type{8}};
+	buffer::detail::sink_test_probe probe{os.get_sink()};
+
+	CHECK(os.get_sink().eager_jumps());
+
+	std::error_code err;
+	os.put(0xff).put(0xff, err);
+	CHECK(!err);
+	os.putn(data, 2);
+	CHECK(os.position() == 4);
+
+	os.position(8, err);
+	CHECK(!err);
+	CHECK(!probe.did_jump());
+	CHECK(os.size() == 4);    // the gap isn't output until something is written past it
+	CHECK(os.position() == 8);
+
+	os.put_num(std::uint32_t{0x01020304});
+	CHECK(os.size() == 12);
+	CHECK(MATCH_BUFFER(probe.buffer(), data));
+
+	auto snk = os.release_sink();
+	CHECK(!snk->eager_jumps());
+}
+
+TEST_CASE("bstream::basic_obstream [ smoke ] { eager jumps match deferred jumps }")
+{
+	// writes the same jumps through a sink with and without eager jumps
+	auto check = [](obstream& deferred, obstream& eager, auto&& bytes) {
+		CHECK(!deferred.get_sink().eager_jumps());
+		CHECK(eager.get_sink().eager_jumps());
+		for (auto* os : {&deferred, &eager})
+		{
+			os->position(100);
+			CHECK(os->size() == 0);
+			os->position(1);
+			os->put(0x01);
+		}
+		CHECK(deferred.size() == 2);
+		CHECK(eager.size() == 2);
+
+		for (auto* os : {&deferred, &eager})
+		{
+			os->position(100);
+			os->put(0x02);
+			os->position(50);
+			CHECK(os->size() == 101);
+			os->position(200);
+			CHECK(os->size() == 101);
+		}
+		auto out_deferred = bytes(deferred);
+		auto out_eager    = bytes(eager);
+		REQUIRE(out_deferred.size() == 101);
+		CHECK(out_eager == out_deferred);
+		CHECK(out_deferred[1] == 0x01);
+		CHECK(out_deferred[50] == 0x00);
+		CHECK(out_deferred[100] == 0x02);
+
+		// a write past the gap that needs more storage keeps the gap zero-filled
+		util::byte_type data[300];
+		std::fill(std::begin(data), std::end(data), 0x03);
+		for (auto* os : {&deferred, &eager})
+		{
+			os->position(400);
+			os->putn(data, sizeof(data));
+			CHECK(os->size() == 700);
+		}
+		out_deferred = bytes(deferred);
+		out_eager    = bytes(eager);
+		REQUIRE(out_deferred.size() == 700);
+		CHECK(out_eager == out_deferred);
+		CHECK(out_deferred[399] == 0x00);
+		CHECK(out_deferred[400] == 0x03);
+	};
+
+	{
+		ombstream                     deferred{util::size_type{16}};
+		basic_obstream<buffer::sink> eager{get_default_context(), util::size_type{16}};
+		check(deferred, eager, [](obstream& os) {
+			auto buf = static_cast<buffer::sink&>(os.get_sink()).get_buffer();
+			return std::vector<util::byte_type>(buf.data(), buf.data() + buf.size());
+		});
+	}
+	{
+		obstream                      deferred{std::make_unique<bufseq::sink>(8, 32)};
+		basic_obstream<bufseq::sink> eager{get_default_context(), util::size_type{8}, util::size_type{32}};
+		check(deferred, eager, [](obstream& os) {
+			std::vector<util::byte_type> out;
+			for (auto& buf : static_cast<bufseq::sink&>(os.get_sink()).get_buffers())
+			{
+				out.insert(out.end(), buf.data(), buf.data() + buf.size());
+			}
+			return out;
+		});
+	}
+	{
+		std::string                                     deferred_str;
+		std::string                                     eager_str;
+		obstream                                        deferred{std::make_unique<container::sink<std::string>>(deferred_str)};
+		basic_obstream<container::sink<std::string>> eager{get_default_context(), eager_str};
+		check(deferred, eager, [](obstream& os) {
+			auto& str = static_cast<container::sink<std::string>&>(os.get_sink()).get_container();
+			return std::vector<util::byte_type>(str.begin(), str.end());
+		});
+	}
+}
+
+TEST_CASE("bstream::basic_ibstream [ smoke ] { round trip through serializers }")
+{
+	basic_obstream<buffer::sink> os{get_default_context(), util::size_type{4}};
+	os << std::string{"zoot"} << 42 << 3.5;
+	os.put_num(std::uint16_t{0xbeef});
+
+	basic_ibstream<buffer::source<util::const_buffer>> is{get_default_context(), os.get_sink().get_buffer()};
+
+	CHECK(is.read_as<std::string>() == "zoot");
+	CHECK(is.read_as<int>() == 42);
+	CHECK(is.read_as<double>() == 3.5);
+	CHECK(is.get_num<std::uint16_t>() == 0xbeef);
+
+	std::error_code err;
+	is.get(err);
+	CHECK(err == bstream::errc::read_past_end_of_stream);
+}
+
+TEST_CASE("bstream::basic_obstream [ smoke ] { serializers match obstream }")
+{
+	using stream_type = basic_obstream<buffer::sink>;
+	static_assert(
+			std::is_same<decltype(std::declval<stream_type&>() << 1 << std::string{}), stream_type&>::value,
+			"insertion into basic_obstream should keep the stream type");
+
+	util::const_buffer blob{"blob", 4};
+
+	auto write = [&](auto& os) {
+		os.write_array_header(6);
+		os << std::uint8_t{0x7f} << std::uint16_t{0x1234} << -70000 << std::uint64_t{0x0102030405060708};
+		os << 2.5f << -0.25;
+		os << std::string{"short"} << std::string(40, 'm') << std::string(300, 'l');
+		os << std::vector<std::int16_t>(20, -300) << std::make_tuple(true, std::string{"tup"}, 7u);
+		os.write_map_header(16);
+		os << static_cast<util::buffer const&>(blob);
+	};
+
+	ombstream expected{util::size_type{4}};
+	write(expected);
+
+	stream_type os{get_default_context(), util::size_type{4}};
+	write(os);
+	CHECK(os.get_sink().get_buffer() == expected.get_buffer());
+
+	basic_obstream<buffer::sink, checked_sink_policy> checked{get_default_context(), util::size_type{4}};
+	write(checked);
+	CHECK(checked.get_sink().get_buffer() == expected.get_buffer());
+}
+
+TEST_CASE("bstream::basic_obstream [ smoke ] { fixed byte order }")
+{
+	util::byte_type expected[] = {
+			0x04, 0x03, 0x02, 0x01, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x02, 0x01,
+	};
+
+	using le_order = fixed_byte_order<byte_order::little_endian>;
+
+	basic_obstream<buffer::sink, memory_sink_policy, le_order> os{get_default_context(), util::size_type{4}};
+	os.put_num(std::uint32_t{0x01020304});
+	os.put_num(std::uint64_t{0x0102030405060708});
+	os.get_sink().put_num(std::int16_t{0x0102});
+
+	auto buf = os.get_sink().get_buffer();
+	CHECK(MATCH_BUFFER(buf, expected));
+
+	basic_ibstream<buffer::source<util::const_buffer>, le_order> is{get_default_context(), buf};
+	CHECK(is.get_num<std::uint32_t>() == 0x01020304);
+	CHECK(is.get_num<std::uint64_t>() == 0x0102030405060708);
+	CHECK(is.get_source().get_num<std::int16_t>() == 0x0102);
+
+	util::byte_type big_expected[] = {
+			0x40, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+	};
+
+	buffer::sink big{util::size_type{4}, byte_order::big_endian};
+	big.put_num(3.25);
+	big.put_num(std::int64_t{-2});
+	auto big_buf = big.get_buffer();
+	CHECK(MATCH_BUFFER(big_buf, big_expected));
+
+	buffer::source<util::const_buffer> big_src{big_buf, byte_order::big_endian};
+	CHECK(big_src.get_num<double>() == 3.25);
+	CHECK(big_src.get_num<std::int64_t>() == -2);
+}
+
+TEST_CASE("bstream::basic_obstream [ smoke ] { native byte order round trip }")
+{
+	using native_order = fixed_byte_order<native_byte_order>;
+	using ostream_type = basic_obstream<buffer::sink, memory_sink_policy, native_order>;
+	using istream_type = basic_ibstream<buffer::source<util::const_buffer>, native_order>;
+
+	auto write = [](auto& os) {
+		os << std::uint16_t{0x1234} << -70000 << std::uint64_t{0x0102030405060708} << 2.5f << -0.25;
+		os << std::string(300, 's') << std::vector<std::int32_t>(20, -100000);
+		os.write_map_header(0x1234);
+		os.put_num(std::uint32_t{0x01020304});
+	};
+
+	ostream_type os{get_default_context(), util::size_type{4}};
+	write(os);
+
+	basic_obstream<buffer::sink> expected{get_default_context(), util::size_type{4}, native_byte_order};
+	write(expected);
+
+	auto buf = os.get_sink().get_buffer();
+	CHECK(buf == expected.get_sink().get_buffer());
+
+	std::uint32_t last = 0x01020304;
+	CHECK(::memcmp(buf.data() + buf.size() - sizeof(last), &last, sizeof(last)) == 0);
+
+	istream_type is{get_default_context(), buf};
+	static_assert(
+			std::is_same<decltype(is >> std::declval<int&>()), istream_type&>::value,
+			"extraction from basic_ibstream should keep the stream type");
+
+	std::uint16_t u16 = 0;
+	int           i32 = 0;
+	is >> u16 >> i32;
+	CHECK(u16 == 0x1234);
+	CHECK(i32 == -70000);
+	CHECK(is.read_as<std::uint64_t>() == 0x0102030405060708);
+	CHECK(is.read_as<float>() == 2.5f);
+	CHECK(is.read_as<double>() == -0.25);
+	CHECK(is.read_as<std::string>() == std::string(300, 's'));
+	CHECK(is.read_as<std::vector<std::int32_t>>() == std::vector<std::int32_t>(20, -100000));
+	CHECK(is.read_map_header() == 0x1234);
+	CHECK(is.get_num<std::uint32_t>() == 0x01020304);
+
+	std::error_code err;
+	is.get(err);
+	CHECK(err == bstream::errc::read_past_end_of_stream);
+}
+
+TEST_CASE("bstream::serialized_size [ smoke ] { matches serialized output }")
+{
+	using namespace serialized_size_types;
+
+	auto check = [](auto const& obj) {
+		ombstream os{util::size_type{4}};
+		os << obj;
+		CHECK(serialized_size(obj) == os.get_buffer().size());
+	};
+
+	check(std::uint8_t{7});
+	check(std::uint64_t{0x0102030405060708});
+	check(std::int32_t{-40000});
+	check(2.5f);
+	check(true);
+	check(std::string{});
+	check(std::string(40, 'x'));
+	check(std::string(70000, 'y'));
+	check(std::vector<int>(20, -1));
+	check(std::make_pair(std::int16_t{-3}, std::string{"pair"}));
+	check(point{1, -70000, 0.5});
+	check(tagged_point{point{1, 2, 3.0}, 300, true});
+	check(labeled_point{point{-1, 2, 3.0}, std::string(300, 'z')});
+
+	std::vector<std::uint32_t> big(5000, 0xffffffffu);
+	CHECK(serialized_size(big) == 3 + big.size() * 5);
+
+	// presize exactly, then serialize without the buffer growing
+	labeled_point lp{point{4, 5, 6.0}, "label"};
+	auto          n = serialized_size(lp);
+	ombstream     os{n};
+	os << lp;
+	auto buf = os.get_buffer();
+	CHECK(buf.size() == n);
+	CHECK(os.get_sink().get_buffer_ref().capacity() == n);
+}
+
+TEST_CASE("bstream::null::sink [ smoke ] { positioning }")
+{
+	null::sink snk;
+	util::byte_type bytes[3000] = {};
+	snk.putn(bytes, sizeof(bytes));
+	CHECK(snk.size() == 3000);
+
+	// a write larger than the scratch area is counted, not copied
+	detail::sink_test_probe probe{snk};
+	CHECK(probe.next() == probe.base());
+	snk.put(1);
+	snk.putn(bytes, sizeof(bytes));
+	CHECK(probe.next() == probe.base());
+	CHECK(snk.size() == 6001);
+	CHECK(snk.position() == 6001);
+	snk.truncate(3000);
+	CHECK(snk.size() == 3000);
+	snk.position(10);
+	snk.put(1);
+	CHECK(snk.size() == 3000);
+	snk.position(5000);
+	CHECK(snk.size() == 3000);
+	snk.put(1);
+	CHECK(snk.size() == 5001);
+	snk.position(9000);
+	CHECK(snk.position() == 9000);
+	snk.flush();
+	CHECK(snk.size() == 5001);
+	snk.clear();
+	CHECK(snk.size() == 0);
+
+	// with eager jumps, as through serialized_size(), sizes are the same
+	basic_obstream<null::sink> os{get_default_context()};
+	CHECK(os.get_sink().eager_jumps());
+	os.putn(bytes, sizeof(bytes));
+	os.position(5000);
+	CHECK(os.size() == 3000);
+	os.position(10);
+	os.put(1);
+	CHECK(os.size() == 3000);
+	os.position(5000);
+	os.put(1);
+	CHECK(os.size() == 5001);
+}
+
+TEST_CASE("bstream::max_serialized_size [ smoke ] { fixed-shape types }")
+{
+	using namespace serialized_size_types;
+
+	static_assert(max_serialized_size<bool>() == 1);
+	static_assert(max_serialized_size<std::int8_t>() == 2);
+	static_assert(max_serialized_size<std::uint16_t>() == 3);
+	static_assert(max_serialized_size<std::int64_t>() == 9);
+	static_assert(max_serialized_size<float>() == 5);
+	static_assert(max_serialized_size<double>() == 9);
+	static_assert(max_serialized_size<std::pair<std::uint8_t, double>>() == 1 + 2 + 9);
+	static_assert(max_serialized_size<std::tuple<bool, std::uint32_t, float>>() == 1 + 1 + 5 + 5);
+	static_assert(max_serialized_size<point>() == 1 + 5 + 5 + 9);
+	static_assert(max_serialized_size<tagged_point>() == 1 + (1 + 5 + 5 + 9) + 3 + 1);
+
+	static_assert(!has_max_serialized_size<std::string>::value);
+	static_assert(!has_max_serialized_size<std::vector<int>>::value);
+	static_assert(!has_max_serialized_size<std::pair<int, std::string>>::value);
+	static_assert(!has_max_serialized_size<labeled_point>::value);
+	static_assert(!has_max_serialized_size<unstreamed_point>::value);
+
+	point        p{-70000, 70000, 1.0};
+	tagged_point tp{p, 0xffff, false};
+	CHECK(serialized_size(p) == max_serialized_size<point>());
+	CHECK(serialized_size(tp) == max_serialized_size<tagged_point>());
+	CHECK(serialized_size(std::make_tuple(false, 0xffffffffu, 1.0f))
+		  == max_serialized_size<std::tuple<bool, std::uint32_t, float>>());
+}
+
+TEST_CASE("bstream::fixed_obstream [ smoke ] { encode and decode in place }")
+{
+	using namespace serialized_size_types;
+
+	fixed_obstream<64> os;
+	os << point{1, -70000, 0.5} << std::string{"tag"} << std::uint16_t{300};
+	CHECK(os.size() == serialized_size(point{1, -70000, 0.5}) + 4 + 3);
+
+	span_ibstream is{os.data(), os.size()};
+	is.check_array_header(3);
+	CHECK(is.read_as<std::int32_t>() == 1);
+	CHECK(is.read_as<std::int32_t>() == -70000);
+	CHECK(is.read_as<double>() == 0.5);
+	CHECK(is.read_as<std::string>() == "tag");
+	CHECK(is.read_as<std::uint16_t>() == 300);
+	CHECK(is.position() == static_cast<util::position_type>(os.size()));
+
+	os.clear();
+	CHECK(os.size() == 0);
+	os << true;
+	CHECK(os.size() == 1);
+	CHECK(os.data()[0] == typecode::bool_true);
+}
+
+TEST_CASE("bstream::fixed_obstream [ smoke ] { overflow }")
+{
+	fixed_obstream<8> os;
+	util::byte_type   bytes[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+	std::error_code err;
+	os.putn(bytes, 6, err);
+	CHECK(!err);
+	os.put_num(std::uint32_t{1}, err);
+	CHECK(err == std::errc::no_buffer_space);
+	CHECK_THROWS_AS(os << std::string(20, 'x'), std::system_error);
+
+	os.clear();
+	os.putn(bytes, 8, err);
+	CHECK(!err);
+	CHECK(os.size() == 8);
+	os.put(9, err);
+	CHECK(err == std::errc::no_buffer_space);
+	os.position(9, err);
+	CHECK(err == std::errc::invalid_argument);
+
+	inline_sink<4> snk;
+	snk.put_num(std::uint32_t{0x01020304});
+	CHECK(snk.size() == 4);
+	CHECK(snk.data()[0] == 0x01);
+	CHECK_THROWS_AS(snk.put(5), std::system_error);
+}
+
+TEST_CASE("bstream::fixed_obstream [ smoke ] { writes that exactly fill the buffer }")
+{
+	std::error_code err;
+
+	// 200 encodes as uint8 typecode + 1 byte, 1 as a positive fixint
+	fixed_obstream<4> os;
+	os << 200u << 1 << false;
+	CHECK(os.size() == 4);
+	os.put(0, err);
+	CHECK(err == std::errc::no_buffer_space);
+
+	// "abc" encodes as a fixstr typecode + 3 bytes
+	os.clear();
+	os << std::string{"abc"};
+	CHECK(os.size() == 4);
+	CHECK(os.data()[0] == 0xa3);
+	CHECK_THROWS_AS(os << 0, std::system_error);
+
+	// -1000 encodes as int16 typecode + 2 bytes, a short array header as 1 byte
+	fixed_obstream<4> hdr;
+	hdr.write_array_header(3);
+	hdr << std::int16_t{-1000};
+	CHECK(hdr.size() == 4);
+	span_ibstream is{hdr.data(), hdr.size()};
+	is.check_array_header(3);
+	CHECK(is.read_as<std::int16_t>() == -1000);
+	CHECK_THROWS_AS(hdr << true, std::system_error);
+
+	inline_sink<4> snk;
+	util::byte_type bytes[4] = {1, 2, 3, 4};
+	snk.putn(bytes, 2);
+	snk.put_num(std::uint16_t{0x0506});
+	CHECK(snk.size() == 4);
+	snk.put(7, err);
+	CHECK(err == std::errc::no_buffer_space);
+}
+
+TEST_CASE("bstream::inline_sink [ smoke ] { reserve never allocates }")
+{
+	inline_sink<16> snk;
+	util::byte_type bytes[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+	snk.putn(bytes, sizeof(bytes));
+
+	// the only storage reserve() could allocate is the scratch window
+	detail::sink_test_probe probe{snk};
+	std::error_code         err;
+
+	// a window that doesn't fit fails without building a scratch window
+	auto window = snk.reserve(9, err);
+	CHECK(err == std::errc::no_buffer_space);
+	CHECK(window == nullptr);
+	CHECK(snk.size() == sizeof(bytes));
+	CHECK(probe.scratch_window_capacity() == 0);
+
+	// one that fits is still handed out in place
+	window = snk.reserve(4, err);
+	CHECK(!err);
+	REQUIRE(window != nullptr);
+	::memcpy(window, bytes, 4);
+	snk.commit(4, err);
+	CHECK(!err);
+	CHECK(snk.size() == 16);
+	CHECK(probe.scratch_window_capacity() == 0);
+}
+
+TEST_CASE("bstream::container::sink [ smoke ] { vector and string storage }")
+{
+	std::vector<std::uint8_t> vec;
+	{
+		basic_obstream<container::sink<std::vector<std::uint8_t>>> os{get_default_context(), vec};
+		os << std::string(100, 'a') << std::uint32_t{0xdeadbeef};
+		auto& out = os.get_sink().get_container();
+		CHECK(&out == &vec);
+		CHECK(vec.size() == 2 + 100 + 5);
+		os << std::int8_t{-100};
+	}
+	CHECK(vec.size() == 2 + 100 + 5 + 2);
+
+	span_ibstream is{vec};
+	CHECK(is.read_as<std::string>() == std::string(100, 'a'));
+	CHECK(is.read_as<std::uint32_t>() == 0xdeadbeef);
+	CHECK(is.read_as<std::int8_t>() == -100);
+
+	// output is appended after existing contents; positions are relative to the original end
+	std::string str{"prefix"};
+	{
+		container::sink<std::string> snk{str};
+		util::byte_type bytes[] = {'0', '1', '2', '3'};
+		snk.putn(bytes, sizeof(bytes));
+		snk.position(2);
+		snk.put('x');
+		snk.position(6);
+		snk.put('!');
+		CHECK(snk.size() == 7);
+	}
+	CHECK(str == std::string("prefix01x3\0\0!", 13));
+
+	std::string text;
+	obstream os{std::make_unique<container::sink<std::string>>(text)};
+	for (auto i = 0; i < 1000; ++i)
+	{
+		os << i;
+	}
+	auto& snk = static_cast<container::sink<std::string>&>(os.get_sink());
+	CHECK(snk.get_container().size() == 128 * 1 + 128 * 2 + 744 * 3);
+	CHECK(text.size() == os.size());
+
+	// flush() leaves the container at exactly the bytes written, slack included
+	os << std::string(50, 'b');
+	CHECK(text.size() > os.size());
+	snk.flush();
+	CHECK(text.size() == 128 * 1 + 128 * 2 + 744 * 3 + 2 + 50);
+	CHECK(text.size() == os.size());
+
+	// including after seeking back into the output
+	os.position(10);
+	os << 7;
+	snk.flush();
+	CHECK(text.size() == os.size());
+	CHECK(text[10] == 7);
+	os << 8;
+	CHECK(text[11] == 8);
+}
@@ -145,6 +145,18 @@ public:
 		return m_target.m_end;
 	}
 
+	util::size_type
+	scratch_window_size()
+	{
+		return m_target.m_window.size();
+	}
+
+	util::size_type
+	scratch_window_capacity()
+	{
+		return m_target.m_window.capacity();
+	}
+
 private:
 	bstream::sink& m_target;
 };
@@ -64,7 +64,7 @@ public:
 	util::mutable_buffer&
 	buffer()
 	{
-		return m_target.m_buf;
+		return m_target.get_buffer_ref();
 	}
 
 private:
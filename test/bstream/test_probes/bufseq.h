@@ -73,6 +73,12 @@ public:
 		return m_target.m_current;
 	}
 
+	util::size_type
+	segment_count() const
+	{
+		return m_target.m_bufs.size();
+	}
+
 private:
 	bufseq::sink& m_target;
 };